@@ -2,12 +2,26 @@
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#include <stdint.h>
+#include <float.h>
+#include <locale.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define PI		3.14159265359
 #define HALF_PI		1.57079632679
 #define THREE_HALF_PI	4.57079632679
 #define E 		2.71828182846
 
+#define RMAT_ALIGN	64	// Alignment (bytes) of matrix elements.
+
+// Defined in sections 1.10 and 3.
+char *file_path( char filename[] );
+int txt_out( int n, int m, double **A, double *V, int sci, char filename[] );
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	1. ALLOCATION OF MATRICES AND VECTORS
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -18,7 +32,7 @@
    vector.
 */
 int alloc_rvec( int n, double **V ) {
-	*V = ( double* ) malloc( n * sizeof( float ) );
+	*V = ( double* ) malloc( n * sizeof( double ) );
 
 	if( *V == NULL ) {
 	  return( -1 );
@@ -37,40 +51,75 @@ int free_rvec( double **V ) {
 //	1.2. ALLOCATING AND DELETING A 'double' MATRIX
 //=====================================================
 /* This function allocates dynamically a 'double' matrix of n rows
-   and m collumns.
+   and m collumns. The row pointers and the elements are set in one
+   single memory block, so the elements are contiguous, in row-major
+   order, and A[i][j] is the same as A[0][i * m + j]. The first
+   element is aligned to a RMAT_ALIGN-byte boundary.
 */
 int alloc_rmat( int n, int m, double ***A ) {
-	int i;
-	
-	*A = ( double** ) malloc( n * sizeof( float* ) );
+	int    i;
+	size_t head;
+	char   *block;
+	double *val;
 
-	if( *A == NULL ) {
+	head = n * sizeof( double* ) + RMAT_ALIGN;
+	block = ( char* ) malloc( head + ( size_t ) n * m * sizeof( double ) );
+
+	if( block == NULL ) {
+	  *A = NULL;
 	  return( -1 );
 	}
 
+	*A = ( double** ) block;
+	val = ( double* ) ( ( ( uintptr_t ) ( block + n * sizeof( double* ) )
+	      + RMAT_ALIGN - 1 ) & ~( uintptr_t ) ( RMAT_ALIGN - 1 ) );
 	for( i = 0; i < n; i++ ) {
-	  ( *A )[i] = ( double* ) malloc( m * sizeof( float ) );
-
-	  if( ( *A )[i] == NULL ) {
-	    return( -1 );
-	  }
+	  ( *A )[i] = val + ( size_t ) i * m;
 	}
 	return( 0 );
 }
-/* This function sets free a n-row 'double' matrix.
+/* This function sets free a n-row 'double' matrix. Since the rows
+   and the elements of a matrix allocated by alloc_rmat share the
+   same memory block, n is kept only for compatibility. It also sets
+   free the row pointers of a sub-matrix view (see sub_rmat).
 */
 int free_rmat( int n, double ***A ) {
-	int i;
-
-	for( i = 0; i < n; i++ ) {
-	  free( ( *A )[i] );
-	  ( *A )[i] = NULL;
-	}
+	( void ) n;
 	free( *A );
 	*A = NULL;
 
 	return( 0 );
 }
+/* This function allocates dynamically the lower triangle of a n-X-n
+   'double' matrix in packed storage: row i has only the i + 1
+   elements A[i][0], ..., A[i][i], which are contiguous with the next
+   row. It takes about half of the memory of alloc_rmat, and it is set
+   free by free_rmat. Only routines which read and write the lower
+   triangle alone (e.g. chol_rmat) may receive such a matrix.
+*/
+int alloc_prmat( int n, double ***A ) {
+	int    i;
+	size_t head;
+	char   *block;
+	double *val;
+
+	head = n * sizeof( double* ) + RMAT_ALIGN;
+	block = ( char* ) malloc( head + ( size_t ) n * ( n + 1 ) / 2
+	                                 * sizeof( double ) );
+
+	if( block == NULL ) {
+	  *A = NULL;
+	  return( -1 );
+	}
+
+	*A = ( double** ) block;
+	val = ( double* ) ( ( ( uintptr_t ) ( block + n * sizeof( double* ) )
+	      + RMAT_ALIGN - 1 ) & ~( uintptr_t ) ( RMAT_ALIGN - 1 ) );
+	for( i = 0; i < n; i++ ) {
+	  ( *A )[i] = val + ( size_t ) i * ( i + 1 ) / 2;
+	}
+	return( 0 );
+}
 //=====================================================
 //	1.3. ALLOCATING AND DELETING A 'char' VECTOR
 //=====================================================
@@ -136,20 +185,21 @@ int free_chmat( int n, char ***A ) {
 //=============================================================
 /* This functions gets 'double' values from a file and commits them
    to a single n-dimensional vector V. That file must be inside a
-   folder named "files" and its name with the format extension must
-   not be longer than fourty characters.
+   folder named "files".
 */
 int get_rvec( int n, double *V, char filename[] ) {
 	FILE *file;
 	int  i;
 	char *AUX;
 
-	alloc_chvec( 46, &AUX );
-	strcpy( AUX, "files/" );
-	strcat( AUX, filename );
+	AUX = file_path( filename );
+	if( AUX == NULL ) {
+	  return( -1 );
+	}
 
 	file = fopen( AUX, "r" );
 	if ( file == NULL ) {
+	  free_chvec( &AUX );
 	  return( -1 );
 	}
 	else {
@@ -164,25 +214,26 @@ int get_rvec( int n, double *V, char filename[] ) {
 }
 /* This functions gets 'double' values in scientific notation from
    a file and commits them to a single n-dimensional vector V. That
-   file must be inside a folder named "files" and its name with the
-   format extension must not be longer than fourty characters.
+   file must be inside a folder named "files".
 */
 int sci_get_rvec( int n, double *V, char filename[] ) {
 	FILE *file;
 	int  i;
 	char *AUX;
 
-	alloc_chvec( 46, &AUX );
-	strcpy( AUX, "files/" );
-	strcat( AUX, filename );
+	AUX = file_path( filename );
+	if( AUX == NULL ) {
+	  return( -1 );
+	}
 
 	file = fopen( AUX, "r" );
 	if ( file == NULL ) {
+	  free_chvec( &AUX );
 	  return( -1 );
 	}
 	else {
 	  for( i = 0; i < n; i++ ) {
-	    fscanf( file, "%e\n", &V[i] );
+	    fscanf( file, "%le\n", &V[i] );
 	  }
 	}
 	fclose( file );
@@ -194,81 +245,42 @@ int sci_get_rvec( int n, double *V, char filename[] ) {
 //	1.5. WRITING 'double' COORDINATES OF A VECTOR IN A FILE
 //==============================================================
 /* This functions writes the coordinates of a n-dimensional 'double'
-   vector in a file. That file will be created inside a folder named
-   "files" and its name with the format extension must not be longer
-   than fourty characters.
+   vector in a file, one per line, each with the fewest digits which
+   are read back as the same number (see txt_out). That file will be
+   created inside a folder named "files".
 */
 int out_rvec( int n, double *V, char filename[] ) {
-	FILE *file;
-	int  i;
-	char *AUX;
-
-	alloc_chvec( 46, &AUX );
-	strcpy( AUX, "files/" );
-	strcat( AUX, filename );
-
-	file = fopen( AUX, "w" );
-	if ( file == NULL ) {
-	  return( -1 );
-	}
-	else {
-	  for( i = 0; i < n; i++ ) {
-	    fprintf( file, "%.16lf\n", V[i] );
-	  }
-	}
-	fclose( file );
-	free_chvec( &AUX );
-
-	return( 0 );
+	return( txt_out( n, 1, NULL, V, 0, filename ) );
 }
 /* This functions writes the coordinates of a n-dimensional 'double'
    vector in a file. The 'double' elements will be expressed in
-   scientific notation. That file will be created inside a folder
-   named "files" and its name with the format extension must not be
-   longer than fourty characters.
+   scientific notation, with the fewest digits which are read back as
+   the same number. That file will be created inside a folder named
+   "files".
 */
 int sci_out_rvec( int n, double *V, char filename[] ) {
-	FILE *file;
-	int  i;
-	char *AUX;
-
-	alloc_chvec( 46, &AUX );
-	strcpy( AUX, "files/" );
-	strcat( AUX, filename );
-
-	file = fopen( AUX, "w" );
-	if ( file == NULL ) {
-	  return( -1 );
-	}
-	else {
-	  for( i = 0; i < n; i++ ) {
-	    fprintf( file, "%.16lf\n", V[i] );
-	  }
-	}
-	fclose( file );
-	free_chvec( &AUX );
-
-	return( 0 );
+	return( txt_out( n, 1, NULL, V, 1, filename ) );
 }
 //========================================================
 //	1.7. GETTING 'double' MATRIX ELEMENTS FROM A FILE
 //========================================================
 /* This functions gets 'double' values from a file and commits them
    to a n-row, m-column matrix A. That file must be inside a folder
-   named "files" and its name with the format extension must not be
-   longer than fourty characters.
+   named "files".
 */
 int get_rmat( int n, int m, double **A, char filename[] ) {
 	FILE *file;
 	int  i, j;
 	char *AUXC;
 
-	alloc_chvec( 46, &AUXC );
-	strcpy( AUXC, "files/" );
-	strcat( AUXC, filename );
+	AUXC = file_path( filename );
+	if( AUXC == NULL ) {
+	  return( -1 );
+	}
 
 	file = fopen( AUXC, "r" );
 	if ( file == NULL ) {
+	  free_chvec( &AUXC );
 	  return( -1 );
 	}
 	else {
@@ -295,35 +307,36 @@ int get_rmat( int n, int m, double **A, char filename[] ) {
 }
 /* This functions gets 'double' values in scientif notation from a
    file and commits them to a n-row, m-column matrix A. That file
-   must be inside a folder named "files" and its name with the format
-   extension must not be longer than fourty characters. Watch out the
-   numbers' size!
+   must be inside a folder named "files". Watch out the numbers'
+   size!
 */
 int sci_get_rmat( int n, int m, double **A, char filename[] ) {
 	FILE *file;
 	int  i, j;
 	char *AUXC;
 
-	alloc_chvec( 46, &AUXC );
-	strcpy( AUXC, "files/" );
-	strcat( AUXC, filename );
+	AUXC = file_path( filename );
+	if( AUXC == NULL ) {
+	  return( -1 );
+	}
 
 	file = fopen( AUXC, "r" );
 	if ( file == NULL ) {
+	  free_chvec( &AUXC );
 	  return( -1 );
 	}
 	else {
 	  for( i = 0; i < n; i++ ) {
 	    for( j = 0; j < m; j++ ) {
 	      if( j > 0 && j < m - 1 ) {
-	        fscanf( file, "\t%e", &A[i][j] );
+	        fscanf( file, "\t%le", &A[i][j] );
 	      }
 	      else {
 	        if( j == 0 ) {
-	          fscanf( file, "%e", &A[i][j] );
+	          fscanf( file, "%le", &A[i][j] );
 	        }
 	        else {
-	          fscanf( file, "\t%e\n", &A[i][j] );
+	          fscanf( file, "\t%le\n", &A[i][j] );
 	        }
 	      }
 	    }
@@ -338,86 +351,3029 @@ int sci_get_rmat( int n, int m, double **A, char filename[] ) {
 //	1.8. WRITING 'double' ELEMENTS OF A MATRIX IN A FILE
 //===========================================================
 /* This functions writes the elements of a n-row, m-column 'double'
-   matrix into a file. That file will be inside a folder named "files"
-   and its name with the format extension must not be longer than
-   fourty characters.
+   matrix into a file, each with the fewest digits which are read back
+   as the same number (see txt_out). That file will be inside a folder
+   named "files".
 */
 int out_rmat( int n, int m, double **A, char filename[] ) {
-	FILE *file;
-	int  i, j;
-	char *AUXC;
+	return( txt_out( n, m, A, NULL, 0, filename ) );
+}
+/* This functions writes the elements of a n-row, m-column 'double'
+   matrix into a file. The 'double' elements will be expressed in
+   scientific notation, with the fewest digits which are read back as
+   the same number. That file will be created inside a folder named
+   "files".
+*/
+int sci_out_rmat( int n, int m, double **A, char filename[] ) {
+	return( txt_out( n, m, A, NULL, 1, filename ) );
+}
+//=====================================================
+//	1.9. CONTIGUOUS 'double' MATRICES AND VIEWS
+//=====================================================
+/* This struct carries a row-major 'double' matrix together with its
+   dimensions. Element (i,j) is val[i * ld + j], where the leading
+   dimension ld is the distance between two consecutive rows. The
+   row pointers are kept in row, so every '*_rmat' routine accepts
+   a Rmat M by receiving M.row.
+*/
+typedef struct {
+	int    n, m;	// Number of rows and columns.
+	int    ld;	// Leading dimension (row stride).
+	int    own;	// 1 if the elements belong to it (see new_rmat).
+	double *val;	// First element.
+	double **row;	// Row pointers: row[i] = val + i * ld.
+} Rmat;
 
-	alloc_chvec( 46, &AUXC );
-	strcpy( AUXC, "files/" );
-	strcat( AUXC, filename );
+/* This function gives a n-row 'double' matrix V whose elements are
+   the ones of A starting at row i and column j, so V[r][c] is the
+   same memory as A[i + r][j + c]. No element is copied: only the n
+   row pointers are allocated, and they must be set free by
+   free_rmat.
+*/
+int sub_rmat( int i, int j, int n, double **A, double ***V ) {
+	int r;
 
-	file = fopen( AUXC, "w" );
-	if ( file == NULL ) {
+	*V = ( double** ) malloc( ( n > 0 ? n : 1 ) * sizeof( double* ) );
+
+	if( *V == NULL ) {
 	  return( -1 );
 	}
-	else {
-	  for( i = 0; i < n; i++ ) {
-	    for( j = 0; j < m; j++ ) {
-	      if( j > 0 && j < m - 1 ) {
-	        fprintf( file, "\t%.16lf", A[i][j] );
-	      }
-	      else {
-	        if( j == 0 ) {
-	          fprintf( file, "%.16lf", A[i][j] );
-		}
-	        else {
-	          fprintf( file, "\t%.16lf\n", A[i][j] );
-		}
-	      }
-	    }
-	  }
+	for( r = 0; r < n; r++ ) {
+	  ( *V )[r] = A[i + r] + j;
 	}
-	fclose( file );
-	free_chvec( &AUXC );
+	return( 0 );
+}
+/* This function allocates a contiguous n-X-m matrix A (ld = m). The
+   elements, aligned as in alloc_rmat, and the row pointers are two
+   memory blocks, so the row pointers can be reallocated when A is
+   transposed in place (see itrans_rmat).
+*/
+int new_rmat( int n, int m, Rmat *A ) {
+	int    i;
+	size_t size;
+
+	A->n = n;
+	A->m = m;
+	A->ld = m;
+	A->own = 1;
+
+	// aligned_alloc takes a multiple of the alignment.
+	size = ( ( size_t ) n * m * sizeof( double ) + RMAT_ALIGN - 1 )
+	       & ~( size_t ) ( RMAT_ALIGN - 1 );
+	A->val = ( double* ) aligned_alloc( RMAT_ALIGN, size > 0 ? size : RMAT_ALIGN );
+	A->row = ( double** ) malloc( ( n > 0 ? n : 1 ) * sizeof( double* ) );
 
+	if( A->val == NULL || A->row == NULL ) {
+	  free( A->val );
+	  free( A->row );
+	  A->val = NULL;
+	  A->row = NULL;
+	  return( -1 );
+	}
+	for( i = 0; i < n; i++ ) {
+	  A->row[i] = A->val + ( size_t ) i * m;
+	}
 	return( 0 );
 }
-/* This functions writes the elements of a n-row, m-column 'double'
-   matrix into a file. The 'double' elements will be expressed in
-   scientific notation. That file will be created inside a folder
-   named "files" and its name with the format extension must not be
-   longer than fourty characters. Watch out the numbers' size!
+/* This function makes V a zero-copy view of the n-X-m sub-matrix of A
+   whose first element is A(i,j). V keeps the leading dimension of A,
+   and writing into V writes into A. V must be deleted before A.
 */
-int sci_out_rmat( int n, int m, double **A, char filename[] ) {
-	FILE *file;
-	int  i, j;
-	char *AUXC;
+int view_rmat( Rmat *A, int i, int j, int n, int m, Rmat *V ) {
+	if( i < 0 || j < 0 || i + n > A->n || j + m > A->m ) {
+	  return( -1 );
+	}
 
-	alloc_chvec( 46, &AUXC );
-	strcpy( AUXC, "files/" );
-	strcat( AUXC, filename );
+	V->n = n;
+	V->m = m;
+	V->ld = A->ld;
+	V->own = 0;
+	V->val = A->val + ( size_t ) i * A->ld + j;
 
-	file = fopen( AUXC, "w" );
-	if ( file == NULL ) {
+	return( sub_rmat( i, j, n, A->row, &V->row ) );
+}
+/* This function deletes a matrix made by new_rmat or view_rmat. The
+   elements of a view are not set free.
+*/
+int del_rmat( Rmat *A ) {
+	if( A->own ) {
+	  free( A->val );
+	}
+	free( A->row );
+	A->row = NULL;
+	A->val = NULL;
+	A->n = A->m = A->ld = A->own = 0;
+
+	return( 0 );
+}
+//=====================================================
+//	1.10. BINARY MATRIX FILES
+//=====================================================
+/* A binary matrix file has a BIN_HEAD-byte header (Bin_head) and
+   then the elements of a n-X-m matrix, with no padding between rows.
+   The header records the element type and layout, the offset of the
+   first element (a multiple of its alignment) and the value
+   BIN_ENDIAN as written by the machine which made the file, so a file
+   from a machine of the other byte order is recognized.
+*/
+#define BIN_HEAD	64
+#define BIN_VERSION	1
+#define BIN_ENDIAN	0x01020304
+#define BIN_DOUBLE	1	// Element type: IEEE 754 'double'.
+#define BIN_ROWMAJOR	0	// Layout: row after row.
+
+typedef struct {
+	char     magic[8];	// "LILAMAT" and a null character.
+	uint32_t version;	// BIN_VERSION.
+	uint32_t endian;	// BIN_ENDIAN, in the byte order of the file.
+	uint32_t dtype;		// BIN_DOUBLE.
+	uint32_t layout;	// BIN_ROWMAJOR.
+	uint32_t align;		// Alignment (bytes) of offset.
+	uint32_t pad;
+	uint64_t n, m;		// Number of rows and columns.
+	uint64_t offset;	// Offset (bytes) of the first element.
+	uint64_t reserved;
+} Bin_head;
+
+/* This function returns the path of a file named filename inside the
+   folder "files", whatever the length of that name is. The path must
+   be set free by free_chvec.
+*/
+char *file_path( char filename[] ) {
+	char *path;
+
+	if( alloc_chvec( strlen( filename ) + 7, &path ) != 0 ) {
+	  return( NULL );
+	}
+	strcpy( path, "files/" );
+	strcat( path, filename );
+
+	return( path );
+}
+
+// Checks the header H of a file of size bytes; swap is set to 1 if
+// the file has the other byte order. It returns -1 if H is not valid,
+// e.g. if the elements would go past the end of the file (tested by
+// divisions, so n * m cannot wrap around).
+static int bin_check( Bin_head *H, size_t size, int *swap ) {
+	*swap = ( H->endian == __builtin_bswap32( BIN_ENDIAN ) );
+	if( *swap ) {
+	  H->version = __builtin_bswap32( H->version );
+	  H->dtype = __builtin_bswap32( H->dtype );
+	  H->layout = __builtin_bswap32( H->layout );
+	  H->align = __builtin_bswap32( H->align );
+	  H->n = __builtin_bswap64( H->n );
+	  H->m = __builtin_bswap64( H->m );
+	  H->offset = __builtin_bswap64( H->offset );
+	}
+	else if( H->endian != BIN_ENDIAN ) {
+	  return( -1 );
+	}
+	if( memcmp( H->magic, "LILAMAT", 8 ) != 0 || H->version != BIN_VERSION
+	    || H->dtype != BIN_DOUBLE || H->layout != BIN_ROWMAJOR
+	    || H->align == 0 || ( H->align & ( H->align - 1 ) ) != 0
+	    || H->offset % H->align != 0
+	    || H->offset < BIN_HEAD || H->offset > size
+	    || H->n > INT32_MAX || H->m > INT32_MAX
+	    || ( H->m != 0 && H->n > ( size - H->offset ) / sizeof( double ) / H->m ) ) {
+	  return( -1 );
+	}
+	return( 0 );
+}
+
+/* This function writes a n-X-m 'double' matrix A into a binary file
+   inside the folder "files". The rows are written straight from A:
+   in a single call if they are contiguous (e.g. A was made by
+   alloc_rmat), row after row otherwise.
+*/
+int bin_out_rmat( int n, int m, double **A, char filename[] ) {
+	FILE     *file;
+	int      i, flag;
+	size_t   row;
+	char     *path;
+	Bin_head H;
+
+	memset( &H, 0, sizeof( H ) );
+	memcpy( H.magic, "LILAMAT", 8 );
+	H.version = BIN_VERSION;
+	H.endian = BIN_ENDIAN;
+	H.dtype = BIN_DOUBLE;
+	H.layout = BIN_ROWMAJOR;
+	H.align = BIN_HEAD;
+	H.n = n;
+	H.m = m;
+	H.offset = BIN_HEAD;
+
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	file = fopen( path, "wb" );
+	free_chvec( &path );
+	if( file == NULL ) {
 	  return( -1 );
 	}
+
+	flag = ( fwrite( &H, sizeof( H ), 1, file ) == 1 ) ? 0 : -1;
+	row = ( size_t ) m;
+	i = 1;
+	while( i < n && A[i] == A[i - 1] + m ) { // Contiguous rows?
+	  i++;
+	}
+	if( i >= n && n > 0 ) {
+	  flag = ( fwrite( A[0], sizeof( double ), n * row, file ) == n * row ) ? flag : -1;
+	}
 	else {
-	  for( i = 0; i < n; i++ ) {
-	    for( j = 0; j < m; j++ ) {
-	      if( j > 0 && j < m - 1 ) {
-	        fprintf( file, "\t%.16e", A[i][j] );
-	      }
-	      else {
-	        if( j == 0 ) {
-	          fprintf( file, "%.16e", A[i][j] );
-	        }
-	        else {
-	          fprintf( file, "\t%.16e\n", A[i][j] );
-	        }
-	      }
+	  for( i = 0; i < n && flag == 0; i++ ) {
+	    flag = ( fwrite( A[i], sizeof( double ), row, file ) == row ) ? 0 : -1;
+	  }
+	}
+	if( fclose( file ) != 0 ) {
+	  flag = -1;
+	}
+	return( flag );
+}
+/* This function gets the elements of a n-X-m 'double' matrix A from a
+   binary file inside the folder "files" (see bin_dim to find n and m
+   first). The file may come from a machine of the other byte order.
+   It returns -1 if the file is not valid or if it has not n rows and
+   m columns.
+*/
+int bin_get_rmat( int n, int m, double **A, char filename[] ) {
+	FILE     *file;
+	int      i, j, swap, flag;
+	char     *path;
+	struct   stat st;
+	Bin_head H;
+
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	file = fopen( path, "rb" );
+	free_chvec( &path );
+	if( file == NULL ) {
+	  return( -1 );
+	}
+
+	flag = -1;
+	if( fstat( fileno( file ), &st ) == 0
+	    && fread( &H, sizeof( H ), 1, file ) == 1
+	    && bin_check( &H, st.st_size, &swap ) == 0
+	    && H.n == ( uint64_t ) n && H.m == ( uint64_t ) m
+	    && fseek( file, H.offset, SEEK_SET ) == 0 ) {
+	  flag = 0;
+	  for( i = 0; i < n && flag == 0; i++ ) {
+	    if( fread( A[i], sizeof( double ), m, file ) != ( size_t ) m ) {
+	      flag = -1;
+	    }
+	    for( j = 0; j < m && swap; j++ ) {
+	      ( ( uint64_t* ) A[i] )[j] = __builtin_bswap64( ( ( uint64_t* ) A[i] )[j] );
 	    }
 	  }
 	}
 	fclose( file );
-	free_chvec( &AUXC );
+	return( flag );
+}
+/* This function sets into n and m the dimensions of the matrix of a
+   binary file inside the folder "files".
+*/
+int bin_dim( int *n, int *m, char filename[] ) {
+	FILE     *file;
+	int      swap, flag;
+	char     *path;
+	struct   stat st;
+	Bin_head H;
+
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	file = fopen( path, "rb" );
+	free_chvec( &path );
+	if( file == NULL ) {
+	  return( -1 );
+	}
+
+	flag = -1;
+	if( fstat( fileno( file ), &st ) == 0
+	    && fread( &H, sizeof( H ), 1, file ) == 1
+	    && bin_check( &H, st.st_size, &swap ) == 0 ) {
+	  *n = H.n;
+	  *m = H.m;
+	  flag = 0;
+	}
+	fclose( file );
+	return( flag );
+}
+/* This function maps a binary file inside the folder "files" into
+   memory and makes A a read-only view of its matrix: no element is
+   read until it is used, and the pages are shared with the system's
+   file cache. Writing into A is an error. The view must be deleted by
+   bin_unmap_rmat. It returns -1 if the file is not valid or if it has
+   the other byte order (see bin_get_rmat).
+*/
+int bin_map_rmat( char filename[], Rmat *A ) {
+	int      fd, i, swap;
+	char     *path, *base;
+	size_t   page, skip, size;
+	struct   stat st;
+	Bin_head H;
+
+	A->n = A->m = A->ld = A->own = 0;
+	A->val = NULL;
+	A->row = NULL;
+
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	fd = open( path, O_RDONLY );
+	free_chvec( &path );
+	if( fd < 0 ) {
+	  return( -1 );
+	}
+	if( fstat( fd, &st ) != 0
+	    || pread( fd, &H, sizeof( H ), 0 ) != ( ssize_t ) sizeof( H )
+	    || bin_check( &H, st.st_size, &swap ) != 0 || swap
+	    || H.offset % sizeof( double ) != 0 ) {
+	  close( fd );
+	  return( -1 );
+	}
+
+	// The mapping starts at the page of the first element.
+	page = sysconf( _SC_PAGESIZE );
+	skip = H.offset % page;
+	size = skip + H.n * H.m * sizeof( double );
+	base = ( char* ) mmap( NULL, size > 0 ? size : 1, PROT_READ, MAP_SHARED,
+	                       fd, H.offset - skip );
+	close( fd );
+	if( base == MAP_FAILED ) {
+	  return( -1 );
+	}
+	A->row = ( double** ) malloc( ( H.n > 0 ? H.n : 1 ) * sizeof( double* ) );
+	if( A->row == NULL ) {
+	  munmap( base, size > 0 ? size : 1 );
+	  return( -1 );
+	}
+	A->n = H.n;
+	A->m = H.m;
+	A->ld = H.m;
+	A->own = 0;
+	A->val = ( double* ) ( base + skip );
+	for( i = 0; i < A->n; i++ ) {
+	  A->row[i] = A->val + ( size_t ) i * A->ld;
+	}
+	madvise( base, size > 0 ? size : 1, MADV_SEQUENTIAL );
+	return( 0 );
+}
+/* This function deletes a view made by bin_map_rmat and unmaps its
+   file.
+*/
+int bin_unmap_rmat( Rmat *A ) {
+	size_t skip, size;
+
+	if( A->val != NULL ) {
+	  skip = ( uintptr_t ) A->val % sysconf( _SC_PAGESIZE );
+	  size = skip + ( size_t ) A->n * A->m * sizeof( double );
+	  munmap( ( char* ) A->val - skip, size > 0 ? size : 1 );
+	}
+	free( A->row );
+	A->row = NULL;
+	A->val = NULL;
+	A->n = A->m = A->ld = A->own = 0;
+
+	return( 0 );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	2. THREAD POOL AND TASK GRAPHS
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//=====================================================
+//	2.1. TASKS, TASK GRAPHS AND THE THREAD POOL
+//=====================================================
+/* A task graph (Tgraph) is a set of tasks (Task) and of dependencies
+   between them: a task runs only after all the tasks it depends on
+   have finished. The graph is run by a persistent pool of POSIX
+   threads. Each thread has its own double-ended queue of ready tasks:
+   it takes the newest task from its queue and, when the queue is
+   empty, steals the oldest task from another thread's queue. If the
+   pool is not running, the graph runs in the calling thread.
+*/
+typedef struct Task Task;
+typedef struct Tgraph Tgraph;
+
+struct Task {
+	void   ( *run )( void *arg );	// Work done by the task.
+	void   *arg;
+	int    deps;	// Unfinished tasks this one depends on.
+	int    nsucc;	// Number of tasks depending on this one.
+	int    msucc;	// Size of succ.
+	Task   **succ;	// Tasks depending on this one.
+	Tgraph *G;
+};
+
+struct Tgraph {
+	int  ntask;	// Number of tasks.
+	int  mtask;	// Size of task.
+	Task **task;
+	int  left;	// Tasks not finished yet.
+};
+
+typedef struct {
+	pthread_mutex_t lock;
+	Task            **q;	// Circular buffer of ready tasks.
+	int             head, size, cap;
+} Tdeque;
+
+static struct {
+	int             n;	// Threads running tasks, the caller included.
+	pthread_t       *thread;
+	Tdeque          *dq;	// Queues; dq[n - 1] belongs to the callers.
+	pthread_mutex_t lock;
+	pthread_cond_t  wake;
+	int             ready;	// Tasks waiting in the queues.
+	int             sleeping;	// Threads waiting for tasks.
+	int             stop;
+} tpool = { 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER,
+            PTHREAD_COND_INITIALIZER, 0, 0, 0 };
+
+static __thread int tpool_intask = 0; // 1 while this thread runs a task.
+
+// Wakes the sleeping threads.
+static void tpool_wake( void ) {
+	pthread_mutex_lock( &tpool.lock );
+	pthread_cond_broadcast( &tpool.wake );
+	pthread_mutex_unlock( &tpool.lock );
+	return;
+}
+// Puts a ready task T at the back of the queue of thread me.
+static int tpool_push( int me, Task *T ) {
+	int    i;
+	Tdeque *D = &tpool.dq[me];
+	Task   **q;
 
+	pthread_mutex_lock( &D->lock );
+	if( D->size == D->cap ) {
+	  q = ( Task** ) malloc( 2 * ( D->cap + 8 ) * sizeof( Task* ) );
+	  if( q == NULL ) {
+	    pthread_mutex_unlock( &D->lock );
+	    return( -1 );
+	  }
+	  for( i = 0; i < D->size; i++ ) {
+	    q[i] = D->q[( D->head + i ) % D->cap];
+	  }
+	  free( D->q );
+	  D->q = q;
+	  D->head = 0;
+	  D->cap = 2 * ( D->cap + 8 );
+	}
+	D->q[( D->head + D->size ) % D->cap] = T;
+	D->size++;
+	pthread_mutex_unlock( &D->lock );
+
+	__atomic_add_fetch( &tpool.ready, 1, __ATOMIC_SEQ_CST );
+	if( __atomic_load_n( &tpool.sleeping, __ATOMIC_SEQ_CST ) > 0 ) {
+	  tpool_wake();
+	}
 	return( 0 );
 }
+/* Takes the newest task of the queue of thread me or, if it is empty,
+   steals the oldest task of another queue. Returns NULL if there is no
+   ready task.
+*/
+static Task *tpool_take( int me ) {
+	int    i;
+	Tdeque *D;
+	Task   *T = NULL;
+
+	for( i = 0; i < tpool.n && T == NULL; i++ ) {
+	  D = &tpool.dq[( me + i ) % tpool.n];
+	  pthread_mutex_lock( &D->lock );
+	  if( D->size > 0 ) {
+	    if( i == 0 ) { // Own queue: newest task.
+	      T = D->q[( D->head + D->size - 1 ) % D->cap];
+	    }
+	    else { // Stealing: oldest task.
+	      T = D->q[D->head];
+	      D->head = ( D->head + 1 ) % D->cap;
+	    }
+	    D->size--;
+	  }
+	  pthread_mutex_unlock( &D->lock );
+	}
+	if( T != NULL ) {
+	  __atomic_sub_fetch( &tpool.ready, 1, __ATOMIC_SEQ_CST );
+	}
+	return( T );
+}
+// Runs task T in thread me and releases the tasks depending on it.
+static void tpool_exec( int me, Task *T ) {
+	int i;
+
+	tpool_intask = 1;
+	T->run( T->arg );
+	tpool_intask = 0;
+
+	for( i = 0; i < T->nsucc; i++ ) {
+	  if( __atomic_sub_fetch( &T->succ[i]->deps, 1, __ATOMIC_ACQ_REL ) == 0 ) {
+	    tpool_push( me, T->succ[i] );
+	  }
+	}
+	if( __atomic_sub_fetch( &T->G->left, 1, __ATOMIC_ACQ_REL ) == 0 ) {
+	  tpool_wake(); // The caller of run_tgraph may be waiting.
+	}
+	return;
+}
+// Main loop of each thread of the pool.
+static void *tpool_work( void *arg ) {
+	int  me, stop;
+	Task *T;
+
+	me = ( int ) ( intptr_t ) arg;
+	for( ; ; ) {
+	  T = tpool_take( me );
+	  if( T != NULL ) {
+	    tpool_exec( me, T );
+	    continue;
+	  }
+
+	  pthread_mutex_lock( &tpool.lock );
+	  __atomic_add_fetch( &tpool.sleeping, 1, __ATOMIC_SEQ_CST );
+	  while( __atomic_load_n( &tpool.ready, __ATOMIC_SEQ_CST ) == 0
+	         && !tpool.stop ) {
+	    pthread_cond_wait( &tpool.wake, &tpool.lock );
+	  }
+	  __atomic_sub_fetch( &tpool.sleeping, 1, __ATOMIC_SEQ_CST );
+	  stop = tpool.stop;
+	  pthread_mutex_unlock( &tpool.lock );
+
+	  if( stop ) {
+	    return( NULL );
+	  }
+	}
+}
+/* This function starts the thread pool with n threads, the calling
+   thread included, so n - 1 threads are created. If n <= 0, one
+   thread per online processor is used. It returns -1 if the pool is
+   already running or if the threads cannot be created.
+*/
+int tpool_init( int n ) {
+	int i;
+
+	if( tpool.n > 0 ) {
+	  return( -1 );
+	}
+	if( n <= 0 ) {
+	  n = ( int ) sysconf( _SC_NPROCESSORS_ONLN );
+	  n = ( n > 0 ) ? n : 1;
+	}
+
+	tpool.dq = ( Tdeque* ) calloc( n, sizeof( Tdeque ) );
+	tpool.thread = ( pthread_t* ) calloc( n, sizeof( pthread_t ) );
+	if( tpool.dq == NULL || tpool.thread == NULL ) {
+	  free( tpool.dq );
+	  free( tpool.thread );
+	  return( -1 );
+	}
+	for( i = 0; i < n; i++ ) {
+	  pthread_mutex_init( &tpool.dq[i].lock, NULL );
+	}
+
+	tpool.n = n;
+	tpool.stop = 0;
+	for( i = 0; i < n - 1; i++ ) {
+	  if( pthread_create( &tpool.thread[i], NULL, tpool_work,
+	                      ( void* ) ( intptr_t ) i ) != 0 ) {
+	    tpool.n = i + 1; // The queues of the missing threads are unused.
+	    break;
+	  }
+	}
+	return( 0 );
+}
+/* This function stops the thread pool and sets its memory free.
+*/
+int tpool_free( void ) {
+	int i;
+
+	if( tpool.n == 0 ) {
+	  return( 0 );
+	}
+	pthread_mutex_lock( &tpool.lock );
+	tpool.stop = 1;
+	pthread_cond_broadcast( &tpool.wake );
+	pthread_mutex_unlock( &tpool.lock );
+
+	for( i = 0; i < tpool.n - 1; i++ ) {
+	  pthread_join( tpool.thread[i], NULL );
+	}
+	for( i = 0; i < tpool.n; i++ ) {
+	  free( tpool.dq[i].q );
+	  pthread_mutex_destroy( &tpool.dq[i].lock );
+	}
+	free( tpool.dq );
+	free( tpool.thread );
+	tpool.dq = NULL;
+	tpool.thread = NULL;
+	tpool.n = 0;
+
+	return( 0 );
+}
+/* This function returns the number of threads of the pool (0 if it
+   is not running).
+*/
+int tpool_size( void ) {
+	return( tpool.n );
+}
+/* This function returns 1 if work started now would be shared among
+   several threads: the pool runs more than one thread and the calling
+   thread is not running a task already (nested work runs serially).
+*/
+int tpool_par( void ) {
+	return( tpool.n > 1 && !tpool_intask );
+}
+/* This function makes G an empty task graph.
+*/
+int new_tgraph( Tgraph *G ) {
+	G->ntask = G->mtask = G->left = 0;
+	G->task = NULL;
+
+	return( 0 );
+}
+/* This function adds to G a task which will call run( arg ). It
+   returns the task, or NULL if memory is not available.
+*/
+Task *add_task( Tgraph *G, void ( *run )( void *arg ), void *arg ) {
+	Task *T, **task;
+
+	if( G->ntask == G->mtask ) {
+	  task = ( Task** ) realloc( G->task, 2 * ( G->mtask + 8 ) * sizeof( Task* ) );
+	  if( task == NULL ) {
+	    return( NULL );
+	  }
+	  G->task = task;
+	  G->mtask = 2 * ( G->mtask + 8 );
+	}
+
+	T = ( Task* ) calloc( 1, sizeof( Task ) );
+	if( T == NULL ) {
+	  return( NULL );
+	}
+	T->run = run;
+	T->arg = arg;
+	T->G = G;
+	G->task[G->ntask] = T;
+	G->ntask++;
+	return( T );
+}
+/* This function makes task T2 wait for task T1 to finish.
+*/
+int add_dep( Task *T1, Task *T2 ) {
+	Task **succ;
+
+	if( T1 == NULL || T2 == NULL ) {
+	  return( -1 );
+	}
+	if( T1->nsucc == T1->msucc ) {
+	  succ = ( Task** ) realloc( T1->succ, 2 * ( T1->msucc + 2 ) * sizeof( Task* ) );
+	  if( succ == NULL ) {
+	    return( -1 );
+	  }
+	  T1->succ = succ;
+	  T1->msucc = 2 * ( T1->msucc + 2 );
+	}
+	T1->succ[T1->nsucc] = T2;
+	T1->nsucc++;
+	T2->deps++;
+	return( 0 );
+}
+/* This function runs all the tasks of G, respecting their
+   dependencies, and returns when all of them have finished. The tasks
+   run in the thread pool when tpool_par() is 1, or in the calling
+   thread, in a topological order, otherwise. A graph runs only once.
+*/
+int run_tgraph( Tgraph *G ) {
+	int  i, top, me;
+	Task *T, **stack;
+
+	G->left = G->ntask;
+	if( !tpool_par() ) {
+	  stack = ( Task** ) malloc( ( G->ntask + 1 ) * sizeof( Task* ) );
+	  if( stack == NULL ) {
+	    return( -1 );
+	  }
+	  top = 0;
+	  for( i = G->ntask - 1; i >= 0; i-- ) {
+	    if( G->task[i]->deps == 0 ) {
+	      stack[top++] = G->task[i];
+	    }
+	  }
+	  while( top > 0 ) {
+	    T = stack[--top];
+	    T->run( T->arg );
+	    G->left--;
+	    for( i = T->nsucc - 1; i >= 0; i-- ) {
+	      T->succ[i]->deps--;
+	      if( T->succ[i]->deps == 0 ) {
+	        stack[top++] = T->succ[i];
+	      }
+	    }
+	  }
+	  free( stack );
+	  return( G->left == 0 ? 0 : -1 ); // Not 0 if there is a cycle.
+	}
+
+	stack = ( Task** ) malloc( ( G->ntask + 1 ) * sizeof( Task* ) );
+	if( stack == NULL ) {
+	  return( -1 );
+	}
+	top = 0;
+	for( i = 0; i < G->ntask; i++ ) { // Roots, found before any task runs.
+	  if( G->task[i]->deps == 0 ) {
+	    stack[top++] = G->task[i];
+	  }
+	}
+	for( i = 0; i < top; i++ ) { // They are shared among the queues.
+	  tpool_push( i % tpool.n, stack[i] );
+	}
+	free( stack );
+
+	me = tpool.n - 1;
+	while( __atomic_load_n( &G->left, __ATOMIC_ACQUIRE ) > 0 ) {
+	  T = tpool_take( me );
+	  if( T != NULL ) {
+	    tpool_exec( me, T );
+	    continue;
+	  }
+
+	  pthread_mutex_lock( &tpool.lock );
+	  __atomic_add_fetch( &tpool.sleeping, 1, __ATOMIC_SEQ_CST );
+	  while( __atomic_load_n( &tpool.ready, __ATOMIC_SEQ_CST ) == 0
+	         && __atomic_load_n( &G->left, __ATOMIC_ACQUIRE ) > 0 ) {
+	    pthread_cond_wait( &tpool.wake, &tpool.lock );
+	  }
+	  __atomic_sub_fetch( &tpool.sleeping, 1, __ATOMIC_SEQ_CST );
+	  pthread_mutex_unlock( &tpool.lock );
+	}
+	return( 0 );
+}
+/* This function sets free the tasks of G.
+*/
+int free_tgraph( Tgraph *G ) {
+	int i;
+
+	for( i = 0; i < G->ntask; i++ ) {
+	  free( G->task[i]->succ );
+	  free( G->task[i] );
+	}
+	free( G->task );
+	G->task = NULL;
+	G->ntask = G->mtask = 0;
+
+	return( 0 );
+}
+//=====================================================
+//	2.2. PARALLEL LOOPS
+//=====================================================
+typedef struct {
+	int  n, next;	// Number of iterations and the next one to run.
+	void ( *run )( int i, void *arg );
+	void *arg;
+} Tfor;
+
+// Runs iterations of a parallel loop while there are any left.
+static void tfor_task( void *arg ) {
+	int  i;
+	Tfor *F = ( Tfor* ) arg;
+
+	while( ( i = __atomic_fetch_add( &F->next, 1, __ATOMIC_RELAXED ) ) < F->n ) {
+	  F->run( i, F->arg );
+	}
+	return;
+}
+/* This function calls run( i, arg ) for i = 0, ..., n - 1. The calls
+   are shared among the threads of the pool, in no given order, when
+   tpool_par() is 1.
+*/
+int tpool_for( int n, void ( *run )( int i, void *arg ), void *arg ) {
+	int    i, flag;
+	Tfor   F;
+	Tgraph G;
+
+	if( !tpool_par() || n < 2 ) {
+	  for( i = 0; i < n; i++ ) {
+	    run( i, arg );
+	  }
+	  return( 0 );
+	}
+
+	F.n = n;
+	F.next = 0;
+	F.run = run;
+	F.arg = arg;
+	new_tgraph( &G );
+	flag = 0;
+	for( i = 0; i < tpool.n && i < n; i++ ) {
+	  if( add_task( &G, tfor_task, &F ) == NULL ) {
+	    flag = -1;
+	  }
+	}
+	flag = flag | run_tgraph( &G );
+	tfor_task( &F ); // Iterations left if some task was not added.
+	free_tgraph( &G );
+	return( flag );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	3. FAST READING AND WRITING OF TEXT FILES
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//=====================================================
+//	3.1. PARSING OF 'double' NUMBERS
+//=====================================================
+/* Numbers are parsed by hand, with no dependence on the locale. The
+   decimal digits are gathered into a 64-bit integer w, so the number
+   is w * 10^e. If w < 2^53 and |e| <= 22, both w and 10^e are exact
+   'double' values and a single multiplication or division gives the
+   correctly rounded result (W. D. Clinger, PLDI 1990). Otherwise, if
+   'long double' has a 64-bit mantissa (x87) and |e| <= 27, w * 10^e
+   is found with one rounding to 64 bits; unless that result is within
+   two units of a 'double' halfway point, rounding it to 'double' gives
+   the correctly rounded result too. This covers the 17 to 30 or so
+   significant digits written by out_rmat; when digits beyond the 19th
+   are dropped, both w and w + 1 must give the same 'double'. The rare
+   numbers left (huge exponents, "inf", "nan", ...) go to strtod, in
+   the "C" locale of the calling thread (uselocale), so the decimal
+   point is always '.'.
+*/
+#define TXT_MAXW	9007199254740992ULL	// 2^53.
+
+static const double txt_pow10[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+       1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18,
+       1e19, 1e20, 1e21, 1e22 };
+
+#if LDBL_MANT_DIG == 64
+static const long double txt_pow10l[28] = { 1e0L, 1e1L, 1e2L, 1e3L, 1e4L,
+       1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L, 1e14L,
+       1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L,
+       1e25L, 1e26L, 1e27L };
+
+// w * 10^e, |e| <= 27, rounded to 64 bits; or 0 if it might not round
+// to the same 'double' as the exact value.
+static long double txt_long( uint64_t w, int e ) {
+	uint64_t    low;
+	long double x;
+
+	x = ( e >= 0 ) ? ( long double ) w * txt_pow10l[e]
+	               : ( long double ) w / txt_pow10l[-e];
+	if( !( x > 1e-300L && x < 1e300L ) ) { // No subnormal 'double'.
+	  return( 0 );
+	}
+	memcpy( &low, &x, sizeof( low ) ); // The 64-bit mantissa of x87.
+	low = low & 0x7FF;
+	return( ( low >= 0x3FE && low <= 0x402 ) ? 0 : x );
+}
+#endif
+
+static pthread_once_t txt_once = PTHREAD_ONCE_INIT;
+static locale_t       txt_c;	// The "C" locale, for strtod.
+
+static void txt_locale( void ) {
+	txt_c = newlocale( LC_NUMERIC_MASK, "C", ( locale_t ) 0 );
+	return;
+}
+
+// A separator of numbers in a line.
+static int txt_sep( char c ) {
+	return( c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r' );
+}
+
+/* This function parses the 'double' number which starts at s, and
+   sets it into x; the text ends at end. It returns a pointer to the
+   first character after the number, or NULL if there is no number at
+   s.
+*/
+const char *txt_strtod( const char *s, const char *end, double *x ) {
+	int        neg, nd, digits, cut, e, ex, eneg;
+	char       buf[64], *word, *tail;
+	const char *p, *q;
+	uint64_t   w;
+	locale_t   old;
+
+	p = s;
+	neg = 0;
+	if( p < end && ( *p == '+' || *p == '-' ) ) {
+	  neg = ( *p == '-' );
+	  p++;
+	}
+	w = 0;
+	nd = digits = cut = e = 0;
+	for( ; p < end && *p >= '0' && *p <= '9'; p++ ) {
+	  digits++;
+	  if( nd < 19 ) {
+	    w = w * 10 + ( *p - '0' );
+	    nd = nd + ( w > 0 );
+	  }
+	  else {
+	    e++;
+	    cut = cut | ( *p != '0' );
+	  }
+	}
+	if( p < end && *p == '.' ) {
+	  for( p++; p < end && *p >= '0' && *p <= '9'; p++ ) {
+	    digits++;
+	    if( nd < 19 ) {
+	      w = w * 10 + ( *p - '0' );
+	      nd = nd + ( w > 0 );
+	      e--;
+	    }
+	    else {
+	      cut = cut | ( *p != '0' );
+	    }
+	  }
+	}
+	if( digits > 0 && p < end && ( *p == 'e' || *p == 'E' ) ) {
+	  q = p + 1;
+	  eneg = 0;
+	  if( q < end && ( *q == '+' || *q == '-' ) ) {
+	    eneg = ( *q == '-' );
+	    q++;
+	  }
+	  if( q < end && *q >= '0' && *q <= '9' ) {
+	    for( ex = 0; q < end && *q >= '0' && *q <= '9'; q++ ) {
+	      ex = ( ex < 100000 ) ? ex * 10 + ( *q - '0' ) : ex;
+	    }
+	    e = eneg ? e - ex : e + ex;
+	    p = q;
+	  }
+	}
+
+	if( digits > 0 && !cut && w < TXT_MAXW ) {
+	  if( w == 0 || e == 0 ) {
+	    *x = ( double ) w;
+	  }
+	  else if( e > 0 && e <= 22 ) {
+	    *x = ( double ) w * txt_pow10[e];
+	  }
+	  else if( e < 0 && e >= -22 ) {
+	    *x = ( double ) w / txt_pow10[-e];
+	  }
+	  else if( e > 22 && e <= 22 + 15 && ( double ) w * txt_pow10[e - 22] < TXT_MAXW ) {
+	    *x = ( ( double ) w * txt_pow10[e - 22] ) * 1e22; // Exact product.
+	  }
+	  else {
+	    cut = 1;
+	  }
+	  if( !cut ) {
+	    *x = neg ? -*x : *x;
+	    return( p );
+	  }
+	}
+
+#if LDBL_MANT_DIG == 64
+	if( digits > 0 && w > 0 && e >= -27 && e <= 27 ) {
+	  long double lo, hi;
+
+	  lo = txt_long( w, e );
+	  hi = cut ? txt_long( w + 1, e ) : lo;
+	  if( lo != 0 && hi != 0 && ( double ) lo == ( double ) hi ) {
+	    *x = neg ? -( double ) lo : ( double ) lo;
+	    return( p );
+	  }
+	}
+#endif
+
+	// strtod, on a copy ending where the number (or the word) ends.
+	if( digits == 0 ) {
+	  p = s;
+	  while( p < end && !txt_sep( *p ) && *p != '\n' ) {
+	    p++;
+	  }
+	}
+	if( p == s ) {
+	  return( NULL );
+	}
+	word = ( p - s < ( long ) sizeof( buf ) ) ? buf : ( char* ) malloc( p - s + 1 );
+	if( word == NULL ) {
+	  return( NULL );
+	}
+	memcpy( word, s, p - s );
+	word[p - s] = '\0';
+	pthread_once( &txt_once, txt_locale );
+	old = ( txt_c != ( locale_t ) 0 ) ? uselocale( txt_c ) : ( locale_t ) 0;
+	*x = strtod( word, &tail );
+	if( old != ( locale_t ) 0 ) {
+	  uselocale( old );
+	}
+	p = ( tail == word ) ? NULL : s + ( tail - word );
+	if( word != buf ) {
+	  free( word );
+	}
+	return( p );
+}
+//=====================================================
+//	3.2. READING OF TEXT MATRIX AND VECTOR FILES
+//=====================================================
+/* A text matrix file has one row of the matrix per line, with the
+   numbers separated by spaces, tabs, commas or semicolons (e.g. the
+   files of out_rmat, or TSV and CSV exports). Blank lines and lines
+   starting with '#' are skipped. The whole file is read in big blocks
+   and then cut into TXT_CHUNK-byte (or so) chunks which end at line
+   ends; the threads of the pool count the lines of the chunks, and
+   then parse them into their rows of the matrix.
+*/
+#define TXT_BLOCK	16777216	// Bytes read per call.
+#define TXT_CHUNK	4194304		// Bytes parsed per task.
+
+typedef struct {
+	const char *s;		// Text.
+	size_t     *cut;	// Chunk c is s[cut[c]], ..., s[cut[c + 1] - 1].
+	int        *row;	// First row of each chunk, after counting lines.
+	int        *err;	// Nonzero for chunks with some bad line.
+	int        m;		// Number of columns.
+	double     **A;
+} Txt_arg;
+
+// The end of the line which starts at p.
+static const char *txt_eol( const char *p, const char *end ) {
+	const char *q;
+
+	q = ( const char* ) memchr( p, '\n', end - p );
+	return( ( q == NULL ) ? end : q );
+}
+// The first character of the line starting at p which is not a
+// separator, or eol if the line has no number.
+static const char *txt_first( const char *p, const char *eol ) {
+	while( p < eol && txt_sep( *p ) ) {
+	  p++;
+	}
+	return( ( p < eol && *p != '#' ) ? p : eol );
+}
+// Parses the numbers of the line p, ..., eol - 1 into A (if A is not
+// NULL), and returns how many there are (-1 for a bad number).
+static int txt_line( const char *p, const char *eol, int m, double *A ) {
+	int    j;
+	double x;
+
+	for( j = 0; ( p = txt_first( p, eol ) ) < eol; j++ ) {
+	  p = txt_strtod( p, eol, &x );
+	  if( p == NULL || ( p < eol && !txt_sep( *p ) ) ) {
+	    return( -1 );
+	  }
+	  if( A != NULL && j < m ) {
+	    A[j] = x;
+	  }
+	}
+	return( j );
+}
+
+static void txt_count( int c, void *arg ) {
+	Txt_arg    *a = ( Txt_arg* ) arg;
+	const char *p, *eol, *end;
+
+	a->row[c] = 0;
+	end = a->s + a->cut[c + 1];
+	for( p = a->s + a->cut[c]; p < end; p = eol + 1 ) {
+	  eol = txt_eol( p, end );
+	  a->row[c] = a->row[c] + ( txt_first( p, eol ) < eol );
+	}
+	return;
+}
+
+static void txt_parse( int c, void *arg ) {
+	Txt_arg    *a = ( Txt_arg* ) arg;
+	int        i;
+	const char *p, *eol, *end;
+
+	i = a->row[c];
+	end = a->s + a->cut[c + 1];
+	for( p = a->s + a->cut[c]; p < end; p = eol + 1 ) {
+	  eol = txt_eol( p, end );
+	  if( txt_first( p, eol ) < eol ) {
+	    if( txt_line( p, eol, a->m, a->A[i] ) != a->m ) {
+	      a->err[c] = 1;
+	    }
+	    i++;
+	  }
+	}
+	return;
+}
+
+// Cuts the len-byte text s into nc chunks of about equal size which
+// end at line ends: chunk c is s[cut[c]], ..., s[cut[c + 1] - 1].
+static void txt_cuts( const char *s, size_t len, int nc, size_t *cut ) {
+	int    c;
+	size_t at;
+
+	cut[0] = 0;
+	for( c = 1; c < nc; c++ ) {
+	  at = ( size_t ) c * ( len / nc );
+	  at = ( at < cut[c - 1] ) ? cut[c - 1] : at;
+	  cut[c] = txt_eol( s + at, s + len ) - s;
+	  cut[c] = ( cut[c] < len ) ? cut[c] + 1 : len;
+	}
+	cut[nc] = len;
+	return;
+}
+
+// Reads the whole file at path into a buffer, whose size is set in len.
+static char *txt_read( char *path, size_t *len ) {
+	FILE   *file;
+	char   *buf, *big;
+	size_t cap, got;
+
+	file = fopen( path, "rb" );
+	if( file == NULL ) {
+	  return( NULL );
+	}
+	cap = TXT_BLOCK;
+	buf = ( char* ) malloc( cap + 1 );
+	*len = 0;
+	while( buf != NULL ) {
+	  if( *len + TXT_BLOCK > cap ) {
+	    cap = 2 * cap;
+	    big = ( char* ) realloc( buf, cap + 1 );
+	    if( big == NULL ) {
+	      free( buf );
+	      buf = NULL;
+	      break;
+	    }
+	    buf = big;
+	  }
+	  got = fread( buf + *len, 1, TXT_BLOCK, file );
+	  *len = *len + got;
+	  if( got < TXT_BLOCK ) {
+	    break;
+	  }
+	}
+	fclose( file );
+	return( buf );
+}
+
+/* This function reads a text matrix file inside the folder "files"
+   into a new matrix A (see new_rmat), finding by itself its number of
+   rows and columns (the numbers in its first line). It returns -1 if
+   the file cannot be read, or if some line has not as many numbers as
+   the first one or a word which is not a number.
+*/
+int txt_get_rmat( char filename[], Rmat *A ) {
+	int        c, nc, n, flag;
+	char       *path, *buf;
+	size_t     len;
+	const char *p, *eol;
+	Txt_arg    a;
+
+	A->n = A->m = A->ld = A->own = 0;
+	A->val = NULL;
+	A->row = NULL;
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	buf = txt_read( path, &len );
+	free_chvec( &path );
+	if( buf == NULL ) {
+	  return( -1 );
+	}
+
+	// The number of columns is found in the first line with numbers.
+	a.m = 0;
+	for( p = buf; p < buf + len; p = eol + 1 ) {
+	  eol = txt_eol( p, buf + len );
+	  if( txt_first( p, eol ) < eol ) {
+	    a.m = txt_line( p, eol, 0, NULL );
+	    break;
+	  }
+	}
+
+	nc = 1 + len / TXT_CHUNK;
+	a.s = buf;
+	a.cut = ( size_t* ) malloc( ( nc + 1 ) * sizeof( size_t ) );
+	a.row = ( int* ) malloc( nc * sizeof( int ) );
+	a.err = ( int* ) calloc( nc, sizeof( int ) );
+	flag = ( a.m < 0 || a.cut == NULL || a.row == NULL || a.err == NULL ) ? -1 : 0;
+	if( flag == 0 ) {
+	  txt_cuts( buf, len, nc, a.cut );
+	  tpool_for( nc, txt_count, &a );
+	  for( n = 0, c = 0; c < nc; c++ ) { // Lines before each chunk.
+	    n = n + a.row[c];
+	    a.row[c] = n - a.row[c];
+	  }
+	  flag = new_rmat( n, a.m, A );
+	}
+	if( flag == 0 ) {
+	  a.A = A->row;
+	  tpool_for( nc, txt_parse, &a );
+	  for( c = 0; c < nc; c++ ) {
+	    flag = ( a.err[c] != 0 ) ? -1 : flag;
+	  }
+	  if( flag != 0 ) {
+	    del_rmat( A );
+	  }
+	}
+
+	free( a.cut );
+	free( a.row );
+	free( a.err );
+	free( buf );
+	return( flag );
+}
+/* This function reads all the numbers of a text file inside the
+   folder "files" (e.g. a column, as written by out_rvec) into a new
+   vector V, and sets into n how many they are. It returns -1 if the
+   file cannot be read or if it is not a text matrix file.
+*/
+int txt_get_rvec( char filename[], int *n, double **V ) {
+	Rmat A;
+
+	*n = 0;
+	*V = NULL;
+	if( txt_get_rmat( filename, &A ) != 0 ) {
+	  return( -1 );
+	}
+	*n = A.n * A.m;
+	if( alloc_rvec( *n, V ) != 0 ) {
+	  del_rmat( &A );
+	  return( -1 );
+	}
+	if( *n > 0 ) {
+	  memcpy( *V, A.val, *n * sizeof( double ) );
+	}
+	del_rmat( &A );
+	return( 0 );
+}
+//=====================================================
+//	3.3. SHORTEST FORMATTING OF 'double' NUMBERS
+//=====================================================
+/* A 'double' x is written with the fewest decimal digits which are
+   read back as x, by the Ryu algorithm (U. Adams, PLDI 2018): the
+   interval of the real numbers which round to x is scaled by a power
+   of 10 through 128-bit products with 5^q or 2^k / 5^q, and the
+   shortest decimal in it is found by removing digits. The 125-bit
+   multipliers are computed once, on first use, by exact big-integer
+   arithmetic.
+*/
+#define FMT_INV_BITS	125	// Bits of the multipliers 2^k / 5^q.
+#define FMT_POW_BITS	125	// Bits of the multipliers 5^q.
+#define FMT_INV_SIZE	342
+#define FMT_POW_SIZE	326
+#define FMT_MAX		25	// Longest number, and a separator.
+
+typedef unsigned __int128 Fmt_u128;
+
+static Fmt_u128       fmt_inv[FMT_INV_SIZE], fmt_pow[FMT_POW_SIZE];
+static pthread_once_t fmt_once = PTHREAD_ONCE_INIT;
+
+// Bits of 5^e (1 for e = 0).
+static int fmt_pow5bits( int e ) {
+	return( ( int ) ( ( ( uint32_t ) e * 1217359 ) >> 19 ) + 1 );
+}
+
+// Fills fmt_pow[q] = the top FMT_POW_BITS bits of 5^q, and fmt_inv[q]
+// = floor( 2^j / 5^q ) + 1, j = bits of 5^q - 1 + FMT_INV_BITS, with
+// 5^q and the remainder as little-endian arrays of 32-bit words.
+static void fmt_tables( void ) {
+	int      q, i, w, nw, len, b;
+	uint32_t P[28], R[29];
+	uint64_t t;
+	Fmt_u128 x;
+
+	memset( P, 0, sizeof( P ) );
+	P[0] = 1;
+	nw = 1;
+	for( q = 0; q < FMT_INV_SIZE; q++ ) {
+	  len = 32 * ( nw - 1 ) + 32 - __builtin_clz( P[nw - 1] );
+	  if( q < FMT_POW_SIZE ) { // 5^q shifted to FMT_POW_BITS bits.
+	    x = 0;
+	    for( b = len - 1; b >= 0 && b >= len - FMT_POW_BITS; b-- ) {
+	      x = ( x << 1 ) | ( P[b / 32] >> ( b % 32 ) & 1 );
+	    }
+	    fmt_pow[q] = ( len < FMT_POW_BITS ) ? x << ( FMT_POW_BITS - len ) : x;
+	  }
+	  // Long division of 2^j by 5^q, one bit at a time.
+	  memset( R, 0, sizeof( R ) );
+	  x = 0;
+	  for( b = len - 1 + FMT_INV_BITS; b >= 0; b-- ) {
+	    for( i = nw; i > 0; i-- ) { // R = 2 * R (+ 1 for the top bit).
+	      R[i] = ( R[i] << 1 ) | ( R[i - 1] >> 31 );
+	    }
+	    R[0] = ( R[0] << 1 ) | ( b == len - 1 + FMT_INV_BITS );
+	    i = nw;
+	    while( i > 0 && R[i] == ( i < nw ? P[i] : 0 ) ) {
+	      i--;
+	    }
+	    x = x << 1;
+	    if( R[i] >= ( i < nw ? P[i] : 0 ) ) { // R >= 5^q.
+	      x = x | 1;
+	      for( t = 0, i = 0; i <= nw; i++ ) {
+	        t = ( uint64_t ) R[i] - ( i < nw ? P[i] : 0 ) - t;
+	        R[i] = ( uint32_t ) t;
+	        t = ( t >> 32 ) & 1;
+	      }
+	    }
+	  }
+	  fmt_inv[q] = x + 1;
+	  for( t = 0, w = 0; w < nw; w++ ) { // 5^(q + 1).
+	    t = ( uint64_t ) P[w] * 5 + t;
+	    P[w] = ( uint32_t ) t;
+	    t = t >> 32;
+	  }
+	  if( t != 0 ) {
+	    P[nw++] = ( uint32_t ) t;
+	  }
+	}
+	return;
+}
+
+// ( m * mul ) >> j, for j >= 64.
+static uint64_t fmt_mulshift( uint64_t m, Fmt_u128 mul, int j ) {
+	Fmt_u128 b0, b2;
+
+	b0 = ( Fmt_u128 ) m * ( uint64_t ) mul;
+	b2 = ( Fmt_u128 ) m * ( uint64_t ) ( mul >> 64 );
+	return( ( uint64_t ) ( ( ( b0 >> 64 ) + b2 ) >> ( j - 64 ) ) );
+}
+// 1 if 5^p divides v.
+static int fmt_div5( uint64_t v, int p ) {
+	int k;
+
+	for( k = 0; v % 5 == 0; k++ ) {
+	  v = v / 5;
+	}
+	return( k >= p );
+}
+
+// Shortest decimal d * 10^e of a finite, positive x; d is returned.
+static uint64_t fmt_ryu( double x, int *e ) {
+	int      e2, q, k, i, mmshift, even, removed, last, vmzero, vrzero, up;
+	uint64_t bits, m2, mv, vr, vp, vm, mant;
+	uint32_t ex;
+
+	memcpy( &bits, &x, sizeof( bits ) );
+	mant = bits & ( ( ( uint64_t ) 1 << 52 ) - 1 );
+	ex = ( uint32_t ) ( bits >> 52 ) & 0x7FF;
+	if( ex == 0 ) {
+	  e2 = 1 - 1023 - 52 - 2;
+	  m2 = mant;
+	}
+	else {
+	  e2 = ( int ) ex - 1023 - 52 - 2;
+	  m2 = ( ( uint64_t ) 1 << 52 ) | mant;
+	}
+	even = ( m2 & 1 ) == 0;
+	mv = 4 * m2;
+	mmshift = ( mant != 0 || ex <= 1 );
+	vmzero = vrzero = 0;
+
+	// The bounds 4 * m2 - 1 - mmshift, 4 * m2 and 4 * m2 + 2 (times 2^e2)
+	// are scaled to vm, vr and vp times 10^e.
+	if( e2 >= 0 ) {
+	  q = ( int ) ( ( ( uint32_t ) e2 * 78913 ) >> 18 ) - ( e2 > 3 );
+	  *e = q;
+	  k = FMT_INV_BITS + fmt_pow5bits( q ) - 1;
+	  i = -e2 + q + k;
+	  vr = fmt_mulshift( 4 * m2, fmt_inv[q], i );
+	  vp = fmt_mulshift( 4 * m2 + 2, fmt_inv[q], i );
+	  vm = fmt_mulshift( 4 * m2 - 1 - mmshift, fmt_inv[q], i );
+	  if( q <= 21 ) {
+	    if( mv % 5 == 0 ) {
+	      vrzero = fmt_div5( mv, q );
+	    }
+	    else if( even ) {
+	      vmzero = fmt_div5( mv - 1 - mmshift, q );
+	    }
+	    else {
+	      vp = vp - fmt_div5( mv + 2, q );
+	    }
+	  }
+	}
+	else {
+	  q = ( int ) ( ( ( uint32_t ) -e2 * 732923 ) >> 20 ) - ( -e2 > 1 );
+	  *e = q + e2;
+	  i = -e2 - q;
+	  k = fmt_pow5bits( i ) - FMT_POW_BITS;
+	  vr = fmt_mulshift( 4 * m2, fmt_pow[i], q - k );
+	  vp = fmt_mulshift( 4 * m2 + 2, fmt_pow[i], q - k );
+	  vm = fmt_mulshift( 4 * m2 - 1 - mmshift, fmt_pow[i], q - k );
+	  if( q <= 1 ) {
+	    vrzero = 1;
+	    if( even ) {
+	      vmzero = mmshift;
+	    }
+	    else {
+	      vp--;
+	    }
+	  }
+	  else if( q < 63 ) {
+	    vrzero = ( mv & ( ( ( uint64_t ) 1 << q ) - 1 ) ) == 0;
+	  }
+	}
+
+	// Digits are removed while vm and vp still differ.
+	removed = last = 0;
+	if( vmzero || vrzero ) {
+	  while( vp / 10 > vm / 10 ) {
+	    vmzero = vmzero && vm % 10 == 0;
+	    vrzero = vrzero && last == 0;
+	    last = vr % 10;
+	    vr = vr / 10;
+	    vp = vp / 10;
+	    vm = vm / 10;
+	    removed++;
+	  }
+	  if( vmzero ) {
+	    while( vm % 10 == 0 ) {
+	      vrzero = vrzero && last == 0;
+	      last = vr % 10;
+	      vr = vr / 10;
+	      vp = vp / 10;
+	      vm = vm / 10;
+	      removed++;
+	    }
+	  }
+	  if( vrzero && last == 5 && vr % 2 == 0 ) { // Halfway: round to even.
+	    last = 4;
+	  }
+	  up = ( vr == vm && ( !even || !vmzero ) ) || last >= 5;
+	}
+	else {
+	  up = 0;
+	  while( vp / 10 > vm / 10 ) {
+	    up = vr % 10 >= 5;
+	    vr = vr / 10;
+	    vp = vp / 10;
+	    vm = vm / 10;
+	    removed++;
+	  }
+	  up = up || vr == vm;
+	}
+	*e = *e + removed;
+	return( vr + up );
+}
+
+/* This function writes into s the shortest decimal form of x which is
+   read back as x, and returns its length (at most FMT_MAX - 1). It
+   is written in scientific notation ("1.25e-7") if sci is 1 or if the
+   decimal exponent of x is below -5 or above 20, and in positional
+   notation ("0.5", "1200") otherwise; "inf", "-inf" and "nan" are
+   written for those values. s is not null-terminated.
+*/
+int fmt_double( double x, int sci, char *s ) {
+	int      e, nd, pos, k, len;
+	char     dig[20];
+	uint64_t d;
+
+	len = 0;
+	if( signbit( x ) && !isnan( x ) ) {
+	  s[len++] = '-';
+	  x = -x;
+	}
+	if( isnan( x ) || isinf( x ) ) {
+	  memcpy( s + len, isnan( x ) ? "nan" : "inf", 3 );
+	  return( len + 3 );
+	}
+	if( x == 0 ) {
+	  s[len] = '0';
+	  return( len + 1 );
+	}
+
+	pthread_once( &fmt_once, fmt_tables );
+	d = fmt_ryu( x, &e );
+	for( nd = 0; d > 0; nd++ ) { // dig has the nd digits backwards.
+	  dig[nd] = '0' + d % 10;
+	  d = d / 10;
+	}
+	pos = nd + e; // Digits before the decimal point.
+
+	if( sci || pos - 1 < -5 || pos - 1 > 20 ) {
+	  s[len++] = dig[nd - 1];
+	  if( nd > 1 ) {
+	    s[len++] = '.';
+	    for( k = nd - 2; k >= 0; k-- ) {
+	      s[len++] = dig[k];
+	    }
+	  }
+	  s[len++] = 'e';
+	  e = pos - 1;
+	  if( e < 0 ) {
+	    s[len++] = '-';
+	    e = -e;
+	  }
+	  if( e >= 100 ) {
+	    s[len++] = '0' + e / 100;
+	  }
+	  if( e >= 10 ) {
+	    s[len++] = '0' + e / 10 % 10;
+	  }
+	  s[len++] = '0' + e % 10;
+	}
+	else if( pos <= 0 ) { // 0.00ddd
+	  s[len++] = '0';
+	  s[len++] = '.';
+	  for( k = pos; k < 0; k++ ) {
+	    s[len++] = '0';
+	  }
+	  for( k = nd - 1; k >= 0; k-- ) {
+	    s[len++] = dig[k];
+	  }
+	}
+	else { // ddd.ddd or ddd000
+	  for( k = nd - 1; k >= 0; k-- ) {
+	    s[len++] = dig[k];
+	    if( k == nd - pos && k > 0 ) {
+	      s[len++] = '.';
+	    }
+	  }
+	  for( k = nd; k < pos; k++ ) {
+	    s[len++] = '0';
+	  }
+	}
+	return( len );
+}
+//=====================================================
+//	3.4. WRITING OF TEXT MATRIX AND VECTOR FILES
+//=====================================================
+/* The numbers are formatted by fmt_double into blocks of rows of
+   about FMT_CHUNK bytes, which are written to the file in order, in
+   one call each. When tpool_par() is 1, several blocks are formatted
+   at once by the threads of the pool.
+*/
+#define FMT_CHUNK	1048576
+
+typedef struct {
+	int    n, m, sci, rows;	// rows: rows per block.
+	double **A, *V;		// The matrix, or a vector (A = NULL).
+	int    b0;		// First block of this round.
+	char   **buf;		// One buffer per block of the round...
+	size_t *len;		// ...and its length.
+} Fmt_arg;
+
+static void fmt_task( int k, void *arg ) {
+	Fmt_arg *a = ( Fmt_arg* ) arg;
+	int     i, j, i1;
+	char    *s;
+
+	s = a->buf[k];
+	i = ( a->b0 + k ) * a->rows;
+	i1 = ( i + a->rows < a->n ) ? i + a->rows : a->n;
+	for( ; i < i1; i++ ) {
+	  for( j = 0; j < a->m; j++ ) {
+	    s = s + fmt_double( ( a->A == NULL ) ? a->V[i] : a->A[i][j], a->sci, s );
+	    *s++ = ( j < a->m - 1 ) ? '\t' : '\n';
+	  }
+	}
+	a->len[k] = s - a->buf[k];
+	return;
+}
+
+/* This function writes the n-X-m matrix A (or, if A is NULL, the
+   n-dimensional vector V as a column) into a text file inside the
+   folder "files", one row per line with tab-separated numbers. The
+   numbers are in their shortest form (see fmt_double), in scientific
+   notation if sci is 1. It returns -1 if the file or the memory is not
+   available.
+*/
+int txt_out( int n, int m, double **A, double *V, int sci, char filename[] ) {
+	FILE    *file;
+	int     k, nb, nbuf, flag;
+	char    *path;
+	Fmt_arg a;
+
+	a.n = n;
+	a.m = ( A == NULL ) ? 1 : m;
+	a.sci = sci;
+	a.A = A;
+	a.V = V;
+	a.rows = 1 + FMT_CHUNK / ( ( size_t ) FMT_MAX * ( a.m > 0 ? a.m : 1 ) );
+	nb = ( n + a.rows - 1 ) / a.rows;
+	nbuf = tpool_par() ? 2 * tpool_size() : 1;
+	nbuf = ( nbuf < nb ) ? nbuf : ( nb > 0 ? nb : 1 );
+
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	file = fopen( path, "w" );
+	free_chvec( &path );
+	if( file == NULL ) {
+	  return( -1 );
+	}
+
+	flag = 0;
+	a.buf = ( char** ) calloc( nbuf, sizeof( char* ) );
+	a.len = ( size_t* ) malloc( nbuf * sizeof( size_t ) );
+	for( k = 0; a.buf != NULL && k < nbuf; k++ ) {
+	  a.buf[k] = ( char* ) malloc( ( size_t ) a.rows * a.m * FMT_MAX + 1 );
+	  flag = ( a.buf[k] == NULL ) ? -1 : flag;
+	}
+	flag = ( a.buf == NULL || a.len == NULL ) ? -1 : flag;
+
+	for( a.b0 = 0; a.b0 < nb && flag == 0; a.b0 = a.b0 + nbuf ) {
+	  k = ( nb - a.b0 < nbuf ) ? nb - a.b0 : nbuf;
+	  tpool_for( k, fmt_task, &a );
+	  for( k = 0; k < nbuf && a.b0 + k < nb && flag == 0; k++ ) {
+	    flag = ( fwrite( a.buf[k], 1, a.len[k], file ) == a.len[k] ) ? 0 : -1;
+	  }
+	}
+
+	for( k = 0; a.buf != NULL && k < nbuf; k++ ) {
+	  free( a.buf[k] );
+	}
+	free( a.buf );
+	free( a.len );
+	if( fclose( file ) != 0 ) {
+	  flag = -1;
+	}
+	return( flag );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	4. SNAPSHOT STREAMS
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//=====================================================
+//	4.1. WRITING OF SNAPSHOT STREAMS
+//=====================================================
+/* A snapshot stream is one binary file holding many frames: vectors or
+   matrices, e.g. the state of a simulation at each time step, each
+   with a tag (e.g. the time). The file has a Bin_head header with the
+   magic "LILASNP", then the frames, each a Snap_frame header followed
+   by its n * m elements, and at last an index with the offset of each
+   frame and a Snap_tail trailer, so any frame can be read at once.
+
+   Frames are copied into one of two buffers while a background thread
+   writes the other one, so the caller waits only if it fills a buffer
+   before the previous one is written.
+*/
+#define SNAP_CAP	8388608		// Default bytes per buffer.
+
+typedef struct {
+	char     magic[4];	// "FRM" and a null character.
+	uint32_t pad;
+	uint64_t n, m;		// Rows and columns (m = 1 for a vector).
+	double   tag;
+} Snap_frame;
+
+typedef struct {
+	uint64_t offset;	// Offset of the frame's Snap_frame.
+	uint64_t n, m;
+	double   tag;
+} Snap_entry;
+
+typedef struct {
+	uint64_t index;		// Offset of the first Snap_entry.
+	uint64_t nframe;
+	char     magic[8];	// "LILAIDX" and a null character.
+} Snap_tail;
+
+typedef struct {
+	FILE            *file;
+	pthread_t       thread;
+	pthread_mutex_t lock;
+	pthread_cond_t  done;	// A buffer was written, or there is one to write.
+	char            *buf[2];
+	size_t          len[2], cap[2];
+	int             cur;	// Buffer being filled by the caller.
+	int             full;	// Buffer to be written by the thread, or -1.
+	int             stop, err;
+	uint64_t        pos;	// Offset of the next frame.
+	int             nframe, mframe;
+	Snap_entry      *index;
+} Snap;
+
+// Writes the buffers handed over by the caller.
+static void *snap_work( void *arg ) {
+	Snap *S = ( Snap* ) arg;
+	int  b, err;
+
+	pthread_mutex_lock( &S->lock );
+	for( ; ; ) {
+	  while( S->full < 0 && !S->stop ) {
+	    pthread_cond_wait( &S->done, &S->lock );
+	  }
+	  if( S->full < 0 ) {
+	    break;
+	  }
+	  b = S->full;
+	  pthread_mutex_unlock( &S->lock );
+	  err = ( fwrite( S->buf[b], 1, S->len[b], S->file ) != S->len[b] );
+	  pthread_mutex_lock( &S->lock );
+	  S->err = S->err | err;
+	  S->len[b] = 0;
+	  S->full = -1;
+	  pthread_cond_broadcast( &S->done );
+	}
+	pthread_mutex_unlock( &S->lock );
+	return( NULL );
+}
+// Hands the caller's buffer over to the thread, once it is free.
+static void snap_flush( Snap *S ) {
+	pthread_mutex_lock( &S->lock );
+	while( S->full >= 0 ) {
+	  pthread_cond_wait( &S->done, &S->lock );
+	}
+	if( S->len[S->cur] > 0 ) {
+	  S->full = S->cur;
+	  S->cur = 1 - S->cur;
+	  pthread_cond_broadcast( &S->done );
+	}
+	pthread_mutex_unlock( &S->lock );
+	return;
+}
+
+/* This function opens a new snapshot stream S in a file inside the
+   folder "files" (an old file is replaced), with two buffers of cap
+   bytes each (SNAP_CAP if cap is 0), and starts its writing thread.
+   It returns -1 if the file or the memory is not available.
+*/
+int snap_open( char filename[], size_t cap, Snap *S ) {
+	char     *path;
+	Bin_head H;
+
+	memset( S, 0, sizeof( Snap ) );
+	cap = ( cap > 0 ) ? cap : SNAP_CAP;
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	S->file = fopen( path, "wb" );
+	free_chvec( &path );
+	if( S->file == NULL ) {
+	  return( -1 );
+	}
+
+	memset( &H, 0, sizeof( H ) );
+	memcpy( H.magic, "LILASNP", 8 );
+	H.version = BIN_VERSION;
+	H.endian = BIN_ENDIAN;
+	H.dtype = BIN_DOUBLE;
+	H.layout = BIN_ROWMAJOR;
+	H.align = sizeof( double );
+	H.offset = BIN_HEAD;
+	S->pos = BIN_HEAD;
+	S->buf[0] = ( char* ) malloc( cap );
+	S->buf[1] = ( char* ) malloc( cap );
+	S->cap[0] = S->cap[1] = cap;
+	S->full = -1;
+	if( S->buf[0] == NULL || S->buf[1] == NULL
+	    || fwrite( &H, sizeof( H ), 1, S->file ) != 1 ) {
+	  free( S->buf[0] );
+	  free( S->buf[1] );
+	  fclose( S->file );
+	  return( -1 );
+	}
+	setvbuf( S->file, NULL, _IONBF, 0 ); // The buffers are ours.
+
+	pthread_mutex_init( &S->lock, NULL );
+	pthread_cond_init( &S->done, NULL );
+	if( pthread_create( &S->thread, NULL, snap_work, S ) != 0 ) {
+	  pthread_mutex_destroy( &S->lock );
+	  pthread_cond_destroy( &S->done );
+	  free( S->buf[0] );
+	  free( S->buf[1] );
+	  fclose( S->file );
+	  return( -1 );
+	}
+	return( 0 );
+}
+
+/* This function appends to the stream S a frame with a tag and the
+   n-X-m matrix A (or, if A is NULL, the n-dimensional vector V). The
+   elements are copied, so A or V may change as soon as it returns. It
+   returns -1 if the memory is not available or if some earlier write
+   failed.
+*/
+int snap_add( Snap *S, double tag, int n, int m, double **A, double *V ) {
+	int        i;
+	size_t     bytes, row;
+	char       *p;
+	Snap_entry *idx;
+	Snap_frame F;
+
+	m = ( A == NULL ) ? 1 : m;
+	row = ( size_t ) m * sizeof( double );
+	bytes = sizeof( Snap_frame ) + n * row;
+	if( S->nframe == S->mframe ) {
+	  S->mframe = ( S->mframe > 0 ) ? 2 * S->mframe : 64;
+	  idx = ( Snap_entry* ) realloc( S->index, S->mframe * sizeof( Snap_entry ) );
+	  if( idx == NULL ) {
+	    return( -1 );
+	  }
+	  S->index = idx;
+	}
+	if( S->len[S->cur] + bytes > S->cap[S->cur] ) {
+	  snap_flush( S );
+	}
+	if( bytes > S->cap[S->cur] ) { // Only the caller uses this buffer.
+	  p = ( char* ) realloc( S->buf[S->cur], bytes );
+	  if( p == NULL ) {
+	    return( -1 );
+	  }
+	  S->buf[S->cur] = p;
+	  S->cap[S->cur] = bytes;
+	}
+
+	memset( &F, 0, sizeof( F ) );
+	memcpy( F.magic, "FRM", 4 );
+	F.n = n;
+	F.m = m;
+	F.tag = tag;
+	p = S->buf[S->cur] + S->len[S->cur];
+	memcpy( p, &F, sizeof( F ) );
+	p = p + sizeof( F );
+	if( A == NULL ) {
+	  memcpy( p, V, n * row );
+	}
+	for( i = 0; A != NULL && i < n; i++ ) {
+	  memcpy( p + i * row, A[i], row );
+	}
+	S->len[S->cur] = S->len[S->cur] + bytes;
+
+	S->index[S->nframe].offset = S->pos;
+	S->index[S->nframe].n = n;
+	S->index[S->nframe].m = m;
+	S->index[S->nframe].tag = tag;
+	S->nframe++;
+	S->pos = S->pos + bytes;
+
+	pthread_mutex_lock( &S->lock );
+	i = S->err;
+	pthread_mutex_unlock( &S->lock );
+	return( i ? -1 : 0 );
+}
+/* This function appends to the stream S a frame with the n-X-m matrix
+   A (see snap_add).
+*/
+int snap_rmat( Snap *S, double tag, int n, int m, double **A ) {
+	return( snap_add( S, tag, n, m, A, NULL ) );
+}
+/* This function appends to the stream S a frame with the n-dimensional
+   vector V (see snap_add).
+*/
+int snap_rvec( Snap *S, double tag, int n, double *V ) {
+	return( snap_add( S, tag, n, 1, NULL, V ) );
+}
+
+/* This function writes the frames left, the index and the trailer of
+   the stream S, stops its thread and closes its file. It returns -1
+   if some write failed.
+*/
+int snap_close( Snap *S ) {
+	int       err;
+	Snap_tail T;
+
+	snap_flush( S );
+	pthread_mutex_lock( &S->lock );
+	while( S->full >= 0 ) {
+	  pthread_cond_wait( &S->done, &S->lock );
+	}
+	S->stop = 1;
+	pthread_cond_broadcast( &S->done );
+	pthread_mutex_unlock( &S->lock );
+	pthread_join( S->thread, NULL );
+
+	memset( &T, 0, sizeof( T ) );
+	T.index = S->pos;
+	T.nframe = S->nframe;
+	memcpy( T.magic, "LILAIDX", 8 );
+	err = S->err;
+	if( S->nframe > 0 ) {
+	  err = err | ( fwrite( S->index, sizeof( Snap_entry ), S->nframe, S->file )
+	                != ( size_t ) S->nframe );
+	}
+	err = err | ( fwrite( &T, sizeof( T ), 1, S->file ) != 1 );
+	err = err | ( fclose( S->file ) != 0 );
+
+	pthread_mutex_destroy( &S->lock );
+	pthread_cond_destroy( &S->done );
+	free( S->buf[0] );
+	free( S->buf[1] );
+	free( S->index );
+	memset( S, 0, sizeof( Snap ) );
+	return( err ? -1 : 0 );
+}
+//=====================================================
+//	4.2. READING OF SNAPSHOT STREAMS
+//=====================================================
+/* A stream is read through a Snapr, which keeps its file open and its
+   index in memory. The index is taken from the end of the file or,
+   if the stream was not closed (e.g. the program stopped), it is
+   rebuilt by reading the frame headers, and the frames which are not
+   complete are ignored.
+*/
+typedef struct {
+	int        fd;
+	int        nframe;
+	Snap_entry *index;
+} Snapr;
+
+// 1 if a frame of n-X-m elements whose Snap_frame is at pos fits in a
+// file of size bytes (tested by divisions, so n * m cannot wrap).
+static int snap_fits( uint64_t pos, uint64_t n, uint64_t m, uint64_t size ) {
+	if( pos > size || size - pos < sizeof( Snap_frame )
+	    || n > INT32_MAX || m > INT32_MAX ) {
+	  return( 0 );
+	}
+	return( m == 0 || n <= ( size - pos - sizeof( Snap_frame ) ) / sizeof( double ) / m );
+}
+/* This function opens the snapshot stream of a file inside the folder
+   "files" for reading, into R. It returns -1 if the file is not a
+   snapshot stream of this machine's byte order.
+*/
+int snap_load( char filename[], Snapr *R ) {
+	int        k;
+	char       *path;
+	uint64_t   pos, size;
+	struct     stat st;
+	Bin_head   H;
+	Snap_tail  T;
+	Snap_frame F;
+	Snap_entry *idx;
+
+	R->nframe = 0;
+	R->index = NULL;
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	R->fd = open( path, O_RDONLY );
+	free_chvec( &path );
+	if( R->fd < 0 ) {
+	  return( -1 );
+	}
+	if( fstat( R->fd, &st ) != 0
+	    || pread( R->fd, &H, sizeof( H ), 0 ) != ( ssize_t ) sizeof( H )
+	    || memcmp( H.magic, "LILASNP", 8 ) != 0 || H.endian != BIN_ENDIAN ) {
+	  close( R->fd );
+	  return( -1 );
+	}
+	size = st.st_size;
+
+	if( size >= BIN_HEAD + sizeof( T )
+	    && pread( R->fd, &T, sizeof( T ), size - sizeof( T ) ) == ( ssize_t ) sizeof( T )
+	    && memcmp( T.magic, "LILAIDX", 8 ) == 0
+	    && T.index >= BIN_HEAD && T.index <= size - sizeof( T ) && T.nframe <= INT32_MAX
+	    && ( size - sizeof( T ) - T.index ) % sizeof( Snap_entry ) == 0
+	    && T.nframe == ( size - sizeof( T ) - T.index ) / sizeof( Snap_entry ) ) {
+	  R->index = ( Snap_entry* ) malloc( ( T.nframe + 1 ) * sizeof( Snap_entry ) );
+	  if( R->index != NULL && pread( R->fd, R->index, T.nframe * sizeof( Snap_entry ),
+	      T.index ) == ( ssize_t ) ( T.nframe * sizeof( Snap_entry ) ) ) {
+	    for( k = 0; k < ( int ) T.nframe; k++ ) {
+	      if( !snap_fits( R->index[k].offset, R->index[k].n, R->index[k].m, T.index ) ) {
+	        break;
+	      }
+	    }
+	    if( k == ( int ) T.nframe ) {
+	      R->nframe = T.nframe;
+	      return( 0 );
+	    }
+	  }
+	  free( R->index );
+	  R->index = NULL;
+	}
+
+	// No index: the frames are found one after another.
+	k = 0;
+	for( pos = BIN_HEAD; pos + sizeof( F ) <= size; k++ ) {
+	  if( pread( R->fd, &F, sizeof( F ), pos ) != ( ssize_t ) sizeof( F )
+	      || memcmp( F.magic, "FRM", 4 ) != 0 || !snap_fits( pos, F.n, F.m, size ) ) {
+	    break;
+	  }
+	  if( ( k & ( k - 1 ) ) == 0 ) { // k = 0, 1, 2, 4, ...
+	    idx = ( Snap_entry* ) realloc( R->index, 2 * ( k + 1 ) * sizeof( Snap_entry ) );
+	    if( idx == NULL ) {
+	      break;
+	    }
+	    R->index = idx;
+	  }
+	  R->index[k].offset = pos;
+	  R->index[k].n = F.n;
+	  R->index[k].m = F.m;
+	  R->index[k].tag = F.tag;
+	  pos = pos + sizeof( F ) + F.n * F.m * sizeof( double );
+	}
+	R->nframe = k;
+	return( 0 );
+}
+/* This function returns the number of frames of the stream R and, if
+   0 <= k < that number, sets into n, m and tag the dimensions and the
+   tag of frame k (any of them may be NULL).
+*/
+int snap_info( Snapr *R, int k, int *n, int *m, double *tag ) {
+	if( k >= 0 && k < R->nframe ) {
+	  if( n != NULL ) {
+	    *n = R->index[k].n;
+	  }
+	  if( m != NULL ) {
+	    *m = R->index[k].m;
+	  }
+	  if( tag != NULL ) {
+	    *tag = R->index[k].tag;
+	  }
+	}
+	return( R->nframe );
+}
+/* This function reads frame k of the stream R into the matrix A (or,
+   if A is NULL, into the vector V), which must have its dimensions
+   (see snap_info). It returns -1 if there is no frame k.
+*/
+int snap_get( Snapr *R, int k, double **A, double *V ) {
+	int      i;
+	size_t   row, bytes;
+	uint64_t pos;
+
+	if( k < 0 || k >= R->nframe ) {
+	  return( -1 );
+	}
+	row = R->index[k].m * sizeof( double );
+	pos = R->index[k].offset + sizeof( Snap_frame );
+	if( A == NULL ) {
+	  bytes = R->index[k].n * row;
+	  return( pread( R->fd, V, bytes, pos ) == ( ssize_t ) bytes ? 0 : -1 );
+	}
+	for( i = 0; i < ( int ) R->index[k].n; i++ ) {
+	  if( pread( R->fd, A[i], row, pos + i * row ) != ( ssize_t ) row ) {
+	    return( -1 );
+	  }
+	}
+	return( 0 );
+}
+/* This function closes the stream R.
+*/
+int snap_free( Snapr *R ) {
+	close( R->fd );
+	free( R->index );
+	R->index = NULL;
+	R->nframe = 0;
+
+	return( 0 );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	5. COMPRESSED MATRIX FILES
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/* A compressed matrix file keeps the elements of a n-X-m matrix in
+   chunks of rows consecutive rows, each compressed on its own, so the
+   chunks are compressed and decompressed by different threads, and
+   any row is read by decompressing only its chunk. The file has a
+   ZBIN_HEAD-byte header (Zbin_head), the chunks, and an index with
+   the offset of each chunk and the end of the last one.
+
+   Before compression, the elements of a chunk are split into 8 byte
+   planes (the most significant bytes of all the elements, then the
+   next ones, ...), which puts the sign, exponent and leading mantissa
+   bytes, which change little between neighbours, together. With the
+   filter ZBIN_XOR, each element is first XORed with the one before it,
+   so equal or close neighbours leave mostly zero bytes. A chunk which
+   does not get smaller is stored as its byte planes.
+*/
+//=====================================================
+//	5.1. BYTE PLANES AND THE CHUNK CODEC
+//=====================================================
+/* The codec is a byte-oriented LZ77 coder in the manner of LZ4: a
+   sequence of a token (4 bits of literal length, 4 bits of match
+   length - ZBIN_MINMATCH, each continued by extra bytes if it is 15),
+   the literals, and the 2-byte offset of a match back in the output;
+   the last sequence has only literals. Matches are found with a hash
+   table of ZBIN_HASH-bit keys of 4-byte strings, and the search speeds
+   up through data which does not compress.
+*/
+#define ZBIN_HEAD	64
+#define ZBIN_SHUFFLE	1		// Byte planes.
+#define ZBIN_XOR	2		// XOR with the element before, then byte planes.
+#define ZBIN_CHUNK	1048576		// Bytes of elements per chunk.
+#define ZBIN_HASH	14
+#define ZBIN_MINMATCH	4
+#define ZBIN_WINDOW	65535		// Farthest match.
+#define ZBIN_BLOCK	256		// Elements per step of the byte planes.
+
+typedef unsigned char Zbin_byte;
+
+static uint32_t zbin_read32( const Zbin_byte *p ) {
+	uint32_t v;
+
+	memcpy( &v, p, 4 );
+	return( v );
+}
+static uint32_t zbin_key( const Zbin_byte *p ) {
+	return( ( zbin_read32( p ) * 2654435761u ) >> ( 32 - ZBIN_HASH ) );
+}
+// Writes the rest l of a length whose token field is 15.
+static Zbin_byte *zbin_len( Zbin_byte *op, size_t l ) {
+	while( l >= 255 ) {
+	  *op++ = 255;
+	  l = l - 255;
+	}
+	*op++ = ( Zbin_byte ) l;
+	return( op );
+}
+// Reads the rest of a length l whose token field is 15 into l; it
+// returns NULL if the input ends before.
+static const Zbin_byte *zbin_getlen( const Zbin_byte *ip, const Zbin_byte *end,
+                                     size_t *l ) {
+	do {
+	  if( ip >= end ) {
+	    return( NULL );
+	  }
+	  *l = *l + *ip;
+	} while( *ip++ == 255 );
+	return( ip );
+}
+
+// Compresses the n bytes at src into dst, of cap bytes, and returns
+// the compressed size, or 0 if it does not fit into cap bytes.
+static size_t zbin_lz( const Zbin_byte *src, size_t n, Zbin_byte *dst, size_t cap ) {
+	uint32_t        table[1 << ZBIN_HASH];
+	size_t          lit, len, miss;
+	uint32_t        h;
+	Zbin_byte       *op, *token;
+	const Zbin_byte *ip, *anchor, *ref, *end, *limit;
+
+	memset( table, 0, sizeof( table ) );
+	op = dst;
+	ip = anchor = src;
+	end = src + n;
+	limit = ( n > 12 ) ? end - 12 : src; // The last bytes are literals.
+	miss = 0;
+	while( ip < limit ) {
+	  h = zbin_key( ip );
+	  ref = src + table[h];
+	  table[h] = ip - src;
+	  if( ref >= ip || ip - ref > ZBIN_WINDOW
+	      || zbin_read32( ref ) != zbin_read32( ip ) ) {
+	    ip = ip + 1 + ( miss++ >> 6 );
+	    continue;
+	  }
+	  while( ip > anchor && ref > src && ip[-1] == ref[-1] ) {
+	    ip--;
+	    ref--;
+	  }
+	  len = ZBIN_MINMATCH;
+	  while( ip + len < end - 5 && ip[len] == ref[len] ) {
+	    len++;
+	  }
+	  lit = ip - anchor;
+	  if( ( size_t ) ( dst + cap - op ) < lit + lit / 255 + len / 255 + 5 ) {
+	    return( 0 );
+	  }
+	  token = op++;
+	  *token = ( Zbin_byte ) ( ( lit < 15 ? lit : 15 ) << 4 );
+	  if( lit >= 15 ) {
+	    op = zbin_len( op, lit - 15 );
+	  }
+	  memcpy( op, anchor, lit );
+	  op = op + lit;
+	  *op++ = ( Zbin_byte ) ( ( ip - ref ) & 255 );
+	  *op++ = ( Zbin_byte ) ( ( ip - ref ) >> 8 );
+	  len = len - ZBIN_MINMATCH;
+	  *token = *token | ( Zbin_byte ) ( len < 15 ? len : 15 );
+	  if( len >= 15 ) {
+	    op = zbin_len( op, len - 15 );
+	  }
+	  ip = ip + len + ZBIN_MINMATCH;
+	  anchor = ip;
+	  miss = 0;
+	  if( ip < limit ) {
+	    table[zbin_key( ip - 2 )] = ip - 2 - src;
+	  }
+	}
+
+	lit = end - anchor;
+	if( ( size_t ) ( dst + cap - op ) < lit + lit / 255 + 2 ) {
+	  return( 0 );
+	}
+	token = op++;
+	*token = ( Zbin_byte ) ( ( lit < 15 ? lit : 15 ) << 4 );
+	if( lit >= 15 ) {
+	  op = zbin_len( op, lit - 15 );
+	}
+	memcpy( op, anchor, lit );
+	op = op + lit;
+	return( op - dst );
+}
+// Decompresses the n bytes at src into exactly size bytes at dst. It
+// returns -1 if src is not valid.
+static int zbin_unlz( const Zbin_byte *src, size_t n, Zbin_byte *dst, size_t size ) {
+	size_t          lit, len, off;
+	Zbin_byte       *op, *oend;
+	const Zbin_byte *ip, *end, *ref;
+
+	ip = src;
+	end = src + n;
+	op = dst;
+	oend = dst + size;
+	while( ip < end ) {
+	  lit = *ip >> 4;
+	  len = ( *ip++ & 15 ) + ZBIN_MINMATCH;
+	  if( lit == 15 && ( ip = zbin_getlen( ip, end, &lit ) ) == NULL ) {
+	    return( -1 );
+	  }
+	  if( lit > ( size_t ) ( end - ip ) || lit > ( size_t ) ( oend - op ) ) {
+	    return( -1 );
+	  }
+	  if( lit <= 16 && end - ip >= 16 && oend - op >= 16 ) {
+	    memcpy( op, ip, 16 ); // Short literals, in one move.
+	  }
+	  else {
+	    memcpy( op, ip, lit );
+	  }
+	  op = op + lit;
+	  ip = ip + lit;
+	  if( ip == end ) { // The last sequence.
+	    break;
+	  }
+	  if( end - ip < 2 ) {
+	    return( -1 );
+	  }
+	  off = ip[0] | ( ip[1] << 8 );
+	  ip = ip + 2;
+	  if( len == 15 + ZBIN_MINMATCH && ( ip = zbin_getlen( ip, end, &len ) ) == NULL ) {
+	    return( -1 );
+	  }
+	  if( off == 0 || off > ( size_t ) ( op - dst ) || len > ( size_t ) ( oend - op ) ) {
+	    return( -1 );
+	  }
+	  ref = op - off;
+	  if( off >= 16 && ( size_t ) ( oend - op ) >= len + 16 ) {
+	    for( lit = 0; lit < len; lit = lit + 16 ) { // May copy past len.
+	      memcpy( op + lit, ref + lit, 16 );
+	    }
+	  }
+	  else if( off >= len ) {
+	    memcpy( op, ref, len );
+	  }
+	  else if( off == 1 ) { // A run of one byte.
+	    memset( op, *ref, len );
+	  }
+	  else {
+	    while( ref + len > op ) { // Copies of the overlapping part.
+	      memcpy( op, ref, off );
+	      op = op + off;
+	      len = len - off;
+	    }
+	    memcpy( op, ref, len );
+	  }
+	  op = op + len;
+	}
+	return( op == oend ? 0 : -1 );
+}
+
+// Splits the nr * m elements of rows A[0], ..., A[nr - 1] into byte
+// planes at s (byte b of element t at s[( 7 - b ) * nr * m + t]),
+// ZBIN_BLOCK elements at a time.
+static void zbin_pack( double **A, int nr, int m, int filter, Zbin_byte *s ) {
+	int       i, j, b, k, nb;
+	size_t    t, nv;
+	uint64_t  prev, w[ZBIN_BLOCK];
+	Zbin_byte *q;
+
+	nv = ( size_t ) nr * m;
+	prev = 0;
+	i = j = 0;
+	for( t = 0; t < nv; t = t + nb ) {
+	  nb = ( nv - t < ZBIN_BLOCK ) ? nv - t : ZBIN_BLOCK;
+	  for( k = 0; k < nb; k++ ) {
+	    memcpy( w + k, A[i] + j, sizeof( uint64_t ) );
+	    if( ++j == m ) {
+	      i++;
+	      j = 0;
+	    }
+	  }
+	  for( k = 0; k < nb && filter == ZBIN_XOR; k++ ) {
+	    w[k] = w[k] ^ prev;
+	    prev = prev ^ w[k];
+	  }
+	  for( b = 0; b < 8; b++ ) {
+	    q = s + ( 7 - b ) * nv + t;
+	    for( k = 0; k < nb; k++ ) {
+	      q[k] = ( Zbin_byte ) ( w[k] >> ( 8 * b ) );
+	    }
+	  }
+	}
+	return;
+}
+// Joins the byte planes at s into the rows A[0], ..., A[nr - 1].
+static void zbin_unpack( const Zbin_byte *s, int nr, int m, int filter, double **A ) {
+	int             i, j, b, k, nb;
+	size_t          t, nv;
+	uint64_t        prev, w[ZBIN_BLOCK];
+	const Zbin_byte *q;
+
+	nv = ( size_t ) nr * m;
+	prev = 0;
+	i = j = 0;
+	for( t = 0; t < nv; t = t + nb ) {
+	  nb = ( nv - t < ZBIN_BLOCK ) ? nv - t : ZBIN_BLOCK;
+	  memset( w, 0, nb * sizeof( uint64_t ) );
+	  for( b = 0; b < 8; b++ ) {
+	    q = s + ( 7 - b ) * nv + t;
+	    for( k = 0; k < nb; k++ ) {
+	      w[k] = w[k] | ( ( uint64_t ) q[k] << ( 8 * b ) );
+	    }
+	  }
+	  for( k = 0; k < nb && filter == ZBIN_XOR; k++ ) {
+	    w[k] = w[k] ^ prev;
+	    prev = w[k];
+	  }
+	  for( k = 0; k < nb; k++ ) {
+	    memcpy( A[i] + j, w + k, sizeof( uint64_t ) );
+	    if( ++j == m ) {
+	      i++;
+	      j = 0;
+	    }
+	  }
+	}
+	return;
+}
+//=====================================================
+//	5.2. WRITING AND READING OF COMPRESSED FILES
+//=====================================================
+/* The header and the index are written in the byte order of the
+   machine which made the file, as in a binary matrix file (see
+   section 1.10); the byte planes do not depend on it.
+*/
+typedef struct {
+	char     magic[8];	// "LILAZMT" and a null character.
+	uint32_t version;	// BIN_VERSION.
+	uint32_t endian;	// BIN_ENDIAN, in the byte order of the file.
+	uint32_t dtype;		// BIN_DOUBLE.
+	uint32_t filter;	// ZBIN_SHUFFLE or ZBIN_XOR.
+	uint64_t n, m;		// Number of rows and columns.
+	uint32_t rows;		// Rows per chunk.
+	uint32_t nchunk;	// Number of chunks.
+	uint64_t index;		// Offset (bytes) of the index.
+	uint64_t reserved;
+} Zbin_head;
+
+typedef struct {
+	int       fd;
+	int       n, m;		// Number of rows and columns.
+	int       rows, nchunk, filter;
+	uint64_t  *index;	// Chunk c is at index[c], ..., index[c + 1] - 1.
+	Zbin_byte *buf;		// Buffer for the stored bytes...
+	Zbin_byte *plane;	// ...and the byte planes of a chunk.
+	Rmat      cache;	// The last chunk read by zbin_rows...
+	int       chunk;	// ...and its number (-1 if none).
+} Zbin;
+
+typedef struct {
+	Zbin      *Z;		// Reading: the file.
+	double    **A;
+	int       n, m, rows, filter;
+	int       c0;		// Writing: first chunk of this round...
+	Zbin_byte **buf;	// ...two buffers per chunk of the round...
+	size_t    *len;		// ...and the stored size of each one.
+	int       *err;		// Reading: nonzero for chunks not read.
+} Zbin_arg;
+
+// Rows of chunk c of a n-row matrix in chunks of rows rows.
+static int zbin_nrow( int n, int rows, int c ) {
+	return( ( n - c * rows < rows ) ? n - c * rows : rows );
+}
+// Reads chunk c of Z into the rows A[0], ..., with buf and plane for
+// the stored bytes and the byte planes.
+static int zbin_chunk( Zbin *Z, int c, Zbin_byte *buf, Zbin_byte *plane, double **A ) {
+	int    nr;
+	size_t size, stored;
+
+	nr = zbin_nrow( Z->n, Z->rows, c );
+	size = ( size_t ) nr * Z->m * sizeof( double );
+	stored = Z->index[c + 1] - Z->index[c];
+	if( stored == size ) { // Stored as its byte planes.
+	  buf = plane;
+	}
+	if( pread( Z->fd, buf, stored, Z->index[c] ) != ( ssize_t ) stored
+	    || ( stored < size && zbin_unlz( buf, stored, plane, size ) != 0 ) ) {
+	  return( -1 );
+	}
+	zbin_unpack( plane, nr, Z->m, Z->filter, A );
+	return( 0 );
+}
+
+static void zbin_put_task( int k, void *arg ) {
+	Zbin_arg *a = ( Zbin_arg* ) arg;
+	int      nr, c;
+	size_t   size;
+
+	c = a->c0 + k;
+	nr = zbin_nrow( a->n, a->rows, c );
+	size = ( size_t ) nr * a->m * sizeof( double );
+	zbin_pack( a->A + ( size_t ) c * a->rows, nr, a->m, a->filter, a->buf[2 * k] );
+	a->len[k] = zbin_lz( a->buf[2 * k], size, a->buf[2 * k + 1], size - 1 );
+	if( a->len[k] == 0 ) { // It does not get smaller.
+	  memcpy( a->buf[2 * k + 1], a->buf[2 * k], size );
+	  a->len[k] = size;
+	}
+	return;
+}
+
+static void zbin_get_task( int c, void *arg ) {
+	Zbin_arg  *a = ( Zbin_arg* ) arg;
+	size_t    size;
+	Zbin_byte *buf;
+
+	size = ( size_t ) a->rows * a->m * sizeof( double );
+	buf = ( Zbin_byte* ) malloc( 2 * size );
+	if( buf == NULL
+	    || zbin_chunk( a->Z, c, buf, buf + size, a->A + ( size_t ) c * a->rows ) != 0 ) {
+	  a->err[c] = 1;
+	}
+	free( buf );
+	return;
+}
+
+/* This function writes a n-X-m 'double' matrix A into a compressed
+   file inside the folder "files", with the filter ZBIN_SHUFFLE or
+   ZBIN_XOR (better for matrices whose neighbouring elements are equal
+   or close, e.g. smooth fields). The chunks are compressed by the
+   thread pool, if it runs (see tpool_init). It returns -1 if the
+   filter is not valid, or if the file or the memory is not available.
+*/
+int zbin_out_rmat( int n, int m, double **A, int filter, char filename[] ) {
+	FILE      *file;
+	int       k, nbuf, nchunk, flag;
+	char      *path;
+	size_t    size;
+	uint64_t  *index;
+	Zbin_arg  a;
+	Zbin_head H;
+
+	if( filter != ZBIN_SHUFFLE && filter != ZBIN_XOR ) {
+	  return( -1 );
+	}
+	memset( &H, 0, sizeof( H ) );
+	memcpy( H.magic, "LILAZMT", 8 );
+	H.version = BIN_VERSION;
+	H.endian = BIN_ENDIAN;
+	H.dtype = BIN_DOUBLE;
+	H.filter = filter;
+	H.n = n;
+	H.m = m;
+	a.n = n;
+	a.m = m;
+	a.A = A;
+	a.filter = filter;
+	a.rows = ( m > 0 && ZBIN_CHUNK / ( m * sizeof( double ) ) > 1 )
+	         ? ZBIN_CHUNK / ( m * sizeof( double ) ) : 1;
+	a.rows = ( n > 0 && a.rows > n ) ? n : a.rows;
+	H.rows = a.rows;
+	nchunk = ( m > 0 ) ? ( n + a.rows - 1 ) / a.rows : 0;
+	H.nchunk = nchunk;
+	size = ( size_t ) a.rows * m * sizeof( double );
+	nbuf = tpool_par() ? 2 * tpool_size() : 1;
+	nbuf = ( nbuf < nchunk ) ? nbuf : ( nchunk > 0 ? nchunk : 1 );
+
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	file = fopen( path, "wb" );
+	free_chvec( &path );
+	if( file == NULL ) {
+	  return( -1 );
+	}
+
+	a.buf = ( Zbin_byte** ) calloc( 2 * nbuf, sizeof( Zbin_byte* ) );
+	a.len = ( size_t* ) malloc( nbuf * sizeof( size_t ) );
+	index = ( uint64_t* ) malloc( ( nchunk + 1 ) * sizeof( uint64_t ) );
+	flag = ( a.buf == NULL || a.len == NULL || index == NULL ) ? -1 : 0;
+	for( k = 0; flag == 0 && k < 2 * nbuf; k++ ) {
+	  a.buf[k] = ( Zbin_byte* ) malloc( size > 0 ? size : 1 );
+	  flag = ( a.buf[k] == NULL ) ? -1 : flag;
+	}
+	if( flag == 0 ) {
+	  flag = ( fwrite( &H, sizeof( H ), 1, file ) == 1 ) ? 0 : -1;
+	  index[0] = ZBIN_HEAD;
+	}
+
+	for( a.c0 = 0; a.c0 < nchunk && flag == 0; a.c0 = a.c0 + nbuf ) {
+	  k = ( nchunk - a.c0 < nbuf ) ? nchunk - a.c0 : nbuf;
+	  tpool_for( k, zbin_put_task, &a );
+	  for( k = 0; k < nbuf && a.c0 + k < nchunk && flag == 0; k++ ) {
+	    flag = ( fwrite( a.buf[2 * k + 1], 1, a.len[k], file ) == a.len[k] ) ? 0 : -1;
+	    index[a.c0 + k + 1] = index[a.c0 + k] + a.len[k];
+	  }
+	}
+
+	if( flag == 0 ) {
+	  H.index = index[nchunk];
+	  if( fwrite( index, sizeof( uint64_t ), nchunk + 1, file ) != ( size_t ) nchunk + 1
+	      || fseek( file, 0, SEEK_SET ) != 0
+	      || fwrite( &H, sizeof( H ), 1, file ) != 1 ) {
+	    flag = -1;
+	  }
+	}
+	for( k = 0; a.buf != NULL && k < 2 * nbuf; k++ ) {
+	  free( a.buf[k] );
+	}
+	free( a.buf );
+	free( a.len );
+	free( index );
+	if( fclose( file ) != 0 ) {
+	  flag = -1;
+	}
+	return( flag );
+}
+/* This function closes a compressed file Z opened by zbin_open.
+*/
+int zbin_close( Zbin *Z ) {
+	if( Z->fd >= 0 ) {
+	  close( Z->fd );
+	}
+	free( Z->index );
+	free( Z->buf );
+	free( Z->plane );
+	del_rmat( &Z->cache );
+	memset( Z, 0, sizeof( Zbin ) );
+	Z->fd = -1;
+	return( 0 );
+}
+/* This function opens a compressed file inside the folder "files" as
+   Z, whose n and m are the dimensions of its matrix, and reads its
+   index, so any rows can be read (see zbin_rows). The file may come
+   from a machine of the other byte order. It returns -1 if the file
+   is not a valid compressed file.
+*/
+int zbin_open( char filename[], Zbin *Z ) {
+	int       c, swap, flag;
+	char      *path;
+	uint64_t  size;
+	struct    stat st;
+	Zbin_head H;
+
+	memset( Z, 0, sizeof( Zbin ) );
+	Z->chunk = -1;
+	path = file_path( filename );
+	if( path == NULL ) {
+	  Z->fd = -1;
+	  return( -1 );
+	}
+	Z->fd = open( path, O_RDONLY );
+	free_chvec( &path );
+	if( Z->fd < 0 || fstat( Z->fd, &st ) != 0
+	    || pread( Z->fd, &H, sizeof( H ), 0 ) != ( ssize_t ) sizeof( H ) ) {
+	  zbin_close( Z );
+	  return( -1 );
+	}
+
+	swap = ( H.endian == __builtin_bswap32( BIN_ENDIAN ) );
+	if( swap ) {
+	  H.version = __builtin_bswap32( H.version );
+	  H.dtype = __builtin_bswap32( H.dtype );
+	  H.filter = __builtin_bswap32( H.filter );
+	  H.n = __builtin_bswap64( H.n );
+	  H.m = __builtin_bswap64( H.m );
+	  H.rows = __builtin_bswap32( H.rows );
+	  H.nchunk = __builtin_bswap32( H.nchunk );
+	  H.index = __builtin_bswap64( H.index );
+	}
+	flag = ( memcmp( H.magic, "LILAZMT", 8 ) == 0 && H.version == BIN_VERSION
+	         && ( swap || H.endian == BIN_ENDIAN ) && H.dtype == BIN_DOUBLE
+	         && ( H.filter == ZBIN_SHUFFLE || H.filter == ZBIN_XOR )
+	         && H.n <= INT32_MAX && H.m <= INT32_MAX && H.rows > 0
+	         && H.nchunk == ( H.m > 0 ? ( H.n + H.rows - 1 ) / H.rows : 0 )
+	         && H.index >= ZBIN_HEAD && H.index <= ( uint64_t ) st.st_size
+	         && ( st.st_size - H.index ) / sizeof( uint64_t ) > H.nchunk ) ? 0 : -1;
+	if( flag == 0 ) {
+	  Z->index = ( uint64_t* ) malloc( ( H.nchunk + 1 ) * sizeof( uint64_t ) );
+	  size = ( H.nchunk + 1 ) * sizeof( uint64_t );
+	  flag = ( Z->index != NULL
+	           && pread( Z->fd, Z->index, size, H.index ) == ( ssize_t ) size ) ? 0 : -1;
+	}
+	Z->n = H.n;
+	Z->m = H.m;
+	Z->rows = H.rows;
+	Z->nchunk = H.nchunk;
+	Z->filter = H.filter;
+	for( c = 0; c <= Z->nchunk && flag == 0; c++ ) {
+	  Z->index[c] = swap ? __builtin_bswap64( Z->index[c] ) : Z->index[c];
+	  if( c == 0 ) {
+	    flag = ( Z->index[0] == ZBIN_HEAD ) ? 0 : -1;
+	  }
+	  else {
+	    size = ( uint64_t ) zbin_nrow( Z->n, Z->rows, c - 1 ) * Z->m * sizeof( double );
+	    flag = ( Z->index[c] > Z->index[c - 1] && Z->index[c] <= H.index
+	             && Z->index[c] - Z->index[c - 1] <= size ) ? 0 : -1;
+	  }
+	}
+	if( flag != 0 ) {
+	  zbin_close( Z );
+	}
+	return( flag );
+}
+/* This function reads the rows i0, ..., i0 + nr - 1 of the matrix of a
+   compressed file Z into A[0], ..., A[nr - 1]. Only the chunks of
+   those rows are read, and the last one is kept, so the rows of a
+   file can be read in any order. It returns -1 if the rows are not in
+   the matrix, or if the file or the memory is not available.
+*/
+int zbin_rows( Zbin *Z, int i0, int nr, double **A ) {
+	int    i, c, r, k;
+	size_t size;
+
+	if( i0 < 0 || nr < 0 || i0 > Z->n - nr ) {
+	  return( -1 );
+	}
+	size = ( size_t ) Z->rows * Z->m * sizeof( double );
+	if( nr > 0 && Z->buf == NULL ) {
+	  Z->buf = ( Zbin_byte* ) malloc( size );
+	  Z->plane = ( Zbin_byte* ) malloc( size );
+	  if( Z->buf == NULL || Z->plane == NULL
+	      || new_rmat( Z->rows, Z->m, &Z->cache ) != 0 ) {
+	    free( Z->buf );
+	    free( Z->plane );
+	    Z->buf = Z->plane = NULL;
+	    return( -1 );
+	  }
+	}
+
+	for( i = i0; i < i0 + nr; i = i + k ) {
+	  c = i / Z->rows;
+	  r = i - c * Z->rows;
+	  k = zbin_nrow( Z->n, Z->rows, c ) - r;
+	  k = ( k < i0 + nr - i ) ? k : i0 + nr - i;
+	  if( r == 0 && k == zbin_nrow( Z->n, Z->rows, c ) ) { // All the chunk.
+	    if( zbin_chunk( Z, c, Z->buf, Z->plane, A + i - i0 ) != 0 ) {
+	      return( -1 );
+	    }
+	    continue;
+	  }
+	  if( c != Z->chunk ) {
+	    Z->chunk = -1;
+	    if( zbin_chunk( Z, c, Z->buf, Z->plane, Z->cache.row ) != 0 ) {
+	      return( -1 );
+	    }
+	    Z->chunk = c;
+	  }
+	  for( r = 0; r < k; r++ ) {
+	    memcpy( A[i - i0 + r], Z->cache.row[i - c * Z->rows + r], Z->m * sizeof( double ) );
+	  }
+	}
+	return( 0 );
+}
+/* This function sets into n and m the dimensions of the matrix of a
+   compressed or a binary (see bin_dim) file inside the folder "files".
+*/
+int zbin_dim( int *n, int *m, char filename[] ) {
+	Zbin Z;
+
+	if( zbin_open( filename, &Z ) != 0 ) {
+	  return( bin_dim( n, m, filename ) );
+	}
+	*n = Z.n;
+	*m = Z.m;
+	zbin_close( &Z );
+	return( 0 );
+}
+/* This function gets the elements of a n-X-m 'double' matrix A from a
+   compressed file inside the folder "files"; the chunks are read and
+   decompressed by the thread pool, if it runs (see tpool_init). A
+   binary file (see bin_get_rmat) is read as well. It returns -1 if the
+   file is not valid, if it has not n rows and m columns, or if the
+   memory is not available.
+*/
+int zbin_get_rmat( int n, int m, double **A, char filename[] ) {
+	int      c, flag;
+	Zbin     Z;
+	Zbin_arg a;
+
+	if( zbin_open( filename, &Z ) != 0 ) {
+	  return( bin_get_rmat( n, m, A, filename ) );
+	}
+	flag = ( Z.n == n && Z.m == m ) ? 0 : -1;
+	a.err = ( int* ) calloc( Z.nchunk > 0 ? Z.nchunk : 1, sizeof( int ) );
+	flag = ( a.err == NULL ) ? -1 : flag;
+	if( flag == 0 ) {
+	  a.Z = &Z;
+	  a.A = A;
+	  a.m = m;
+	  a.rows = Z.rows;
+	  tpool_for( Z.nchunk, zbin_get_task, &a );
+	  for( c = 0; c < Z.nchunk; c++ ) {
+	    flag = a.err[c] ? -1 : flag;
+	  }
+	}
+	free( a.err );
+	zbin_close( &Z );
+	return( flag );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	6. OUT-OF-CORE ROW PANELS
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/* A panel stream (Pstream) reads a matrix file which may not fit in
+   memory, binary (see bin_out_rmat), compressed (see zbin_out_rmat)
+   or text (see txt_get_rmat), as a
+   sequence of panels of rows consecutive rows each. Only two panels
+   are held: while the caller works on one, a background thread reads
+   the next one into the other.
+*/
+typedef struct {
+	int             bin;		// 1 for a binary file, 2 for a
+					// compressed one, 0 for text.
+	int             n, m;		// Rows (-1 if unknown yet) and columns.
+	int             rows;		// Rows per panel.
+	int             fd;		// Binary file...
+	uint64_t        offset;		// ...and offset of its first element.
+	Zbin            z;		// Compressed file.
+	FILE            *file;		// Text file...
+	char            *text;		// ...and its buffer:
+	size_t          tcap, tlen, tpos;	// size, length and next line.
+	int             eof;
+	Rmat            panel[2];
+	int             first[2], nrow[2];	// First row and number of rows.
+	int             full[2];	// 1 if panel k is ready for the caller.
+	int             held;		// Panel held by the caller, or -1.
+	int             next;		// Panel the caller takes next.
+	int             taken;		// Panels taken by the caller.
+	int             row;		// Next row the thread reads.
+	int             stop;
+	int             running;	// 1 while the thread was not joined.
+	pthread_t       thread;
+	pthread_mutex_t lock;
+	pthread_cond_t  done;
+} Pstream;
+
+// The next line of a text stream, from *p to *eol (*p = NULL at the
+// end of the file). It is not consumed: P->tpos must be moved past it.
+static int pstream_line( Pstream *P, const char **p, const char **eol ) {
+	char   *big;
+	size_t got;
+
+	for( ; ; ) {
+	  *p = P->text + P->tpos;
+	  *eol = ( const char* ) memchr( *p, '\n', P->tlen - P->tpos );
+	  if( *eol != NULL || ( P->eof && P->tpos < P->tlen ) ) {
+	    *eol = ( *eol != NULL ) ? *eol : P->text + P->tlen;
+	    return( 0 );
+	  }
+	  if( P->eof ) {
+	    *p = NULL;
+	    return( 0 );
+	  }
+	  memmove( P->text, P->text + P->tpos, P->tlen - P->tpos );
+	  P->tlen = P->tlen - P->tpos;
+	  P->tpos = 0;
+	  if( P->tlen == P->tcap ) { // A line longer than the buffer.
+	    big = ( char* ) realloc( P->text, 2 * P->tcap );
+	    if( big == NULL ) {
+	      return( -1 );
+	    }
+	    P->text = big;
+	    P->tcap = 2 * P->tcap;
+	  }
+	  got = fread( P->text + P->tlen, 1, P->tcap - P->tlen, P->file );
+	  P->tlen = P->tlen + got;
+	  P->eof = ( got == 0 );
+	}
+}
+
+// Reads the next panel into panel k; nrow[k] is set to 0 at the end of
+// the file, and to -1 if the file cannot be read.
+static void pstream_fill( Pstream *P, int k ) {
+	int        nr;
+	size_t     bytes;
+	const char *p, *eol;
+
+	P->first[k] = P->row;
+	if( P->bin ) {
+	  nr = ( P->n - P->row < P->rows ) ? P->n - P->row : P->rows;
+	  bytes = ( size_t ) nr * P->m * sizeof( double );
+	  if( P->bin == 2 ) {
+	    nr = ( zbin_rows( &P->z, P->row, nr, P->panel[k].row ) == 0 ) ? nr : -1;
+	  }
+	  else if( nr > 0 && pread( P->fd, P->panel[k].val, bytes, P->offset
+	           + ( size_t ) P->row * P->m * sizeof( double ) ) != ( ssize_t ) bytes ) {
+	    nr = -1;
+	  }
+	}
+	else {
+	  for( nr = 0; nr < P->rows; ) {
+	    if( pstream_line( P, &p, &eol ) != 0 ) {
+	      nr = -1;
+	      break;
+	    }
+	    if( p == NULL ) {
+	      P->n = P->row + nr;
+	      break;
+	    }
+	    if( txt_first( p, eol ) < eol ) {
+	      if( txt_line( p, eol, P->m, P->panel[k].row[nr] ) != P->m ) {
+	        nr = -1;
+	        break;
+	      }
+	      nr++;
+	    }
+	    P->tpos = eol - P->text + ( eol < P->text + P->tlen );
+	  }
+	}
+	P->nrow[k] = nr;
+	P->row = P->row + ( nr > 0 ? nr : 0 );
+	return;
+}
+
+// Reads panels ahead of the caller, one while it holds the other.
+static void *pstream_work( void *arg ) {
+	Pstream *P = ( Pstream* ) arg;
+	int     k;
+
+	pthread_mutex_lock( &P->lock );
+	for( k = 0; ; k = 1 - k ) {
+	  while( ( P->full[k] || P->held == k ) && !P->stop ) {
+	    pthread_cond_wait( &P->done, &P->lock );
+	  }
+	  if( P->stop ) {
+	    break;
+	  }
+	  pthread_mutex_unlock( &P->lock );
+	  pstream_fill( P, k );
+	  pthread_mutex_lock( &P->lock );
+	  P->full[k] = 1;
+	  pthread_cond_broadcast( &P->done );
+	  if( P->nrow[k] <= 0 ) { // End of the file, or an error.
+	    break;
+	  }
+	}
+	pthread_mutex_unlock( &P->lock );
+	return( NULL );
+}
+// Starts reading from the first row.
+static int pstream_start( Pstream *P ) {
+	P->row = 0;
+	P->held = -1;
+	P->next = 0;
+	P->taken = 0;
+	P->full[0] = P->full[1] = 0;
+	P->stop = 0;
+	if( !P->bin ) {
+	  P->n = -1;
+	  P->tlen = P->tpos = 0;
+	  P->eof = 0;
+	  if( fseek( P->file, 0, SEEK_SET ) != 0 ) {
+	    return( -1 );
+	  }
+	}
+	P->running = ( pthread_create( &P->thread, NULL, pstream_work, P ) == 0 );
+	return( P->running ? 0 : -1 );
+}
+// Stops the reading thread.
+static void pstream_stop( Pstream *P ) {
+	if( !P->running ) {
+	  return;
+	}
+	P->running = 0;
+	pthread_mutex_lock( &P->lock );
+	P->stop = 1;
+	pthread_cond_broadcast( &P->done );
+	pthread_mutex_unlock( &P->lock );
+	pthread_join( P->thread, NULL );
+	return;
+}
+
+/* This function closes the stream P.
+*/
+int pstream_close( Pstream *P ) {
+	pstream_stop( P );
+	pthread_mutex_destroy( &P->lock );
+	pthread_cond_destroy( &P->done );
+	del_rmat( &P->panel[0] );
+	del_rmat( &P->panel[1] );
+	if( P->file != NULL ) {
+	  fclose( P->file );
+	}
+	free( P->text );
+	if( P->fd >= 0 ) {
+	  close( P->fd );
+	}
+	if( P->bin == 2 ) {
+	  zbin_close( &P->z );
+	}
+	memset( P, 0, sizeof( Pstream ) );
+	return( 0 );
+}
+/* This function opens a matrix file inside the folder "files" as a
+   stream P of panels of rows rows, and starts reading the first one.
+   A binary or compressed file is recognized by its header; otherwise,
+   the file is read as text, with as many columns as numbers in its
+   first line, and its number of rows is known (P->n) only once the
+   last panel is read.
+   It returns -1 if the file or the memory is not available.
+*/
+int pstream_open( char filename[], int rows, Pstream *P ) {
+	int        swap;
+	char       *path;
+	const char *p, *eol;
+	struct     stat st;
+	Bin_head   H;
+
+	memset( P, 0, sizeof( Pstream ) );
+	P->rows = ( rows > 0 ) ? rows : 1;
+	P->fd = -1;
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	if( zbin_open( filename, &P->z ) == 0 ) {
+	  P->bin = 2;
+	  P->n = P->z.n;
+	  P->m = P->z.m;
+	}
+	else if( ( P->fd = open( path, O_RDONLY ) ) >= 0 && fstat( P->fd, &st ) == 0
+	         && pread( P->fd, &H, sizeof( H ), 0 ) == ( ssize_t ) sizeof( H )
+	         && bin_check( &H, st.st_size, &swap ) == 0 && !swap ) {
+	  P->bin = 1;
+	  P->n = H.n;
+	  P->m = H.m;
+	  P->offset = H.offset;
+	}
+	else {
+	  if( P->fd >= 0 ) {
+	    close( P->fd );
+	  }
+	  P->fd = -1;
+	  P->file = fopen( path, "rb" );
+	  P->tcap = TXT_BLOCK;
+	  P->text = ( char* ) malloc( P->tcap );
+	  P->m = -1;
+	  while( P->file != NULL && P->text != NULL
+	         && pstream_line( P, &p, &eol ) == 0 && p != NULL ) {
+	    if( txt_first( p, eol ) < eol ) {
+	      P->m = txt_line( p, eol, 0, NULL );
+	      break;
+	    }
+	    P->tpos = eol - P->text + ( eol < P->text + P->tlen );
+	  }
+	  P->m = ( P->m < 0 && P->file != NULL && P->text != NULL && p == NULL ) ? 0 : P->m;
+	}
+	free_chvec( &path );
+
+	if( P->m < 0 || new_rmat( P->rows, P->m, &P->panel[0] ) != 0 ) {
+	  P->m = -1;
+	}
+	else if( new_rmat( P->rows, P->m, &P->panel[1] ) != 0 ) {
+	  del_rmat( &P->panel[0] );
+	  P->m = -1;
+	}
+	if( P->m < 0 ) {
+	  if( P->file != NULL ) {
+	    fclose( P->file );
+	  }
+	  free( P->text );
+	  if( P->fd >= 0 ) {
+	    close( P->fd );
+	  }
+	  if( P->bin == 2 ) {
+	    zbin_close( &P->z );
+	  }
+	  return( -1 );
+	}
+	pthread_mutex_init( &P->lock, NULL );
+	pthread_cond_init( &P->done, NULL );
+	if( pstream_start( P ) != 0 ) {
+	  pstream_close( P );
+	  return( -1 );
+	}
+	return( 0 );
+}
+/* This function gives the next panel of the stream P: its i0 = first
+   row, its rows (the return value) and its matrix A (of P->m columns),
+   which is valid until the next call. The panel given before is
+   released. It returns 0 after the last panel, and -1 if the file
+   cannot be read.
+*/
+int pstream_next( Pstream *P, int *i0, double ***A ) {
+	int k, nr;
+
+	pthread_mutex_lock( &P->lock );
+	if( P->held >= 0 ) {
+	  P->full[P->held] = 0;
+	  P->held = -1;
+	  pthread_cond_broadcast( &P->done );
+	}
+	k = P->next;
+	while( !P->full[k] ) {
+	  pthread_cond_wait( &P->done, &P->lock );
+	}
+	nr = P->nrow[k];
+	if( nr > 0 ) {
+	  P->held = k;
+	  P->next = 1 - k;
+	}
+	pthread_mutex_unlock( &P->lock );
+	P->taken++;
+
+	*i0 = P->first[k];
+	*A = P->panel[k].row;
+	return( nr );
+}
+/* This function starts the stream P again from its first row (if some
+   panel was taken already).
+*/
+int pstream_rewind( Pstream *P ) {
+	if( P->taken == 0 && P->running ) {
+	  return( 0 );
+	}
+	pstream_stop( P );
+	return( pstream_start( P ) );
+}
 
 /*
 int main() {
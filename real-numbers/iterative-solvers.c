@@ -0,0 +1,1452 @@
+#include "sparse-matrices.c"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	1. LINEAR OPERATORS AND PRECONDITIONERS
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//=====================================================
+//	1.1. LINEAR OPERATORS
+//=====================================================
+/* The iterative solvers below need a n-X-n matrix A only through the
+   products y = A * x, so A may be a sparse matrix, a dense one or a
+   function which computes the product (a matrix-free operator, e.g. a
+   stencil). A Lop keeps one of the three.
+*/
+typedef struct {
+	int    n;		// Order of the operator.
+	Smat   *S;		// A sparse matrix,
+	double **A;		// or a dense one,
+	int    ( *mv )( void *arg, double *x, double *y );	// or y = A * x
+	void   *arg;		// by mv( arg, x, y ).
+} Lop;
+
+/* This function makes L the operator of the n-X-n sparse matrix S.
+   It returns -1 if S is not square.
+*/
+int smat_lop( Smat *S, Lop *L ) {
+	L->n = S->n;
+	L->S = S;
+	L->A = NULL;
+	L->mv = NULL;
+	L->arg = NULL;
+
+	return( ( S->n == S->m ) ? 0 : -1 );
+}
+/* This function makes L the operator of a n-X-n dense matrix A.
+*/
+int rmat_lop( int n, double **A, Lop *L ) {
+	L->n = n;
+	L->S = NULL;
+	L->A = A;
+	L->mv = NULL;
+	L->arg = NULL;
+
+	return( 0 );
+}
+/* This function makes L the operator y = A * x of order n computed by
+   mv( arg, x, y ), which returns 0 (or -1 if it fails).
+*/
+int fun_lop( int n, int ( *mv )( void *arg, double *x, double *y ), void *arg,
+             Lop *L ) {
+	L->n = n;
+	L->S = NULL;
+	L->A = NULL;
+	L->mv = mv;
+	L->arg = arg;
+
+	return( 0 );
+}
+/* This function sets y = A * x for the operator L of A.
+*/
+int lop_apply( Lop *L, double *x, double *y ) {
+	if( L->S != NULL ) {
+	  return( spmv_smat( 'N', 1, L->S, x, 0, y ) );
+	}
+	if( L->A != NULL ) {
+	  return( gemv_rmat( 'N', L->n, L->n, 1, L->A, x, 1, 0, y, 1 ) );
+	}
+	return( L->mv( L->arg, x, y ) );
+}
+// The rows of an operator L as a sparse matrix in the format 'R': S
+// itself, if it has that format or if L is symmetric (sym = 1), since
+// the arrays of S in the format 'C' are the ones of transpose( S ) =
+// S; or a new matrix (*tmp = 1).
+static int lop_rows( Lop *L, int sym, Smat *R, int *tmp ) {
+	*tmp = 0;
+	if( L->S != NULL && ( sym || L->S->format == 'R' ) ) {
+	  *R = *L->S;
+	  R->format = 'R';
+	  return( 0 );
+	}
+	if( L->S == NULL && L->A == NULL ) {
+	  return( -1 );
+	}
+	*tmp = 1;
+	if( L->S != NULL ) {
+	  return( conv_smat( L->S, 'R', R ) );
+	}
+	return( dense_smat( L->n, L->n, L->A, 0, 'R', R ) );
+}
+//=====================================================
+//	1.2. PRECONDITIONERS
+//=====================================================
+/* A preconditioner M of a matrix A is a matrix close to A for which
+   M * z = r is cheap to solve. For any A:
+
+   - PREC_JACOBI: M = D, the diagonal of A;
+   - PREC_ILU0: M = L * U, where L (unit lower triangular) and U are
+     the incomplete LU factors of A with the pattern of A, ILU(0).
+
+   For a symmetric positive definite A:
+
+   - PREC_SSOR: M = ( D / w + L ) * ( D / w )^-1 * ( D / w + L )^T
+     * w / ( 2 - w ), where L is the strict lower triangle of A and
+     0 < w < 2 (symmetric successive over-relaxation);
+   - PREC_IC0: M = C * C^T, where C is the incomplete Cholesky factor
+     of A with the pattern of its lower triangle, IC(0). If some pivot
+     is not positive, the factorization is made again for A plus a
+     growing multiple of D (T. A. Manteuffel, Math. Comp. 1980).
+
+   SSOR and IC(0) keep a lower triangular matrix T in the format 'R',
+   with the diagonal element last in each row, and M^-1 * r is
+   s * T^-T * W * T^-1 * r, where W is a diagonal (D / w for SSOR)
+   and s a scalar. The rows of T are used for T^-1 and, as columns of
+   T^T, for T^-T, so no transpose is kept. ILU(0) keeps L and U in the
+   rows of one matrix T, and the place of the diagonal element of each
+   row. The triangular solves run on one thread. The matrix must be
+   sparse or dense: a matrix-free operator takes only PREC_NONE, or a
+   PREC_FUN, which solves M * z = r by a function (see fun_prec), e.g.
+   a multigrid cycle (see mg_prec).
+*/
+#define PREC_NONE	0	// M = I.
+#define PREC_JACOBI	1
+#define PREC_SSOR	2
+#define PREC_IC0	3
+#define PREC_ILU0	4
+#define PREC_FUN	5	// z = M^-1 * r computed by a function.
+
+#define IC0_TRIES	12	// Factorizations tried with growing shifts.
+
+typedef struct {
+	int    kind;	// PREC_NONE, PREC_JACOBI, PREC_SSOR, PREC_IC0, PREC_ILU0 or PREC_FUN.
+	int    n;
+	double *d;	// Jacobi: 1 / D. SSOR: W = D / w.
+	double s;	// Scale of T^-T * W * T^-1.
+	Smat   T;	// SSOR and IC(0): the lower triangular factor. ILU(0): L and U.
+	int    *dg;	// ILU(0): place of the diagonal element of each row of T.
+	int    ( *fun )( void *arg, double *r, double *z );	// PREC_FUN: z = M^-1 * r
+	void   *arg;	// by fun( arg, r, z ).
+} Prec;
+
+// The lower triangle of A (in the format 'R'), with the diagonal
+// element last in each row, into T; diagonal elements must not be 0,
+// and must be > 0 if pos = 1 (SSOR and IC(0), whose M must be positive
+// definite for pcg_solve).
+static int prec_low( Smat *A, int pos, Smat *T ) {
+	int i, k, p;
+
+	if( alloc_smat( A->n, A->n, A->nnz, 'R', T ) != 0 ) {
+	  return( -1 );
+	}
+	p = 0;
+	for( i = 0; i < A->n; i++ ) {
+	  for( k = A->ptr[i]; k < A->ptr[i + 1] && A->ind[k] <= i; k++ ) {
+	    T->ind[p] = A->ind[k];
+	    T->val[p++] = A->val[k];
+	  }
+	  T->ptr[i + 1] = p;
+	  if( p == T->ptr[i] || T->ind[p - 1] != i || T->val[p - 1] == 0
+	      || ( pos && !( T->val[p - 1] > 0 ) ) ) {
+	    free_smat( T );
+	    return( -1 );
+	  }
+	}
+	T->nnz = p;
+	return( 0 );
+}
+
+// IC(0) of the lower triangle T (shifted by shift * D) into C, with the
+// pattern of T; it returns -1 if some pivot is not positive. Row i is
+// found from the rows k < i: C(i,k) = ( T(i,k) - C(i,:k) * C(k,:k) )
+// / C(k,k), the sums running over the common pattern of both rows.
+static int prec_ic0( Smat *T, double shift, Smat *C ) {
+	int    i, k, p, q, r, c;
+	double s;
+
+	for( i = 0; i < T->n; i++ ) {
+	  for( p = T->ptr[i]; p < T->ptr[i + 1]; p++ ) {
+	    k = T->ind[p];
+	    s = T->val[p] * ( ( k == i ) ? 1 + shift : 1 );
+	    q = T->ptr[i];
+	    r = C->ptr[k];
+	    while( q < p && r < C->ptr[k + 1] - 1 ) { // Row k, no diagonal.
+	      c = T->ind[q] - C->ind[r];
+	      if( c == 0 ) {
+	        s = s - C->val[q] * C->val[r];
+	      }
+	      q = q + ( c <= 0 );
+	      r = r + ( c >= 0 );
+	    }
+	    if( k < i ) {
+	      C->val[p] = s / C->val[C->ptr[k + 1] - 1];
+	    }
+	    else if( s > 0 ) {
+	      C->val[p] = sqrt( s );
+	    }
+	    else {
+	      return( -1 );
+	    }
+	  }
+	}
+	return( 0 );
+}
+
+// ILU(0) of the rows T, in place, with the pattern of T; dg[i] is the
+// place of T(i,i). Row i takes, for each k < i in it, in order, T(i,k)
+// = T(i,k) / T(k,k), and minus T(i,k) times the part of row k past the
+// diagonal, where both patterns meet; w[j] is the place of column j in
+// row i, or -1. It returns -1 if some pivot is zero.
+static int prec_ilu0( Smat *T, int *dg, int *w ) {
+	int i, j, k, p, q, flag;
+
+	for( j = 0; j < T->n; j++ ) {
+	  w[j] = -1;
+	}
+	flag = 0;
+	for( i = 0; i < T->n && flag == 0; i++ ) {
+	  for( p = T->ptr[i]; p < T->ptr[i + 1]; p++ ) {
+	    w[T->ind[p]] = p;
+	  }
+	  for( p = T->ptr[i]; p < dg[i]; p++ ) {
+	    k = T->ind[p];
+	    T->val[p] = T->val[p] / T->val[dg[k]];
+	    for( q = dg[k] + 1; q < T->ptr[k + 1]; q++ ) {
+	      if( w[T->ind[q]] >= 0 ) {
+	        T->val[w[T->ind[q]]] = T->val[w[T->ind[q]]] - T->val[p] * T->val[q];
+	      }
+	    }
+	  }
+	  flag = ( T->val[dg[i]] == 0 ) ? -1 : 0;
+	  for( p = T->ptr[i]; p < T->ptr[i + 1]; p++ ) {
+	    w[T->ind[p]] = -1;
+	  }
+	}
+	return( flag );
+}
+
+/* This function sets free a preconditioner M.
+*/
+int free_prec( Prec *M ) {
+	free( M->d );
+	free( M->dg );
+	M->d = NULL;
+	M->dg = NULL;
+	if( M->T.ptr != NULL ) {
+	  free_smat( &M->T );
+	}
+	M->kind = PREC_NONE;
+
+	return( 0 );
+}
+/* This function sets up into M a preconditioner of a given kind (see
+   above) for the operator A; omega is the relaxation factor w of
+   PREC_SSOR (e.g. 1), and is not used by the others. M must be set
+   free by free_prec. It returns -1 if the kind is not valid for A, if
+   some diagonal element of A (or pivot of ILU(0)) is zero, or not
+   positive for PREC_SSOR and PREC_IC0, or if memory is not available.
+*/
+int new_prec( int kind, Lop *A, double omega, Prec *M ) {
+	int    i, k, tmp, flag, *w;
+	double shift;
+	Smat   R, T;
+
+	M->kind = kind;
+	M->n = A->n;
+	M->d = NULL;
+	M->dg = NULL;
+	M->s = 1;
+	M->fun = NULL;
+	M->arg = NULL;
+	M->T.ptr = M->T.ind = NULL;
+	M->T.val = NULL;
+	M->T.n = M->T.m = M->T.nnz = 0;
+	if( kind == PREC_NONE ) {
+	  return( 0 );
+	}
+	if( ( kind != PREC_JACOBI && kind != PREC_SSOR && kind != PREC_IC0
+	      && kind != PREC_ILU0 ) || ( kind == PREC_SSOR && !( omega > 0 && omega < 2 ) )
+	    || lop_rows( A, kind != PREC_ILU0, &R, &tmp ) != 0 ) {
+	  return( -1 );
+	}
+	if( kind == PREC_ILU0 ) {
+	  if( tmp ) { // R is a copy already.
+	    M->T = R;
+	    flag = 0;
+	  }
+	  else {
+	    flag = conv_smat( &R, 'R', &M->T );
+	  }
+	  M->dg = ( int* ) malloc( ( M->n > 0 ? M->n : 1 ) * sizeof( int ) );
+	  w = ( int* ) malloc( ( M->n > 0 ? M->n : 1 ) * sizeof( int ) );
+	  flag = ( M->dg == NULL || w == NULL ) ? -1 : flag;
+	  for( i = 0; i < M->n && flag == 0; i++ ) {
+	    k = M->T.ptr[i];
+	    while( k < M->T.ptr[i + 1] && M->T.ind[k] < i ) {
+	      k++;
+	    }
+	    M->dg[i] = k;
+	    flag = ( k < M->T.ptr[i + 1] && M->T.ind[k] == i ) ? 0 : -1;
+	  }
+	  if( flag == 0 ) {
+	    flag = prec_ilu0( &M->T, M->dg, w );
+	  }
+	  free( w );
+	  if( flag != 0 ) {
+	    free_prec( M );
+	  }
+	  return( flag );
+	}
+	flag = prec_low( &R, kind != PREC_JACOBI, &T );
+	if( tmp ) {
+	  free_smat( &R );
+	}
+	if( flag != 0 ) {
+	  return( -1 );
+	}
+
+	if( kind == PREC_IC0 ) {
+	  flag = conv_smat( &T, 'R', &M->T );
+	  for( k = 0, shift = 0; flag == 0 && k < IC0_TRIES; k++ ) {
+	    if( prec_ic0( &T, shift, &M->T ) == 0 ) {
+	      break;
+	    }
+	    shift = ( shift == 0 ) ? 1e-3 : 2 * shift;
+	  }
+	  flag = ( k < IC0_TRIES ) ? flag : -1;
+	  free_smat( &T );
+	  if( flag != 0 ) {
+	    free_prec( M );
+	  }
+	  return( flag );
+	}
+
+	if( alloc_rvec( M->n > 0 ? M->n : 1, &M->d ) != 0 ) {
+	  free_smat( &T );
+	  return( -1 );
+	}
+	for( i = 0; i < M->n; i++ ) {
+	  k = T.ptr[i + 1] - 1;
+	  M->d[i] = ( kind == PREC_JACOBI ) ? 1 / T.val[k] : T.val[k] / omega;
+	  T.val[k] = T.val[k] / omega;
+	}
+	if( kind == PREC_JACOBI ) {
+	  free_smat( &T );
+	}
+	else {
+	  M->T = T;
+	  M->s = ( 2 - omega ) / omega;
+	}
+	return( 0 );
+}
+/* This function makes M the preconditioner of order n (PREC_FUN) which
+   solves M * z = r by fun( arg, r, z ), which returns 0 (or -1 if it
+   fails). For CG, fun must be a symmetric positive definite operator.
+*/
+int fun_prec( int n, int ( *fun )( void *arg, double *r, double *z ), void *arg,
+              Prec *M ) {
+	M->kind = PREC_FUN;
+	M->n = n;
+	M->d = NULL;
+	M->dg = NULL;
+	M->s = 1;
+	M->fun = fun;
+	M->arg = arg;
+	M->T.ptr = M->T.ind = NULL;
+	M->T.val = NULL;
+	M->T.n = M->T.m = M->T.nnz = 0;
+
+	return( 0 );
+}
+/* This function solves M * z = r for the preconditioner M; z may be r.
+*/
+int apply_prec( Prec *M, double *r, double *z ) {
+	int    i, k, n, *ptr, *ind;
+	double *val;
+
+	n = M->n;
+	if( M->kind == PREC_FUN ) {
+	  return( M->fun( M->arg, r, z ) );
+	}
+	if( M->kind == PREC_NONE || M->kind == PREC_JACOBI ) {
+	  for( i = 0; i < n; i++ ) {
+	    z[i] = ( M->kind == PREC_NONE ) ? r[i] : M->d[i] * r[i];
+	  }
+	  return( 0 );
+	}
+
+	ptr = M->T.ptr;
+	ind = M->T.ind;
+	val = M->T.val;
+	if( M->kind == PREC_ILU0 ) {
+	  for( i = 0; i < n; i++ ) { // L * y = r.
+	    k = M->dg[i];
+	    z[i] = r[i] - smat_dot_c( k - ptr[i], val + ptr[i], ind + ptr[i], z );
+	  }
+	  for( i = n - 1; i >= 0; i-- ) { // U * z = y.
+	    k = M->dg[i];
+	    z[i] = ( z[i] - smat_dot_c( ptr[i + 1] - k - 1, val + k + 1, ind + k + 1, z ) )
+	           / val[k];
+	  }
+	  return( 0 );
+	}
+	for( i = 0; i < n; i++ ) { // T * y = r, by rows.
+	  k = ptr[i + 1] - 1;
+	  z[i] = ( r[i] - smat_dot_c( k - ptr[i], val + ptr[i], ind + ptr[i], z ) )
+	         / val[k];
+	}
+	if( M->d != NULL ) {
+	  for( i = 0; i < n; i++ ) {
+	    z[i] = M->d[i] * z[i];
+	  }
+	}
+	for( i = n - 1; i >= 0; i-- ) { // T^T * z = W * y, by columns.
+	  k = ptr[i + 1] - 1;
+	  z[i] = z[i] / val[k];
+	  smat_axpy_c( k - ptr[i], -z[i], val + ptr[i], ind + ptr[i], z );
+	}
+	if( M->s != 1 ) {
+	  simd.scale( n, M->s, z, z );
+	}
+	return( 0 );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	2. KRYLOV SOLVERS
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/* The solvers take their options from, and report back into, an Iter:
+   they stop when ||b - A * x|| <= tol * ||b||, or after maxit
+   iterations. If hist is not NULL, hist[k] is set to the relative
+   residual ||b - A * x|| / ||b|| after k iterations (k = 0, ...,
+   iter), so it must have room for maxit + 1 numbers.
+*/
+typedef struct {
+	int    maxit;	// Largest number of iterations.
+	double tol;	// Relative residual wanted.
+	int    fused;	// 1 to fuse the vector passes (see pcg_solve).
+	double *hist;	// Relative residual of each iteration, or NULL.
+	int    iter;	// Iterations done.
+	double res;	// Relative residual reached.
+} Iter;
+
+//=====================================================
+//	2.1. PRECONDITIONED CONJUGATE GRADIENT
+//=====================================================
+/* Each iteration of CG makes q = A * p, p^T * q, the updates of x and
+   r, z = M^-1 * r, r^T * z and the new p. Each is a pass over the
+   vectors, whose time is bound by the memory traffic when A is sparse.
+   In fused mode, the vectors are cut into blocks, and each thread
+   makes in one pass over its block: q = A * p together with p^T * q;
+   then the updates of x and r, z = M^-1 * r for PREC_NONE and
+   PREC_JACOBI, r^T * z and r^T * r. The partial sums of the blocks are
+   added in the order of the blocks, so the results do not depend on
+   the threads. CG needs a symmetric A, so a sparse matrix is read by
+   rows in either format (see lop_rows).
+*/
+#define CG_PAR		32768	// Unknowns of the smallest parallel solve.
+#define CG_BLOCKS	4	// Blocks per thread.
+
+typedef struct {
+	int    n, nb;		// Unknowns and blocks.
+	Smat   S;		// The rows of a sparse A,
+	double **A;		// or a dense A.
+	Smat_dot *dot;
+	Prec   *M;
+	double alpha, *x, *r, *z, *p, *q;
+	double *part;		// Partial sums: 3 per block.
+} Cg_arg;
+
+// The first row of block b: of about equal work (see smat_split), or
+// of equal size.
+static int cg_split( Cg_arg *a, int b ) {
+	if( a->S.ptr != NULL && b > 0 && b < a->nb ) {
+	  return( smat_split( &a->S, b, a->nb ) );
+	}
+	return( ( int ) ( ( double ) a->n * b / a->nb ) );
+}
+// q = A * p and p^T * q, over the rows of block b.
+static void cg_mvdot( int b, void *arg ) {
+	Cg_arg *a = ( Cg_arg* ) arg;
+	int    i, i1, *ptr;
+	double s;
+
+	ptr = a->S.ptr;
+	s = 0;
+	i1 = cg_split( a, b + 1 );
+	for( i = cg_split( a, b ); i < i1; i++ ) {
+	  if( ptr != NULL ) {
+	    a->q[i] = a->dot( ptr[i + 1] - ptr[i], a->S.val + ptr[i], a->S.ind + ptr[i],
+	                      a->p );
+	  }
+	  else {
+	    a->q[i] = simd.dot( a->n, a->A[i], a->p );
+	  }
+	  s = s + a->p[i] * a->q[i];
+	}
+	a->part[3 * b] = s;
+	return;
+}
+// x = x + alpha * p, r = r - alpha * q, and, for PREC_NONE and
+// PREC_JACOBI, z = M^-1 * r and r^T * z; r^T * r, over block b.
+static void cg_update( int b, void *arg ) {
+	Cg_arg *a = ( Cg_arg* ) arg;
+	int    i, i0, i1, kind;
+	double rz, rr;
+
+	kind = a->M->kind;
+	i0 = cg_split( a, b );
+	i1 = cg_split( a, b + 1 );
+	rz = rr = 0;
+	for( i = i0; i < i1; i++ ) {
+	  a->x[i] = a->x[i] + a->alpha * a->p[i];
+	  a->r[i] = a->r[i] - a->alpha * a->q[i];
+	  rr = rr + a->r[i] * a->r[i];
+	  if( kind == PREC_JACOBI ) {
+	    a->z[i] = a->M->d[i] * a->r[i];
+	    rz = rz + a->r[i] * a->z[i];
+	  }
+	}
+	a->part[3 * b + 1] = ( kind == PREC_NONE ) ? rr : rz;
+	a->part[3 * b + 2] = rr;
+	return;
+}
+// The sum of the partial sums k of the blocks.
+static double cg_sum( Cg_arg *a, int k ) {
+	int    b;
+	double s;
+
+	for( s = 0, b = 0; b < a->nb; b++ ) {
+	  s = s + a->part[3 * b + k];
+	}
+	return( s );
+}
+
+/* This function solves A * x = b by the conjugate gradient method
+   preconditioned by M (see new_prec), for a symmetric positive
+   definite operator A. x holds a first guess on input (e.g. zero).
+   The options and the results are in it (see Iter); with it->fused =
+   1 the vector passes are fused, which saves memory traffic and gives
+   the same iterates up to rounding. It returns 0 if the tolerance is
+   reached, 1 if it is not within it->maxit iterations and -1 if A is
+   not positive definite (as found by CG), if M does not fit A or if
+   memory is not available.
+*/
+int pcg_solve( Lop *A, Prec *M, double *b, double *x, Iter *it ) {
+	int    k, n, flag, tmp;
+	double nb, rz, rz1, pq, rr, *r, *z, *p, *q;
+	Cg_arg a;
+
+	n = A->n;
+	it->iter = 0;
+	it->res = 0;
+	if( M->n != n ) {
+	  return( -1 );
+	}
+	nb = nrm2_rvec( n, b );
+	if( nb == 0 ) {
+	  memset( x, 0, n * sizeof( double ) );
+	  if( it->hist != NULL ) {
+	    it->hist[0] = 0;
+	  }
+	  return( 0 );
+	}
+
+	a.n = n;
+	a.M = M;
+	a.x = x;
+	a.A = A->A;
+	a.dot = smat_dot();
+	a.S.ptr = NULL;
+	tmp = 0;
+	if( it->fused && A->S != NULL ) {
+	  lop_rows( A, 1, &a.S, &tmp );
+	}
+	a.nb = ( tpool_par() && n >= CG_PAR ) ? CG_BLOCKS * tpool_size() : 1;
+	a.part = ( double* ) malloc( 3 * a.nb * sizeof( double ) );
+	r = z = p = q = NULL;
+	flag = ( a.part == NULL || alloc_rvec( n, &r ) != 0 || alloc_rvec( n, &p ) != 0
+	         || alloc_rvec( n, &q ) != 0 ) ? -1 : 0;
+	if( flag == 0 && M->kind != PREC_NONE ) {
+	  flag = alloc_rvec( n, &z );
+	}
+	z = ( M->kind == PREC_NONE ) ? r : z;
+	a.r = r;
+	a.z = z;
+	a.p = p;
+	a.q = q;
+
+	// r = b - A * x, z = M^-1 * r, p = z.
+	if( flag == 0 ) {
+	  flag = lop_apply( A, x, q );
+	}
+	if( flag == 0 ) {
+	  memcpy( r, b, n * sizeof( double ) );
+	  simd.axpby( n, -1, q, 1, r );
+	  rr = simd.dot( n, r, r );
+	  apply_prec( M, r, z );
+	  memcpy( p, z, n * sizeof( double ) );
+	  rz = simd.dot( n, r, z );
+	  it->res = sqrt( rr ) / nb;
+	  if( it->hist != NULL ) {
+	    it->hist[0] = it->res;
+	  }
+	}
+
+	rz1 = 0;
+	for( k = 0; flag == 0 && it->res > it->tol && k < it->maxit; k++ ) {
+	  if( it->fused && A->mv == NULL ) {
+	    tpool_for( a.nb, cg_mvdot, &a );
+	    pq = cg_sum( &a, 0 );
+	  }
+	  else {
+	    flag = lop_apply( A, p, q );
+	    pq = simd.dot( n, p, q );
+	  }
+	  if( flag != 0 || !( pq > 0 ) ) {
+	    flag = -1;
+	    break;
+	  }
+	  a.alpha = rz / pq;
+	  if( it->fused ) {
+	    tpool_for( a.nb, cg_update, &a );
+	    rr = cg_sum( &a, 2 );
+	    rz1 = cg_sum( &a, 1 );
+	  }
+	  else {
+	    simd.axpby( n, a.alpha, p, 1, x );
+	    simd.axpby( n, -a.alpha, q, 1, r );
+	    rr = simd.dot( n, r, r );
+	  }
+	  if( !it->fused || ( M->kind != PREC_NONE && M->kind != PREC_JACOBI ) ) {
+	    apply_prec( M, r, z );
+	    rz1 = simd.dot( n, r, z );
+	  }
+	  it->iter = k + 1;
+	  it->res = sqrt( rr ) / nb;
+	  if( it->hist != NULL ) {
+	    it->hist[k + 1] = it->res;
+	  }
+	  simd.axpby( n, 1, z, rz1 / rz, p ); // p = z + beta * p.
+	  rz = rz1;
+	}
+
+	if( tmp ) {
+	  free_smat( &a.S );
+	}
+	free( a.part );
+	free( r );
+	free( p );
+	free( q );
+	if( z != r ) {
+	  free( z );
+	}
+	if( flag != 0 ) {
+	  return( -1 );
+	}
+	return( ( it->res <= it->tol ) ? 0 : 1 );
+}
+
+//=====================================================
+//	2.2. RESTARTED GMRES
+//=====================================================
+/* GMRES(m) builds an orthonormal basis v_0, ..., v_j of the Krylov
+   space of A * M^-1 (M on the right, so the residual it minimizes is
+   the one of the system), and takes the x whose residual is least in
+   that space. The basis vectors are the rows of a (m + 1)-X-n matrix
+   V, so the new vector w is made orthogonal to all of them by blocked
+   classical Gram-Schmidt: h = V * w, then w = w - transpose( V ) * h,
+   two matrix-vector products (gemv_rmat) instead of j dot products
+   and j updates one after the other. That is made twice (CGS2: the
+   second pass fixes the loss of orthogonality of the first one, W.
+   Hoffmann 1989). The Hessenberg matrix is made triangular by Givens
+   rotations as it grows, which gives the residual norm at each step.
+   After m steps (or when the tolerance is reached), x is updated and
+   the method starts again from it.
+*/
+/* This function solves A * x = b by GMRES(m) preconditioned on the
+   right by M (see new_prec), for any nonsingular operator A. x holds a
+   first guess on input. Each iteration is one product by A (it->fused
+   is not used). It returns 0 if the tolerance is reached, 1 if it is
+   not within it->maxit iterations and -1 if m < 1, if M does not fit
+   A or if memory is not available.
+*/
+int gmres_solve( Lop *A, Prec *M, int m, double *b, double *x, Iter *it ) {
+	int    i, j, k, n, pass, flag;
+	double nb, beta, h, t, *c, *sn, *g, *y, *z, *w;
+	double **H;	// H[j]: column j of the Hessenberg matrix.
+	Rmat   V;
+
+	n = A->n;
+	it->iter = 0;
+	it->res = 0;
+	if( m < 1 || M->n != n ) {
+	  return( -1 );
+	}
+	nb = nrm2_rvec( n, b );
+	if( nb == 0 ) {
+	  memset( x, 0, n * sizeof( double ) );
+	  if( it->hist != NULL ) {
+	    it->hist[0] = 0;
+	  }
+	  return( 0 );
+	}
+
+	H = NULL;
+	c = sn = g = y = z = w = NULL;
+	V.row = NULL;
+	flag = ( new_rmat( m + 1, n, &V ) != 0 || alloc_rmat( m, m + 1, &H ) != 0
+	         || alloc_rvec( m, &c ) != 0 || alloc_rvec( m, &sn ) != 0
+	         || alloc_rvec( m + 1, &g ) != 0 || alloc_rvec( m + 1, &y ) != 0
+	         || alloc_rvec( n, &z ) != 0 || alloc_rvec( n, &w ) != 0 ) ? -1 : 0;
+
+	k = 0;
+	while( flag == 0 ) {
+	  // v_0 = r / ||r||, r = b - A * x.
+	  flag = lop_apply( A, x, w );
+	  if( flag != 0 ) {
+	    break;
+	  }
+	  memcpy( V.row[0], b, n * sizeof( double ) );
+	  simd.axpby( n, -1, w, 1, V.row[0] );
+	  beta = nrm2_rvec( n, V.row[0] );
+	  it->res = beta / nb;
+	  if( k == 0 && it->hist != NULL ) {
+	    it->hist[0] = it->res;
+	  }
+	  if( it->res <= it->tol || k >= it->maxit ) {
+	    break;
+	  }
+	  simd.scale( n, 1 / beta, V.row[0], V.row[0] );
+	  g[0] = beta;
+
+	  for( j = 0; j < m && k < it->maxit; j++ ) {
+	    apply_prec( M, V.row[j], z );
+	    flag = lop_apply( A, z, w );
+	    if( flag != 0 ) {
+	      break;
+	    }
+	    memset( H[j], 0, ( j + 2 ) * sizeof( double ) );
+	    for( pass = 0; pass < 2; pass++ ) { // CGS2.
+	      gemv_rmat( 'N', j + 1, n, 1, V.row, w, 1, 0, y, 1 );
+	      gemv_rmat( 'T', j + 1, n, -1, V.row, y, 1, 1, w, 1 );
+	      simd.axpby( j + 1, 1, y, 1, H[j] );
+	    }
+	    h = nrm2_rvec( n, w );
+	    H[j][j + 1] = h;
+	    if( h > 0 ) {
+	      simd.scale( n, 1 / h, w, V.row[j + 1] );
+	    }
+
+	    // The rotations so far, and a new one to zero H(j + 1,j).
+	    for( i = 0; i < j; i++ ) {
+	      t = c[i] * H[j][i] + sn[i] * H[j][i + 1];
+	      H[j][i + 1] = -sn[i] * H[j][i] + c[i] * H[j][i + 1];
+	      H[j][i] = t;
+	    }
+	    t = hypot( H[j][j], H[j][j + 1] );
+	    c[j] = ( t == 0 ) ? 1 : H[j][j] / t;
+	    sn[j] = ( t == 0 ) ? 0 : H[j][j + 1] / t;
+	    H[j][j] = t;
+	    g[j + 1] = -sn[j] * g[j];
+	    g[j] = c[j] * g[j];
+
+	    k++;
+	    it->iter = k;
+	    it->res = fabs( g[j + 1] ) / nb;
+	    if( it->hist != NULL ) {
+	      it->hist[k] = it->res;
+	    }
+	    if( it->res <= it->tol || h == 0 ) {
+	      j++;
+	      break;
+	    }
+	  }
+	  if( flag != 0 ) {
+	    break;
+	  }
+
+	  // y = R^-1 * g, x = x + M^-1 * transpose( V ) * y.
+	  for( i = j - 1; i >= 0; i-- ) {
+	    y[i] = g[i];
+	    for( pass = i + 1; pass < j; pass++ ) {
+	      y[i] = y[i] - H[pass][i] * y[pass];
+	    }
+	    y[i] = ( H[i][i] == 0 ) ? 0 : y[i] / H[i][i];
+	  }
+	  gemv_rmat( 'T', j, n, 1, V.row, y, 1, 0, w, 1 );
+	  apply_prec( M, w, z );
+	  simd.axpby( n, 1, z, 1, x );
+	  if( j == 0 ) {
+	    break;
+	  }
+	}
+
+	if( V.row != NULL ) {
+	  del_rmat( &V );
+	}
+	if( H != NULL ) {
+	  free_rmat( m, &H );
+	}
+	free( c );
+	free( sn );
+	free( g );
+	free( y );
+	free( z );
+	free( w );
+	if( flag != 0 ) {
+	  return( -1 );
+	}
+	return( ( it->res <= it->tol ) ? 0 : 1 );
+}
+//=====================================================
+//	2.3. BICGSTAB
+//=====================================================
+/* BiCGSTAB (H. A. van der Vorst, SIAM J. Sci. Stat. Comput. 1992)
+   needs, for any nonsingular A, only a few vectors and two products
+   by A and by M^-1 (M on the right) per iteration, but its residuals
+   do not decrease steadily as the ones of GMRES do.
+*/
+/* This function solves A * x = b by BiCGSTAB preconditioned on the
+   right by M (see new_prec). x holds a first guess on input. It
+   returns 0 if the tolerance is reached, 1 if it is not within
+   it->maxit iterations and -1 if the method breaks down (rho or
+   omega is zero), if M does not fit A or if memory is not available.
+*/
+int bicgstab_solve( Lop *A, Prec *M, double *b, double *x, Iter *it ) {
+	int    k, n, flag;
+	double nb, rho, rho1, alpha, omega, tt, *r, *r0, *p, *v, *s, *t, *q;
+
+	n = A->n;
+	it->iter = 0;
+	it->res = 0;
+	if( M->n != n ) {
+	  return( -1 );
+	}
+	nb = nrm2_rvec( n, b );
+	if( nb == 0 ) {
+	  memset( x, 0, n * sizeof( double ) );
+	  if( it->hist != NULL ) {
+	    it->hist[0] = 0;
+	  }
+	  return( 0 );
+	}
+
+	r = r0 = p = v = s = t = q = NULL;
+	flag = ( alloc_rvec( n, &r ) != 0 || alloc_rvec( n, &r0 ) != 0
+	         || alloc_rvec( n, &p ) != 0 || alloc_rvec( n, &v ) != 0
+	         || alloc_rvec( n, &s ) != 0 || alloc_rvec( n, &t ) != 0
+	         || alloc_rvec( n, &q ) != 0 ) ? -1 : 0;
+	if( flag == 0 ) {
+	  flag = lop_apply( A, x, t );
+	}
+	if( flag == 0 ) {
+	  memcpy( r, b, n * sizeof( double ) );
+	  simd.axpby( n, -1, t, 1, r );
+	  memcpy( r0, r, n * sizeof( double ) );
+	  memset( p, 0, n * sizeof( double ) );
+	  memset( v, 0, n * sizeof( double ) );
+	  it->res = nrm2_rvec( n, r ) / nb;
+	  if( it->hist != NULL ) {
+	    it->hist[0] = it->res;
+	  }
+	}
+
+	rho = alpha = omega = 1;
+	for( k = 0; flag == 0 && it->res > it->tol && k < it->maxit; k++ ) {
+	  rho1 = simd.dot( n, r0, r );
+	  if( rho1 == 0 || omega == 0 ) {
+	    flag = -1;
+	    break;
+	  }
+	  simd.axpby( n, -omega, v, 1, p ); // p = r + beta * ( p - omega * v ).
+	  simd.axpby( n, 1, r, ( rho1 / rho ) * ( alpha / omega ), p );
+	  rho = rho1;
+	  apply_prec( M, p, q );
+	  flag = lop_apply( A, q, v );
+	  alpha = ( flag == 0 ) ? simd.dot( n, r0, v ) : 0;
+	  if( alpha == 0 ) {
+	    flag = -1;
+	    break;
+	  }
+	  alpha = rho / alpha;
+	  simd.axpby( n, alpha, q, 1, x );
+	  memcpy( s, r, n * sizeof( double ) );
+	  simd.axpby( n, -alpha, v, 1, s );
+	  it->iter = k + 1;
+	  it->res = nrm2_rvec( n, s ) / nb;
+	  if( it->res <= it->tol ) {
+	    memcpy( r, s, n * sizeof( double ) );
+	  }
+	  else {
+	    apply_prec( M, s, q );
+	    flag = lop_apply( A, q, t );
+	    tt = simd.dot( n, t, t );
+	    omega = ( flag == 0 && tt > 0 ) ? simd.dot( n, t, s ) / tt : 0;
+	    simd.axpby( n, omega, q, 1, x );
+	    memcpy( r, s, n * sizeof( double ) );
+	    simd.axpby( n, -omega, t, 1, r );
+	    it->res = nrm2_rvec( n, r ) / nb;
+	  }
+	  if( it->hist != NULL ) {
+	    it->hist[k + 1] = it->res;
+	  }
+	}
+
+	free( r );
+	free( r0 );
+	free( p );
+	free( v );
+	free( s );
+	free( t );
+	free( q );
+	if( flag != 0 ) {
+	  return( -1 );
+	}
+	return( ( it->res <= it->tol ) ? 0 : 1 );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	3. GEOMETRIC MULTIGRID
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/* The multigrid solver works on the Poisson (sigma = 0) or Helmholtz
+   (sigma > 0) equation sigma * u - Laplacian( u ) = f on a regular 2-D
+   or 3-D grid of nx-X-ny(-X-nz) points inside a box, with u = 0 on its
+   boundary, discretized by the 5-point (7-point) stencil:
+
+	( A * u )(i) = dg * u(i) - cx * ( u(W) + u(E) ) - cy * ( u(S) + u(N) )
+	               - cz * ( u(D) + u(U) ),
+
+   where cx = 1 / hx^2, ..., dg = sigma + 2 * ( cx + cy + cz ) and hx,
+   hy, hz are the spacings. Point (x, y, z) is element x + nx * ( y +
+   ny * z ) of a vector. No matrix is kept: each level is the same
+   stencil on a grid with twice the spacing, whose point (X, Y, Z) is
+   the point (2X + 1, 2Y + 1, 2Z + 1) of the finer grid, so a side of n
+   points gives ( n - 1 ) / 2 points while n is odd and at least 3; the
+   coarsest grid is solved by the sparse Cholesky factorization (see
+   section 3 of sparse-matrices.c). A side of c * 2^k - 1 points, with
+   a small c (e.g. 511 = 2^9 - 1), thus gives k levels and a small
+   coarsest grid.
+
+   A cycle on a level smooths the error by nu1 sweeps, restricts the
+   residual f - A * u to the coarser level by full weighting (weights
+   1/4, 1/2, 1/4 along each axis), solves the coarse equation by one
+   (V-cycle) or two (W-cycle) cycles, adds the coarse correction by
+   linear interpolation and smooths again by nu2 sweeps. The smoother
+   is red-black Gauss-Seidel (the points with x + y + z even, then the
+   odd ones, which is reversed after the correction, so the cycle is a
+   symmetric operator) or a Chebyshev polynomial of the Jacobi iteration
+   which damps the upper part [lmax / ( 2 * dim ), lmax] of the spectrum
+   of D^-1 * A. Each sweep is O(N), so a cycle is O(N) and reduces the
+   error by a factor which does not depend on the grid.
+
+   Each level keeps its vectors with one more layer of zeros all around
+   the grid (but not along z in 2-D, where the z stride is 0 and cz =
+   0), so no point needs a test for the boundary. The passes over a
+   level are shared among the threads of the pool by lines along x,
+   i.e. by planes of whole lines.
+*/
+#define MG_RBGS		0	// Red-black Gauss-Seidel smoother.
+#define MG_CHEB		1	// Chebyshev smoother.
+
+#define MG_LEVELS	32	// Largest number of levels.
+#define MG_DIRECT	65536	// Points of the largest coarsest grid.
+#define MG_PAR		32768	// Points of the smallest level made in parallel.
+#define MG_BLOCKS	4	// Blocks of lines per thread.
+
+typedef struct {
+	int    nx, ny, nz;	// Points inside the grid (nz = 1 in 2-D).
+	long   sy, sz;		// Strides of y and z (sz = 0 in 2-D).
+	int    z0;		// First plane inside (1 in 3-D, 0 in 2-D).
+	double cx, cy, cz, dg;	// The stencil.
+	double *u, *f, *r;	// Solution, right side and residual.
+	double *d;		// Chebyshev: the last step.
+} Mg_level;
+
+typedef struct {
+	int      dim;		// 2 or 3.
+	int      n;		// Points of the finest grid.
+	int      nl;		// Number of levels (0 is the finest).
+	int      smoother;	// MG_RBGS or MG_CHEB.
+	int      nu1, nu2;	// Sweeps before and after the correction.
+	int      cycle;		// 1 for V-cycles, 2 for W-cycles.
+	Mg_level lv[MG_LEVELS];
+	Schol    C;		// Factorization of the coarsest level,
+	double   *cb;		// and its right side.
+} Mgrid;
+
+//=====================================================
+//	3.1. SETTING UP THE LEVELS
+//=====================================================
+/* This function sets free the levels of a multigrid solver G.
+*/
+int free_mgrid( Mgrid *G ) {
+	int l;
+
+	for( l = 0; l < G->nl; l++ ) {
+	  free( G->lv[l].u );
+	  free( G->lv[l].f );
+	  free( G->lv[l].r );
+	  free( G->lv[l].d );
+	}
+	free_schol( &G->C );
+	free( G->cb );
+	G->cb = NULL;
+	G->nl = G->n = 0;
+
+	return( 0 );
+}
+// The coarsest level, as a sparse matrix (format 'R').
+static int mg_coarse( Mg_level *L, Smat *A ) {
+	int    x, y, z, i, q, nt, n, flag, st[6], nb[6], *I, *J;
+	double c[6], *X;
+
+	n = L->nx * L->ny * L->nz;
+	I = ( int* ) malloc( 7 * ( size_t ) n * sizeof( int ) );
+	J = ( int* ) malloc( 7 * ( size_t ) n * sizeof( int ) );
+	X = ( double* ) malloc( 7 * ( size_t ) n * sizeof( double ) );
+	if( I == NULL || J == NULL || X == NULL ) {
+	  free( I );
+	  free( J );
+	  free( X );
+	  return( -1 );
+	}
+	// Neighbours W, E, S, N, D and U: strides and coefficients.
+	for( q = 0; q < 6; q++ ) {
+	  st[q] = ( q < 2 ) ? 1 : ( ( q < 4 ) ? L->nx : L->nx * L->ny );
+	  st[q] = ( q % 2 == 0 ) ? -st[q] : st[q];
+	  c[q] = ( q < 2 ) ? L->cx : ( ( q < 4 ) ? L->cy : L->cz );
+	}
+	nt = 0;
+	for( z = 0; z < L->nz; z++ ) {
+	  for( y = 0; y < L->ny; y++ ) {
+	    for( x = 0; x < L->nx; x++ ) {
+	      i = x + L->nx * ( y + L->ny * z );
+	      nb[0] = ( x > 0 );
+	      nb[1] = ( x < L->nx - 1 );
+	      nb[2] = ( y > 0 );
+	      nb[3] = ( y < L->ny - 1 );
+	      nb[4] = ( z > 0 );
+	      nb[5] = ( z < L->nz - 1 );
+	      I[nt] = J[nt] = i;
+	      X[nt++] = L->dg;
+	      for( q = 0; q < 6; q++ ) {
+	        if( nb[q] ) {
+	          I[nt] = i;
+	          J[nt] = i + st[q];
+	          X[nt++] = -c[q];
+	        }
+	      }
+	    }
+	  }
+	}
+	flag = trip_smat( n, n, nt, I, J, X, 'R', A );
+	free( I );
+	free( J );
+	free( X );
+	return( flag );
+}
+/* This function sets up in G the multigrid solver of the equation
+   sigma * u - Laplacian( u ) = f (see above) on a grid of dim = 2 or 3
+   dimensions with n[k] points and spacing h[k] along axis k, smoothed
+   by smoother = MG_RBGS or MG_CHEB. The cycles are V-cycles with two
+   sweeps before and after the correction; the fields nu1, nu2 and
+   cycle (2 for W-cycles) of G may be changed afterwards. G must be
+   set free by free_mgrid. It returns -1 if some argument is not valid,
+   if the coarsest grid has more than MG_DIRECT points (the sides do
+   not halve often enough) or if memory is not available.
+*/
+int new_mgrid( int dim, int *n, double *h, double sigma, int smoother, Mgrid *G ) {
+	int      l, flag;
+	size_t   size;
+	Smat     A;
+	Mg_level *L;
+
+	memset( G, 0, sizeof( Mgrid ) );
+	if( ( dim != 2 && dim != 3 ) || !( sigma >= 0 )
+	    || ( smoother != MG_RBGS && smoother != MG_CHEB ) ) {
+	  return( -1 );
+	}
+	for( l = 0; l < dim; l++ ) {
+	  if( n[l] < 1 || !( h[l] > 0 ) ) {
+	    return( -1 );
+	  }
+	}
+	G->dim = dim;
+	G->smoother = smoother;
+	G->nu1 = G->nu2 = 2;
+	G->cycle = 1;
+
+	L = G->lv;
+	L->nx = n[0];
+	L->ny = n[1];
+	L->nz = ( dim == 3 ) ? n[2] : 1;
+	L->cx = 1 / ( h[0] * h[0] );
+	L->cy = 1 / ( h[1] * h[1] );
+	L->cz = ( dim == 3 ) ? 1 / ( h[2] * h[2] ) : 0;
+	G->nl = 1;
+	while( G->nl < MG_LEVELS && L->nx >= 3 && L->nx % 2 == 1 && L->ny >= 3
+	       && L->ny % 2 == 1 && ( dim == 2 || ( L->nz >= 3 && L->nz % 2 == 1 ) ) ) {
+	  L[1].nx = ( L->nx - 1 ) / 2;
+	  L[1].ny = ( L->ny - 1 ) / 2;
+	  L[1].nz = ( dim == 3 ) ? ( L->nz - 1 ) / 2 : 1;
+	  L[1].cx = L->cx / 4;
+	  L[1].cy = L->cy / 4;
+	  L[1].cz = L->cz / 4;
+	  L++;
+	  G->nl++;
+	}
+	if( ( long long ) L->nx * L->ny * L->nz > MG_DIRECT ) {
+	  G->nl = 0;
+	  return( -1 );
+	}
+
+	flag = 0;
+	for( l = 0; l < G->nl; l++ ) {
+	  L = G->lv + l;
+	  L->z0 = ( dim == 3 ) ? 1 : 0;
+	  L->sy = L->nx + 2;
+	  L->sz = ( dim == 3 ) ? L->sy * ( L->ny + 2 ) : 0;
+	  L->dg = sigma + 2 * ( L->cx + L->cy + L->cz );
+	  size = ( size_t ) L->sy * ( L->ny + 2 ) * ( L->nz + 2 * L->z0 );
+	  L->u = ( double* ) calloc( size, sizeof( double ) );
+	  L->f = ( double* ) calloc( size, sizeof( double ) );
+	  L->r = ( double* ) calloc( size, sizeof( double ) );
+	  L->d = ( smoother == MG_CHEB ) ? ( double* ) calloc( size, sizeof( double ) ) : NULL;
+	  if( L->u == NULL || L->f == NULL || L->r == NULL
+	      || ( smoother == MG_CHEB && L->d == NULL ) ) {
+	    flag = -1;
+	  }
+	}
+	G->n = G->lv[0].nx * G->lv[0].ny * G->lv[0].nz;
+
+	L = G->lv + G->nl - 1;
+	if( flag == 0 ) {
+	  flag = alloc_rvec( L->nx * L->ny * L->nz, &G->cb );
+	}
+	if( flag == 0 && mg_coarse( L, &A ) == 0 ) {
+	  flag = symb_schol( &A, NULL, &G->C );
+	  if( flag == 0 ) {
+	    flag = fact_schol( &A, &G->C );
+	  }
+	  free_smat( &A );
+	}
+	else {
+	  flag = -1;
+	}
+	if( flag != 0 ) {
+	  free_mgrid( G );
+	  return( -1 );
+	}
+	return( 0 );
+}
+//=====================================================
+//	3.2. PASSES OVER A LEVEL
+//=====================================================
+#define MG_IN		0	// u = x (or 0), f = y (if not NULL).
+#define MG_OUT		1	// x = u.
+#define MG_MV		2	// y = A * u.
+#define MG_RES		3	// r = f - A * u.
+#define MG_RB		4	// Gauss-Seidel sweep over the points of color c.
+#define MG_CHEBY	5	// d = a * d + b * D^-1 * r, u = u + d.
+#define MG_RESTRICT	6	// f = full weighting of the r of the finer level C, u = 0.
+#define MG_PROLONG	7	// u = u + interpolation of the u of the coarser level C.
+
+typedef struct {
+	Mg_level *L, *C;	// The level, and the coarser or finer one.
+	int      op, c, nb;	// Pass, color and number of blocks.
+	double   a, b;
+	double   *x, *y;	// Vectors without the layer of zeros.
+} Mg_arg;
+
+// Weights 1/4, 1/2, 1/4 along x and y around p[i].
+static double mg_fw2( double *p, long i, long sy ) {
+	return( 0.0625 * ( p[i - sy - 1] + p[i - sy + 1] + p[i + sy - 1] + p[i + sy + 1] )
+	        + 0.125 * ( p[i - sy] + p[i + sy] + p[i - 1] + p[i + 1] ) + 0.25 * p[i] );
+}
+// The pass a->op over the lines of block t.
+static void mg_task( int t, void *arg ) {
+	Mg_arg   *a = ( Mg_arg* ) arg;
+	Mg_level *L, *C;
+	int      x, y, z, k, k0, k1, nx, ny;
+	long     i, j, sy, sz, c0, c1, c2, c3;
+	double   cx, cy, cz, dg, s, *u, *f, *r, *d, *v, *w;
+
+	L = a->L;
+	C = a->C;
+	nx = L->nx;
+	ny = L->ny;
+	sy = L->sy;
+	sz = L->sz;
+	cx = L->cx;
+	cy = L->cy;
+	cz = L->cz;
+	dg = L->dg;
+	u = L->u;
+	f = L->f;
+	r = L->r;
+	d = L->d;
+	k0 = ( int ) ( ( double ) ny * L->nz * t / a->nb );
+	k1 = ( int ) ( ( double ) ny * L->nz * ( t + 1 ) / a->nb );
+	for( k = k0; k < k1; k++ ) { // Line k: y = k % ny, z = k / ny.
+	  y = k % ny + 1;
+	  z = k / ny + L->z0;
+	  i = z * sz + y * sy;
+	  switch( a->op ) {
+	    case MG_IN:
+	      for( x = 1; x <= nx; x++ ) {
+	        u[i + x] = ( a->x != NULL ) ? a->x[( long ) k * nx + x - 1] : 0;
+	        if( a->y != NULL ) {
+	          f[i + x] = a->y[( long ) k * nx + x - 1];
+	        }
+	      }
+	      break;
+	    case MG_OUT:
+	      memcpy( a->x + ( long ) k * nx, u + i + 1, nx * sizeof( double ) );
+	      break;
+	    case MG_MV:
+	    case MG_RES:
+	      v = ( a->op == MG_MV ) ? a->y + ( long ) k * nx - 1 : r + i;
+	      for( x = 1; x <= nx; x++ ) {
+	        j = i + x;
+	        s = dg * u[j] - cx * ( u[j - 1] + u[j + 1] ) - cy * ( u[j - sy] + u[j + sy] )
+	            - cz * ( u[j - sz] + u[j + sz] );
+	        v[x] = ( a->op == MG_MV ) ? s : f[j] - s;
+	      }
+	      break;
+	    case MG_RB:
+	      for( x = 1 + ( ( 1 + y + z + a->c ) & 1 ); x <= nx; x = x + 2 ) {
+	        j = i + x;
+	        u[j] = ( f[j] + cx * ( u[j - 1] + u[j + 1] ) + cy * ( u[j - sy] + u[j + sy] )
+	                 + cz * ( u[j - sz] + u[j + sz] ) ) / dg;
+	      }
+	      break;
+	    case MG_CHEBY:
+	      for( x = 1; x <= nx; x++ ) {
+	        j = i + x;
+	        d[j] = ( ( a->a != 0 ) ? a->a * d[j] : 0 ) + a->b * r[j] / dg;
+	        u[j] = u[j] + d[j];
+	      }
+	      break;
+	    case MG_RESTRICT: // C is the finer level; its point 2 * (x,y,z).
+	      v = C->r;
+	      for( x = 1; x <= nx; x++ ) {
+	        j = 2 * ( z * C->sz + y * C->sy + x );
+	        s = mg_fw2( v, j, C->sy );
+	        if( C->sz != 0 ) {
+	          s = 0.5 * s + 0.25 * ( mg_fw2( v, j - C->sz, C->sy )
+	                                 + mg_fw2( v, j + C->sz, C->sy ) );
+	        }
+	        f[i + x] = s;
+	        u[i + x] = 0;
+	      }
+	      break;
+	    case MG_PROLONG: // C is the coarser level; points (x / 2, ( x + 1 ) / 2).
+	      v = C->u;
+	      c0 = ( z / 2 ) * C->sz + ( y / 2 ) * C->sy;
+	      c1 = ( z / 2 ) * C->sz + ( ( y + 1 ) / 2 ) * C->sy;
+	      c2 = ( ( z + 1 ) / 2 ) * C->sz + ( y / 2 ) * C->sy;
+	      c3 = ( ( z + 1 ) / 2 ) * C->sz + ( ( y + 1 ) / 2 ) * C->sy;
+	      if( C->sz == 0 ) {
+	        c2 = c0;
+	        c3 = c1;
+	      }
+	      for( x = 1; x <= nx; x++ ) {
+	        w = v + x / 2;
+	        s = w[c0] + w[c1] + w[c2] + w[c3];
+	        w = v + ( x + 1 ) / 2;
+	        s = s + w[c0] + w[c1] + w[c2] + w[c3];
+	        u[i + x] = u[i + x] + 0.125 * s;
+	      }
+	      break;
+	  }
+	}
+	return;
+}
+// Runs a pass over the level L, by the threads if L is large.
+static void mg_run( Mg_level *L, Mg_level *C, int op, int c, double a, double b,
+                    double *x, double *y ) {
+	int    lines;
+	Mg_arg arg;
+
+	arg.L = L;
+	arg.C = C;
+	arg.op = op;
+	arg.c = c;
+	arg.a = a;
+	arg.b = b;
+	arg.x = x;
+	arg.y = y;
+	lines = L->ny * L->nz;
+	arg.nb = 1;
+	if( tpool_par() && ( long long ) lines * L->nx >= MG_PAR ) {
+	  arg.nb = ( lines < MG_BLOCKS * tpool_size() ) ? lines : MG_BLOCKS * tpool_size();
+	}
+	if( arg.nb > 1 ) {
+	  tpool_for( arg.nb, mg_task, &arg );
+	}
+	else {
+	  mg_task( 0, &arg );
+	}
+	return;
+}
+//=====================================================
+//	3.3. CYCLES
+//=====================================================
+// k smoothing sweeps over level l; post = 1 after the correction.
+static void mg_smooth( Mgrid *G, int l, int k, int post ) {
+	int      s;
+	double   lmax, lmin, theta, delta, sigma, rho, rho1;
+	Mg_level *L;
+
+	L = G->lv + l;
+	if( G->smoother == MG_RBGS ) {
+	  for( s = 0; s < k; s++ ) {
+	    mg_run( L, NULL, MG_RB, post, 0, 0, NULL, NULL );
+	    mg_run( L, NULL, MG_RB, 1 - post, 0, 0, NULL, NULL );
+	  }
+	  return;
+	}
+	// Chebyshev: lmax is the Gershgorin bound of D^-1 * A.
+	lmax = 1 + 2 * ( L->cx + L->cy + L->cz ) / L->dg;
+	lmin = lmax / ( 2 * G->dim );
+	theta = ( lmax + lmin ) / 2;
+	delta = ( lmax - lmin ) / 2;
+	sigma = theta / delta;
+	rho = 1 / sigma;
+	for( s = 0; s < k; s++ ) {
+	  mg_run( L, NULL, MG_RES, 0, 0, 0, NULL, NULL );
+	  if( s == 0 ) {
+	    mg_run( L, NULL, MG_CHEBY, 0, 0, 1 / theta, NULL, NULL );
+	  }
+	  else {
+	    rho1 = 1 / ( 2 * sigma - rho );
+	    mg_run( L, NULL, MG_CHEBY, 0, rho1 * rho, 2 * rho1 / delta, NULL, NULL );
+	    rho = rho1;
+	  }
+	}
+	return;
+}
+// A cycle for the equation of level l, from its u.
+static void mg_level( Mgrid *G, int l ) {
+	int      k, x, y, z, nx, ny;
+	Mg_level *L, *C;
+
+	L = G->lv + l;
+	if( l == G->nl - 1 ) { // The coarsest grid: direct solution.
+	  nx = L->nx;
+	  ny = L->ny;
+	  for( z = 0; z < L->nz; z++ ) {
+	    for( y = 0; y < ny; y++ ) {
+	      for( x = 0; x < nx; x++ ) {
+	        G->cb[x + nx * ( y + ny * z )] = L->f[( z + L->z0 ) * L->sz + ( y + 1 ) * L->sy + x + 1];
+	      }
+	    }
+	  }
+	  vsolve_schol( &G->C, G->cb );
+	  mg_run( L, NULL, MG_IN, 0, 0, 0, G->cb, NULL );
+	  return;
+	}
+	C = L + 1;
+	mg_smooth( G, l, G->nu1, 0 );
+	mg_run( L, NULL, MG_RES, 0, 0, 0, NULL, NULL );
+	mg_run( C, L, MG_RESTRICT, 0, 0, 0, NULL, NULL );
+	for( k = 0; k < G->cycle; k++ ) {
+	  mg_level( G, l + 1 );
+	}
+	mg_run( L, C, MG_PROLONG, 0, 0, 0, NULL, NULL );
+	mg_smooth( G, l, G->nu2, 1 );
+	return;
+}
+/* This function makes one multigrid cycle for the equation A * x = b
+   of G (see new_mgrid): x holds the guess on input, and the improved
+   one on output.
+*/
+int mg_cycle( Mgrid *G, double *b, double *x ) {
+	mg_run( G->lv, NULL, MG_IN, 0, 0, 0, x, b );
+	mg_level( G, 0 );
+	mg_run( G->lv, NULL, MG_OUT, 0, 0, 0, x, NULL );
+
+	return( 0 );
+}
+/* This function solves A * x = b by multigrid cycles (see new_mgrid),
+   from the guess in x, until ||b - A * x|| <= it->tol * ||b|| or for
+   it->maxit cycles; the number of cycles and the relative residuals
+   are reported in it (see Iter). It returns 0 if the tolerance is
+   reached and 1 otherwise.
+*/
+int mg_solve( Mgrid *G, double *b, double *x, Iter *it ) {
+	double nb;
+	size_t size;
+
+	it->iter = 0;
+	it->res = 0;
+	nb = nrm2_rvec( G->n, b );
+	if( nb == 0 ) {
+	  memset( x, 0, G->n * sizeof( double ) );
+	  if( it->hist != NULL ) {
+	    it->hist[0] = 0;
+	  }
+	  return( 0 );
+	}
+	size = ( size_t ) G->lv[0].sy * ( G->lv[0].ny + 2 ) * ( G->lv[0].nz + 2 * G->lv[0].z0 );
+	mg_run( G->lv, NULL, MG_IN, 0, 0, 0, x, b );
+	while( 1 ) {
+	  mg_run( G->lv, NULL, MG_RES, 0, 0, 0, NULL, NULL );
+	  it->res = sqrt( simd.dot( ( int ) size, G->lv[0].r, G->lv[0].r ) ) / nb;
+	  if( it->hist != NULL ) {
+	    it->hist[it->iter] = it->res;
+	  }
+	  if( it->res <= it->tol || it->iter >= it->maxit ) {
+	    break;
+	  }
+	  mg_level( G, 0 );
+	  it->iter++;
+	}
+	mg_run( G->lv, NULL, MG_OUT, 0, 0, 0, x, NULL );
+	return( ( it->res <= it->tol ) ? 0 : 1 );
+}
+// y = A * x, for mg_lop.
+static int mg_mv( void *arg, double *x, double *y ) {
+	Mgrid *G = ( Mgrid* ) arg;
+
+	mg_run( G->lv, NULL, MG_IN, 0, 0, 0, x, NULL );
+	mg_run( G->lv, NULL, MG_MV, 0, 0, 0, NULL, y );
+	return( 0 );
+}
+// z = M^-1 * r: one cycle from z = 0, for mg_prec.
+static int mg_pc( void *arg, double *r, double *z ) {
+	Mgrid *G = ( Mgrid* ) arg;
+
+	mg_run( G->lv, NULL, MG_IN, 0, 0, 0, NULL, r );
+	mg_level( G, 0 );
+	mg_run( G->lv, NULL, MG_OUT, 0, 0, 0, z, NULL );
+	return( 0 );
+}
+/* This function makes L the matrix-free operator A of G (see
+   new_mgrid), for the Krylov solvers.
+*/
+int mg_lop( Mgrid *G, Lop *L ) {
+	return( fun_lop( G->n, mg_mv, G, L ) );
+}
+/* This function makes M the preconditioner of A given by one cycle of
+   G from a zero guess (see fun_prec). With nu1 = nu2 (the default),
+   the cycle is a symmetric positive definite operator, so M may
+   precondition CG (see pcg_solve).
+*/
+int mg_prec( Mgrid *G, Prec *M ) {
+	return( fun_prec( G->n, mg_pc, G, M ) );
+}
+
+/*
+int main() {
+	return( 0 );
+}
+*/
@@ -1,8 +1,304 @@
 #include "auxiliary-commands.c"
 
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define LILA_X86 1
+#include <immintrin.h>
+#endif
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	1. VECTOR OPERATIONS
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/* The level-1 loops below have portable, SSE2, AVX2 and AVX-512
+   versions. The reductions keep several independent accumulators, so
+   they are not limited by the latency of one addition per element.
+   The version for this CPU is chosen once, at startup (see simd_init),
+   and called through the table simd. The AVX versions, here and in
+   the kernels below, clear the upper halves of the vector registers
+   (vzeroupper) before they return or call plain C code: GCC does not
+   do it for functions built with a target attribute, and the SSE code
+   run after them would otherwise pay a state transition penalty.
+*/
+#define SIMD_C		0	// Portable C.
+#define SIMD_SSE2	1
+#define SIMD_AVX2	2	// AVX2 and FMA.
+#define SIMD_AVX512	3	// AVX-512F.
+
+static void add_c( int n, const double *V, const double *U, double *W ) {
+	int i;
+
+	for( i = 0; i < n; i++ ) {
+	  W[i] = V[i] + U[i];
+	}
+	return;
+}
+static void scale_c( int n, double k, const double *V, double *U ) {
+	int i;
+
+	for( i = 0; i < n; i++ ) {
+	  U[i] = k * V[i];
+	}
+	return;
+}
+static void axpby_c( int n, double a, const double *X, double b, double *Y ) {
+	int i;
+
+	for( i = 0; i < n; i++ ) {
+	  Y[i] = a * X[i] + b * Y[i];
+	}
+	return;
+}
+static double dot_c( int n, const double *V, const double *U ) {
+	int    i;
+	double s0, s1, s2, s3;
+
+	s0 = s1 = s2 = s3 = 0;
+	for( i = 0; i + 4 <= n; i = i + 4 ) {
+	  s0 = s0 + V[i] * U[i];
+	  s1 = s1 + V[i + 1] * U[i + 1];
+	  s2 = s2 + V[i + 2] * U[i + 2];
+	  s3 = s3 + V[i + 3] * U[i + 3];
+	}
+	for( ; i < n; i++ ) {
+	  s0 = s0 + V[i] * U[i];
+	}
+	return( ( s0 + s1 ) + ( s2 + s3 ) );
+}
+
+#ifdef LILA_X86
+__attribute__(( target( "sse2" ) ))
+static void add_sse2( int n, const double *V, const double *U, double *W ) {
+	int i;
+
+	for( i = 0; i + 2 <= n; i = i + 2 ) {
+	  _mm_storeu_pd( W + i, _mm_add_pd( _mm_loadu_pd( V + i ),
+	                                    _mm_loadu_pd( U + i ) ) );
+	}
+	add_c( n - i, V + i, U + i, W + i );
+	return;
+}
+__attribute__(( target( "sse2" ) ))
+static void scale_sse2( int n, double k, const double *V, double *U ) {
+	int     i;
+	__m128d vk = _mm_set1_pd( k );
+
+	for( i = 0; i + 2 <= n; i = i + 2 ) {
+	  _mm_storeu_pd( U + i, _mm_mul_pd( vk, _mm_loadu_pd( V + i ) ) );
+	}
+	scale_c( n - i, k, V + i, U + i );
+	return;
+}
+__attribute__(( target( "sse2" ) ))
+static void axpby_sse2( int n, double a, const double *X, double b,
+                        double *Y ) {
+	int     i;
+	__m128d va = _mm_set1_pd( a ), vb = _mm_set1_pd( b );
+
+	for( i = 0; i + 2 <= n; i = i + 2 ) {
+	  _mm_storeu_pd( Y + i, _mm_add_pd( _mm_mul_pd( va, _mm_loadu_pd( X + i ) ),
+	                                    _mm_mul_pd( vb, _mm_loadu_pd( Y + i ) ) ) );
+	}
+	axpby_c( n - i, a, X + i, b, Y + i );
+	return;
+}
+__attribute__(( target( "sse2" ) ))
+static double dot_sse2( int n, const double *V, const double *U ) {
+	int     i;
+	double  s[2];
+	__m128d s0, s1, s2, s3;
+
+	s0 = s1 = s2 = s3 = _mm_setzero_pd();
+	for( i = 0; i + 8 <= n; i = i + 8 ) {
+	  s0 = _mm_add_pd( s0, _mm_mul_pd( _mm_loadu_pd( V + i ), _mm_loadu_pd( U + i ) ) );
+	  s1 = _mm_add_pd( s1, _mm_mul_pd( _mm_loadu_pd( V + i + 2 ), _mm_loadu_pd( U + i + 2 ) ) );
+	  s2 = _mm_add_pd( s2, _mm_mul_pd( _mm_loadu_pd( V + i + 4 ), _mm_loadu_pd( U + i + 4 ) ) );
+	  s3 = _mm_add_pd( s3, _mm_mul_pd( _mm_loadu_pd( V + i + 6 ), _mm_loadu_pd( U + i + 6 ) ) );
+	}
+	_mm_storeu_pd( s, _mm_add_pd( _mm_add_pd( s0, s1 ), _mm_add_pd( s2, s3 ) ) );
+	return( ( s[0] + s[1] ) + dot_c( n - i, V + i, U + i ) );
+}
+
+__attribute__(( target( "avx2,fma" ) ))
+static void add_avx2( int n, const double *V, const double *U, double *W ) {
+	int i;
+
+	for( i = 0; i + 4 <= n; i = i + 4 ) {
+	  _mm256_storeu_pd( W + i, _mm256_add_pd( _mm256_loadu_pd( V + i ),
+	                                          _mm256_loadu_pd( U + i ) ) );
+	}
+	_mm256_zeroupper();
+	add_c( n - i, V + i, U + i, W + i );
+	return;
+}
+__attribute__(( target( "avx2,fma" ) ))
+static void scale_avx2( int n, double k, const double *V, double *U ) {
+	int     i;
+	__m256d vk = _mm256_set1_pd( k );
+
+	for( i = 0; i + 4 <= n; i = i + 4 ) {
+	  _mm256_storeu_pd( U + i, _mm256_mul_pd( vk, _mm256_loadu_pd( V + i ) ) );
+	}
+	_mm256_zeroupper();
+	scale_c( n - i, k, V + i, U + i );
+	return;
+}
+__attribute__(( target( "avx2,fma" ) ))
+static void axpby_avx2( int n, double a, const double *X, double b,
+                        double *Y ) {
+	int     i;
+	__m256d va = _mm256_set1_pd( a ), vb = _mm256_set1_pd( b );
+
+	for( i = 0; i + 4 <= n; i = i + 4 ) {
+	  _mm256_storeu_pd( Y + i, _mm256_fmadd_pd( va, _mm256_loadu_pd( X + i ),
+	                    _mm256_mul_pd( vb, _mm256_loadu_pd( Y + i ) ) ) );
+	}
+	_mm256_zeroupper();
+	axpby_c( n - i, a, X + i, b, Y + i );
+	return;
+}
+__attribute__(( target( "avx2,fma" ) ))
+static double dot_avx2( int n, const double *V, const double *U ) {
+	int     i;
+	double  s[4];
+	__m256d s0, s1, s2, s3;
+
+	s0 = s1 = s2 = s3 = _mm256_setzero_pd();
+	for( i = 0; i + 16 <= n; i = i + 16 ) {
+	  s0 = _mm256_fmadd_pd( _mm256_loadu_pd( V + i ), _mm256_loadu_pd( U + i ), s0 );
+	  s1 = _mm256_fmadd_pd( _mm256_loadu_pd( V + i + 4 ), _mm256_loadu_pd( U + i + 4 ), s1 );
+	  s2 = _mm256_fmadd_pd( _mm256_loadu_pd( V + i + 8 ), _mm256_loadu_pd( U + i + 8 ), s2 );
+	  s3 = _mm256_fmadd_pd( _mm256_loadu_pd( V + i + 12 ), _mm256_loadu_pd( U + i + 12 ), s3 );
+	}
+	_mm256_storeu_pd( s, _mm256_add_pd( _mm256_add_pd( s0, s1 ),
+	                                    _mm256_add_pd( s2, s3 ) ) );
+	_mm256_zeroupper();
+	return( ( ( s[0] + s[1] ) + ( s[2] + s[3] ) ) + dot_c( n - i, V + i, U + i ) );
+}
+
+__attribute__(( target( "avx512f" ) ))
+static void add_avx512( int n, const double *V, const double *U, double *W ) {
+	int i;
+
+	for( i = 0; i + 8 <= n; i = i + 8 ) {
+	  _mm512_storeu_pd( W + i, _mm512_add_pd( _mm512_loadu_pd( V + i ),
+	                                          _mm512_loadu_pd( U + i ) ) );
+	}
+	_mm256_zeroupper();
+	add_c( n - i, V + i, U + i, W + i );
+	return;
+}
+__attribute__(( target( "avx512f" ) ))
+static void scale_avx512( int n, double k, const double *V, double *U ) {
+	int     i;
+	__m512d vk = _mm512_set1_pd( k );
+
+	for( i = 0; i + 8 <= n; i = i + 8 ) {
+	  _mm512_storeu_pd( U + i, _mm512_mul_pd( vk, _mm512_loadu_pd( V + i ) ) );
+	}
+	_mm256_zeroupper();
+	scale_c( n - i, k, V + i, U + i );
+	return;
+}
+__attribute__(( target( "avx512f" ) ))
+static void axpby_avx512( int n, double a, const double *X, double b,
+                          double *Y ) {
+	int     i;
+	__m512d va = _mm512_set1_pd( a ), vb = _mm512_set1_pd( b );
+
+	for( i = 0; i + 8 <= n; i = i + 8 ) {
+	  _mm512_storeu_pd( Y + i, _mm512_fmadd_pd( va, _mm512_loadu_pd( X + i ),
+	                    _mm512_mul_pd( vb, _mm512_loadu_pd( Y + i ) ) ) );
+	}
+	_mm256_zeroupper();
+	axpby_c( n - i, a, X + i, b, Y + i );
+	return;
+}
+__attribute__(( target( "avx512f" ) ))
+static double dot_avx512( int n, const double *V, const double *U ) {
+	int     i;
+	double  s;
+	__m512d s0, s1, s2, s3;
+
+	s0 = s1 = s2 = s3 = _mm512_setzero_pd();
+	for( i = 0; i + 32 <= n; i = i + 32 ) {
+	  s0 = _mm512_fmadd_pd( _mm512_loadu_pd( V + i ), _mm512_loadu_pd( U + i ), s0 );
+	  s1 = _mm512_fmadd_pd( _mm512_loadu_pd( V + i + 8 ), _mm512_loadu_pd( U + i + 8 ), s1 );
+	  s2 = _mm512_fmadd_pd( _mm512_loadu_pd( V + i + 16 ), _mm512_loadu_pd( U + i + 16 ), s2 );
+	  s3 = _mm512_fmadd_pd( _mm512_loadu_pd( V + i + 24 ), _mm512_loadu_pd( U + i + 24 ), s3 );
+	}
+	s = _mm512_reduce_add_pd( _mm512_add_pd( _mm512_add_pd( s0, s1 ),
+	                                         _mm512_add_pd( s2, s3 ) ) );
+	_mm256_zeroupper();
+	return( s + dot_c( n - i, V + i, U + i ) );
+}
+#endif
+
+static struct {
+	int    level;	// SIMD_C, SIMD_SSE2, SIMD_AVX2 or SIMD_AVX512.
+	void   ( *add )( int n, const double *V, const double *U, double *W );
+	void   ( *scale )( int n, double k, const double *V, double *U );
+	void   ( *axpby )( int n, double a, const double *X, double b, double *Y );
+	double ( *dot )( int n, const double *V, const double *U );
+} simd = { SIMD_C, add_c, scale_c, axpby_c, dot_c };
+
+/* This function returns the SIMD instruction set of this CPU, from its
+   CPUID flags: SIMD_C, SIMD_SSE2, SIMD_AVX2 or SIMD_AVX512.
+*/
+int simd_cpu( void ) {
+#ifdef LILA_X86
+	__builtin_cpu_init();
+	if( __builtin_cpu_supports( "avx512f" ) ) {
+	  return( SIMD_AVX512 );
+	}
+	if( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) ) {
+	  return( SIMD_AVX2 );
+	}
+	if( __builtin_cpu_supports( "sse2" ) ) {
+	  return( SIMD_SSE2 );
+	}
+#endif
+	return( SIMD_C );
+}
+/* This function sets the level-1 loops of the table simd to the
+   versions of a given instruction set (the ones of this CPU, if level
+   is -1). It runs once at startup, and may be called again, e.g. to
+   compare the versions. It returns the level chosen.
+*/
+int simd_init( int level ) {
+	if( level < 0 || level > simd_cpu() ) {
+	  level = simd_cpu();
+	}
+	simd.level = level;
+	simd.add = add_c;
+	simd.scale = scale_c;
+	simd.axpby = axpby_c;
+	simd.dot = dot_c;
+#ifdef LILA_X86
+	if( level == SIMD_SSE2 ) {
+	  simd.add = add_sse2;
+	  simd.scale = scale_sse2;
+	  simd.axpby = axpby_sse2;
+	  simd.dot = dot_sse2;
+	}
+	if( level == SIMD_AVX2 ) {
+	  simd.add = add_avx2;
+	  simd.scale = scale_avx2;
+	  simd.axpby = axpby_avx2;
+	  simd.dot = dot_avx2;
+	}
+	if( level == SIMD_AVX512 ) {
+	  simd.add = add_avx512;
+	  simd.scale = scale_avx512;
+	  simd.axpby = axpby_avx512;
+	  simd.dot = dot_avx512;
+	}
+#endif
+	return( level );
+}
+__attribute__(( constructor ))
+static void simd_start( void ) {
+	simd_init( -1 );
+	return;
+}
 //=================================================
 //	1.1. SUMMATION OF TWO VECTORS
 //=================================================
@@ -10,11 +306,7 @@
    result is set into a vector W.
 */
 void sum_rvec( int n, double *V, double *U, double *W ) {
-	int i;
-
-	for( i = 0; i < n; i++ ) {
-	  W[i] = V[i] + U[i];
-	}
+	simd.add( n, V, U, W );
 	return;
 }
 //====================================================
@@ -24,11 +316,7 @@ void sum_rvec( int n, double *V, double *U, double *W ) {
    and the result is set into a vector U.
 */
 void smult_rvec( double k, int n, double *V, double *U ) {
-	int i;
-
-	for( i = 0; i < n; i++ ) {
-	  U[i] = k * V[i];
-	}
+	simd.scale( n, k, V, U );
 	return;
 }
 //==============================================================
@@ -38,14 +326,7 @@ void smult_rvec( double k, int n, double *V, double *U ) {
    V and U.
 */
 double dot_rvec( int n, double *V, double *U) {
-	int i;
-	double dot;
-
-	dot = 0;
-	for( i = 0; i < n; i++ ) {
-	  dot = dot + V[i] * U[i];
-	}
-	return( dot );
+	return( simd.dot( n, V, U ) );
 }
 //==============================================================
 //	1.4. CROSS PRODUCT OF TWO 3-DIMENSIONAL VECTORS
@@ -60,6 +341,60 @@ void cross3_rvec( double *V, double *U, double *W ) {
 
 	return;
 }
+//==============================================================
+//	1.5. LINEAR COMBINATIONS OF TWO VECTORS (AXPY AND AXPBY)
+//==============================================================
+/* This function sets a * X + Y into the n-dimensional vector Y.
+*/
+void axpy_rvec( int n, double a, double *X, double *Y ) {
+	simd.axpby( n, a, X, 1, Y );
+	return;
+}
+/* This function sets a * X + b * Y into the n-dimensional vector Y.
+*/
+void axpby_rvec( int n, double a, double *X, double b, double *Y ) {
+	simd.axpby( n, a, X, b, Y );
+	return;
+}
+//==============================================================
+//	1.6. SCALING OF A VECTOR
+//==============================================================
+/* This function multiplies a n-dimensional vector V by a scalar k.
+*/
+void scal_rvec( int n, double k, double *V ) {
+	simd.scale( n, k, V, V );
+	return;
+}
+//==============================================================
+//	1.7. EUCLIDEAN NORM OF A VECTOR
+//==============================================================
+/* This function returns the euclidean norm of a n-dimensional vector
+   V. The sum of squares is computed directly; only if it overflows or
+   underflows, V is scaled by its largest element and summed again.
+*/
+double nrm2_rvec( int n, double *V ) {
+	int    i;
+	double s, vmax, x;
+
+	s = simd.dot( n, V, V );
+	if( s > 1e-290 && s < 1e290 ) {
+	  return( sqrt( s ) );
+	}
+
+	vmax = 0;
+	for( i = 0; i < n; i++ ) {
+	  vmax = ( fabs( V[i] ) > vmax ) ? fabs( V[i] ) : vmax;
+	}
+	if( vmax == 0 || isinf( vmax ) || isnan( s ) ) {
+	  return( ( vmax == 0 ) ? 0 : sqrt( s ) );
+	}
+	s = 0;
+	for( i = 0; i < n; i++ ) {
+	  x = V[i] / vmax;
+	  s = s + x * x;
+	}
+	return( vmax * sqrt( s ) );
+}
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //	2. TYPES OF MATRICES
@@ -67,19 +402,289 @@ void cross3_rvec( double *V, double *U, double *W ) {
 //=================================================
 //	2.1. TRANSPOSE OF A MATRIX
 //=================================================
+/* The transposes below move t-X-t tiles, which are transposed in
+   registers: 4-X-4 with AVX, 8-X-8 with AVX-512 (and 4-X-4 scalar
+   tiles otherwise). Out of place, the matrix is split recursively in
+   halves of its longer side down to TRANS_LEAF-X-TRANS_LEAF blocks,
+   which fit in the L1 cache whatever its size is.
+*/
+#define TRANS_LEAF	32
+#define TRANS_PAR	65536	// Elements above which threads are used.
+
+// Tile T(k:k+t, l:l+t) = transpose( A(i:i+t, j:j+t) ).
+typedef void Trans_kern( double **A, int i, int j, double **T, int k, int l );
+
+static void trans_kern_c( double **A, int i, int j, double **T, int k,
+                          int l ) {
+	int r, c;
+
+	for( r = 0; r < 4; r++ ) {
+	  for( c = 0; c < 4; c++ ) {
+	    T[k + c][l + r] = A[i + r][j + c];
+	  }
+	}
+	return;
+}
+
+#ifdef LILA_X86
+__attribute__(( target( "avx" ) ))
+static void trans_kern_avx( double **A, int i, int j, double **T, int k,
+                            int l ) {
+	__m256d r0, r1, r2, r3, t0, t1, t2, t3;
+
+	r0 = _mm256_loadu_pd( A[i] + j );
+	r1 = _mm256_loadu_pd( A[i + 1] + j );
+	r2 = _mm256_loadu_pd( A[i + 2] + j );
+	r3 = _mm256_loadu_pd( A[i + 3] + j );
+	t0 = _mm256_unpacklo_pd( r0, r1 );
+	t1 = _mm256_unpackhi_pd( r0, r1 );
+	t2 = _mm256_unpacklo_pd( r2, r3 );
+	t3 = _mm256_unpackhi_pd( r2, r3 );
+	_mm256_storeu_pd( T[k] + l, _mm256_permute2f128_pd( t0, t2, 0x20 ) );
+	_mm256_storeu_pd( T[k + 1] + l, _mm256_permute2f128_pd( t1, t3, 0x20 ) );
+	_mm256_storeu_pd( T[k + 2] + l, _mm256_permute2f128_pd( t0, t2, 0x31 ) );
+	_mm256_storeu_pd( T[k + 3] + l, _mm256_permute2f128_pd( t1, t3, 0x31 ) );
+	_mm256_zeroupper();
+	return;
+}
+
+__attribute__(( target( "avx512f" ) ))
+static void trans_kern_avx512( double **A, int i, int j, double **T, int k,
+                               int l ) {
+	int     r;
+	__m512d a[8], t[8], u[8];
+
+	for( r = 0; r < 8; r++ ) {
+	  a[r] = _mm512_loadu_pd( A[i + r] + j );
+	}
+	for( r = 0; r < 8; r = r + 2 ) { // Pairs of rows, by element.
+	  t[r] = _mm512_unpacklo_pd( a[r], a[r + 1] );
+	  t[r + 1] = _mm512_unpackhi_pd( a[r], a[r + 1] );
+	}
+	for( r = 0; r < 8; r = r + 4 ) { // Quads of rows, by 128-bit lane.
+	  u[r] = _mm512_shuffle_f64x2( t[r], t[r + 2], 0x88 );
+	  u[r + 1] = _mm512_shuffle_f64x2( t[r], t[r + 2], 0xDD );
+	  u[r + 2] = _mm512_shuffle_f64x2( t[r + 1], t[r + 3], 0x88 );
+	  u[r + 3] = _mm512_shuffle_f64x2( t[r + 1], t[r + 3], 0xDD );
+	}
+	_mm512_storeu_pd( T[k] + l, _mm512_shuffle_f64x2( u[0], u[4], 0x88 ) );
+	_mm512_storeu_pd( T[k + 1] + l, _mm512_shuffle_f64x2( u[2], u[6], 0x88 ) );
+	_mm512_storeu_pd( T[k + 2] + l, _mm512_shuffle_f64x2( u[1], u[5], 0x88 ) );
+	_mm512_storeu_pd( T[k + 3] + l, _mm512_shuffle_f64x2( u[3], u[7], 0x88 ) );
+	_mm512_storeu_pd( T[k + 4] + l, _mm512_shuffle_f64x2( u[0], u[4], 0xDD ) );
+	_mm512_storeu_pd( T[k + 5] + l, _mm512_shuffle_f64x2( u[2], u[6], 0xDD ) );
+	_mm512_storeu_pd( T[k + 6] + l, _mm512_shuffle_f64x2( u[1], u[5], 0xDD ) );
+	_mm512_storeu_pd( T[k + 7] + l, _mm512_shuffle_f64x2( u[3], u[7], 0xDD ) );
+	_mm256_zeroupper();
+	return;
+}
+#endif
+
+// The tile kernel of the SIMD level in use; its tile size is set in t.
+static Trans_kern *trans_kern( int *t ) {
+	*t = 4;
+#ifdef LILA_X86
+	if( simd.level == SIMD_AVX512 ) {
+	  *t = 8;
+	  return( trans_kern_avx512 );
+	}
+	if( simd.level == SIMD_AVX2 ) {
+	  return( trans_kern_avx );
+	}
+#endif
+	return( trans_kern_c );
+}
+
+// T = transpose( A ) for rows i0:i1 and columns j0:j1 of A.
+static void trans_rec( int i0, int i1, int j0, int j1, double **A,
+                       double **T, int t, Trans_kern *kern ) {
+	int i, j, h;
+
+	if( i1 - i0 > TRANS_LEAF || j1 - j0 > TRANS_LEAF ) {
+	  if( i1 - i0 >= j1 - j0 ) {
+	    h = ( i1 - i0 ) / 2;
+	    h = i0 + h - h % t;
+	    trans_rec( i0, h, j0, j1, A, T, t, kern );
+	    trans_rec( h, i1, j0, j1, A, T, t, kern );
+	  }
+	  else {
+	    h = ( j1 - j0 ) / 2;
+	    h = j0 + h - h % t;
+	    trans_rec( i0, i1, j0, h, A, T, t, kern );
+	    trans_rec( i0, i1, h, j1, A, T, t, kern );
+	  }
+	  return;
+	}
+
+	for( i = i0; i + t <= i1; i = i + t ) {
+	  for( j = j0; j + t <= j1; j = j + t ) {
+	    kern( A, i, j, T, j, i );
+	  }
+	  for( ; j < j1; j++ ) {
+	    for( h = i; h < i + t; h++ ) {
+	      T[j][h] = A[h][j];
+	    }
+	  }
+	}
+	for( ; i < i1; i++ ) {
+	  for( j = j0; j < j1; j++ ) {
+	    T[j][i] = A[i][j];
+	  }
+	}
+	return;
+}
+
+typedef struct {
+	int        n, m, t, band;
+	double     **A, **T;
+	Trans_kern *kern;
+} Trans_arg;
+
+static void trans_task( int b, void *arg ) {
+	Trans_arg *a = ( Trans_arg* ) arg;
+	int       i1;
+
+	i1 = ( b + 1 ) * a->band;
+	trans_rec( b * a->band, ( i1 < a->n ) ? i1 : a->n, 0, a->m, a->A, a->T,
+	           a->t, a->kern );
+	return;
+}
+
 /* This function receives a n-X-m matrix A and finds its transpose,
-   a m-X-n matrix T.
+   a m-X-n matrix T. A and T must not overlap. Large matrices are
+   split in bands of rows among the threads of the pool.
 */
 void trans_rmat( int n, int m, double **A, double **T ) {
-	int i, j;
+	Trans_arg a;
 
-	for( i = 0; i < n; i++ ) {
-	  for( j = 0; j < m; j++ ) {
-	    T[j][i] = A[i][j];
+	a.kern = trans_kern( &a.t );
+	if( tpool_par() && ( double ) n * m > TRANS_PAR ) {
+	  a.n = n;
+	  a.m = m;
+	  a.A = A;
+	  a.T = T;
+	  a.band = TRANS_LEAF * ( 1 + n / ( TRANS_LEAF * 4 * tpool_size() ) );
+	  tpool_for( ( n + a.band - 1 ) / a.band, trans_task, &a );
+	  return;
+	}
+	trans_rec( 0, n, 0, m, A, T, a.t, a.kern );
+	return;
+}
+
+// Tiles A(i,j) and A(j,i) are swapped and transposed (i = j is allowed).
+static void trans_swap( double **A, int i, int j, int t, Trans_kern *kern ) {
+	int    r;
+	double buf[64], *B[8];
+
+	for( r = 0; r < t; r++ ) {
+	  B[r] = buf + r * t;
+	  memcpy( B[r], A[j + r] + i, t * sizeof( double ) );
+	}
+	if( i != j ) {
+	  kern( A, i, j, A, j, i );
+	}
+	kern( B, 0, 0, A, i, j );
+	return;
+}
+
+/* This function transposes a n-X-n matrix A in place. Pairs of
+   tiles A(i,j) and A(j,i) are swapped, TRANS_LEAF-X-TRANS_LEAF block
+   by block.
+*/
+void sqtrans_rmat( int n, double **A ) {
+	int        t, nt, bi, bj, i, j, i1, j1;
+	double     x;
+	Trans_kern *kern;
+
+	kern = trans_kern( &t );
+	nt = n - n % t;
+	for( bi = 0; bi < nt; bi = bi + TRANS_LEAF ) {
+	  i1 = ( bi + TRANS_LEAF < nt ) ? bi + TRANS_LEAF : nt;
+	  for( bj = bi; bj < nt; bj = bj + TRANS_LEAF ) {
+	    j1 = ( bj + TRANS_LEAF < nt ) ? bj + TRANS_LEAF : nt;
+	    for( i = bi; i < i1; i = i + t ) {
+	      for( j = ( bi == bj ) ? i : bj; j < j1; j = j + t ) {
+	        trans_swap( A, i, j, t, kern );
+	      }
+	    }
+	  }
+	}
+	for( j = nt; j < n; j++ ) {
+	  for( i = 0; i < j; i++ ) {
+	    x = A[i][j];
+	    A[i][j] = A[j][i];
+	    A[j][i] = x;
 	  }
 	}
 	return;
 }
+
+/* This function transposes in place a n-X-m matrix A, so A becomes
+   m-X-n (its dimensions and row pointers are changed). A square
+   matrix may be any matrix, a view included. A rectangular one must
+   own its elements (see new_rmat; not a view, nor a matrix of
+   bin_map_rmat): its elements are moved along the cycles of the
+   permutation p -> p * n mod ( n * m - 1 ), which needs one bit per
+   element to mark the moved ones, and its row pointers are
+   reallocated for the m rows. It returns -1 if a rectangular A is
+   empty or does not own its elements, or if that memory is not
+   available.
+*/
+int itrans_rmat( Rmat *A ) {
+	int      i, n, m;
+	size_t   N, p, q, s;
+	double   x, **row;
+	uint64_t *done;
+
+	n = A->n;
+	m = A->m;
+	if( n == m ) {
+	  sqtrans_rmat( n, A->row );
+	  return( 0 );
+	}
+	if( n == 0 || m == 0 || !A->own ) {
+	  return( -1 );
+	}
+	if( m > n ) {
+	  row = ( double** ) realloc( A->row, m * sizeof( double* ) );
+	  if( row == NULL ) {
+	    return( -1 );
+	  }
+	  A->row = row;
+	}
+
+	N = ( size_t ) n * m;
+	done = ( uint64_t* ) calloc( N / 64 + 1, sizeof( uint64_t ) );
+	if( done == NULL ) {
+	  return( -1 );
+	}
+	for( s = 1; s + 1 < N; s++ ) {
+	  if( done[s / 64] >> ( s % 64 ) & 1 ) {
+	    continue;
+	  }
+	  x = A->val[s];
+	  p = s;
+	  for( ; ; ) { // A->val[p] takes the element which moves to p.
+	    done[p / 64] = done[p / 64] | ( uint64_t ) 1 << ( p % 64 );
+	    q = p * m % ( N - 1 );
+	    if( q == s ) {
+	      break;
+	    }
+	    A->val[p] = A->val[q];
+	    p = q;
+	  }
+	  A->val[p] = x;
+	}
+	free( done );
+
+	A->n = m;
+	A->m = n;
+	A->ld = n;
+	for( i = 0; i < m; i++ ) {
+	  A->row[i] = A->val + ( size_t ) i * n;
+	}
+	return( 0 );
+}
 //=================================================
 //	2.2. ZERO MATRIX
 //=================================================
@@ -213,62 +818,647 @@ void smult_rmat( double k, int n, int m, double **A, double **B ) {
 //===================================================
 //	3.3. MULTIPLICATION OF TWO MATRICES
 //===================================================
-/* This function multiplies a n-X-m real matrix A and m-X-p real
-   matrix B, and the result is set into a n-X-p matrix C.
+/* The general matrix multiplication (GEMM) below follows the
+   GotoBLAS/BLIS scheme. B is packed in KC-X-NC panels (meant to stay
+   in L3 cache) and A in MC-X-KC blocks (L2), both laid out in slivers
+   of NR columns and MR rows. A SIMD micro-kernel then multiplies one
+   MR-row sliver by one NR-column sliver, keeping the MR-X-NR tile of
+   C in registers along the whole KC depth.
 */
-void mult_rmat( int n, int m, int p, double **A, double **B,
-                double **C ) {
-	int i, j, k;
+#define GEMM_MC		96	// Rows of a packed block of A.
+#define GEMM_KC		256	// Depth of the packed blocks.
+#define GEMM_NC		2048	// Columns of a packed panel of B.
+#define GEMM_MAXMR	8	// Largest micro-kernel tile.
+#define GEMM_MAXNR	16
+#define GEMM_SMALL	32768	// Below n*m*p, no packing is done.
+#define GEMM_PAR	1048576	// Below n*m*p, no threads are used.
 
-	for( i = 0; i < n; i++ ) {
-	  for( j = 0; j < p; j++ ) {
-	    C[i][j] = 0;
+// Micro-kernel: T (MR-X-NR, row-major) = Ap * Bp over a depth kc.
+typedef void ( *Gemm_kern )( int kc, const double *Ap, const double *Bp,
+                             double *T );
+
+static void gemm_kern_c( int kc, const double *Ap, const double *Bp,
+                         double *T ) {
+	int k, r, c;
+	double acc[4 * 8] = { 0 };
 
-	    for( k = 0; k < m; k++ ) {
-	      C[i][j] = C[i][j] + A[i][k] * B[k][j];
+	for( k = 0; k < kc; k++ ) {
+	  for( r = 0; r < 4; r++ ) {
+	    for( c = 0; c < 8; c++ ) {
+	      acc[r * 8 + c] = acc[r * 8 + c] + Ap[r] * Bp[c];
 	    }
 	  }
-	}	
+	  Ap = Ap + 4;
+	  Bp = Bp + 8;
+	}
+	memcpy( T, acc, sizeof( acc ) );
 	return;
 }
-//===================================================
-//	3.4. DOUBLE-DOT MATRIX PRODUCT
-//===================================================
-/* This function returns the double dot product of two n-X-m matrices,
-   A and B.
-*/
-double dbdot_rmat( int n, int m, double **A, double **B ) {
-	int i, j;
-	double dbdot;
 
-	dbdot = 0;
-	for( i = 0; i < n; i++ ) {
-	  for( j = 0; j < m; j++ ) {
-	    dbdot = dbdot + A[i][j] * B[i][j];
-	  }
+#ifdef LILA_X86
+__attribute__(( target( "avx2,fma" ) ))
+static void gemm_kern_avx2( int kc, const double *Ap, const double *Bp,
+                            double *T ) {
+	int k;
+	__m256d a, b0, b1;
+	__m256d c00, c01, c10, c11, c20, c21, c30, c31, c40, c41, c50, c51;
+
+	c00 = c01 = c10 = c11 = c20 = c21 = _mm256_setzero_pd();
+	c30 = c31 = c40 = c41 = c50 = c51 = _mm256_setzero_pd();
+	for( k = 0; k < kc; k++ ) { // 6-X-8 tile in 12 registers.
+	  b0 = _mm256_load_pd( Bp );
+	  b1 = _mm256_load_pd( Bp + 4 );
+	  a = _mm256_broadcast_sd( Ap );
+	  c00 = _mm256_fmadd_pd( a, b0, c00 );
+	  c01 = _mm256_fmadd_pd( a, b1, c01 );
+	  a = _mm256_broadcast_sd( Ap + 1 );
+	  c10 = _mm256_fmadd_pd( a, b0, c10 );
+	  c11 = _mm256_fmadd_pd( a, b1, c11 );
+	  a = _mm256_broadcast_sd( Ap + 2 );
+	  c20 = _mm256_fmadd_pd( a, b0, c20 );
+	  c21 = _mm256_fmadd_pd( a, b1, c21 );
+	  a = _mm256_broadcast_sd( Ap + 3 );
+	  c30 = _mm256_fmadd_pd( a, b0, c30 );
+	  c31 = _mm256_fmadd_pd( a, b1, c31 );
+	  a = _mm256_broadcast_sd( Ap + 4 );
+	  c40 = _mm256_fmadd_pd( a, b0, c40 );
+	  c41 = _mm256_fmadd_pd( a, b1, c41 );
+	  a = _mm256_broadcast_sd( Ap + 5 );
+	  c50 = _mm256_fmadd_pd( a, b0, c50 );
+	  c51 = _mm256_fmadd_pd( a, b1, c51 );
+	  Ap = Ap + 6;
+	  Bp = Bp + 8;
 	}
-	return( dbdot );
+	_mm256_storeu_pd( T, c00 );      _mm256_storeu_pd( T + 4, c01 );
+	_mm256_storeu_pd( T + 8, c10 );  _mm256_storeu_pd( T + 12, c11 );
+	_mm256_storeu_pd( T + 16, c20 ); _mm256_storeu_pd( T + 20, c21 );
+	_mm256_storeu_pd( T + 24, c30 ); _mm256_storeu_pd( T + 28, c31 );
+	_mm256_storeu_pd( T + 32, c40 ); _mm256_storeu_pd( T + 36, c41 );
+	_mm256_storeu_pd( T + 40, c50 ); _mm256_storeu_pd( T + 44, c51 );
+	_mm256_zeroupper();
+	return;
 }
-//===================================================
-//	3.5. POWER OF A MATRIX
-//===================================================
-/* This function calculates the p-th power of a n-X-n square matrix A,
-   and the result is set into a square matrix B.
-*/
-void pow_rmat( int p, int n, double **A, double **B ) {
-	int i;
 
-	mult_rmat( n, n, n, A, A, B );
-	for( i = 2; i < p; i++ ) {
-	  mult_rmat( n, n, n, B, A, B );
+__attribute__(( target( "avx512f" ) ))
+static void gemm_kern_avx512( int kc, const double *Ap, const double *Bp,
+                              double *T ) {
+	int k, r;
+	__m512d a, b0, b1, c[12];
+
+	for( r = 0; r < 12; r++ ) {
+	  c[r] = _mm512_setzero_pd();
+	}
+	for( k = 0; k < kc; k++ ) { // 6-X-16 tile in 12 registers.
+	  b0 = _mm512_load_pd( Bp );
+	  b1 = _mm512_load_pd( Bp + 8 );
+	  for( r = 0; r < 6; r++ ) {
+	    a = _mm512_set1_pd( Ap[r] );
+	    c[2 * r] = _mm512_fmadd_pd( a, b0, c[2 * r] );
+	    c[2 * r + 1] = _mm512_fmadd_pd( a, b1, c[2 * r + 1] );
+	  }
+	  Ap = Ap + 6;
+	  Bp = Bp + 16;
+	}
+	for( r = 0; r < 12; r++ ) {
+	  _mm512_storeu_pd( T + 8 * r, c[r] );
 	}
+	_mm256_zeroupper();
 	return;
 }
-//================================================================
-//	3.6. INNER PRODUCT (DOT PRODUCT) OF TWO SLENDER MATRICES
-//================================================================
-/* Case 1. This function returns the dot product of two 1-X-n row
-   matrices, A and B.
+static const Gemm_kern gemm_simd[2] = { gemm_kern_avx2, gemm_kern_avx512 };
+#else
+static const Gemm_kern gemm_simd[2] = { NULL, NULL }; // Never chosen.
+#endif
+
+/* The rest of the GEMM is written once, by GEMM_TEMPLATE, for the
+   elements of type T: it is made here for 'double', and in section
+   3.12 for 'float', whose blocks hold GEMM_S( T ) times as many
+   elements so that they take as many bytes. Its functions are named
+   by G, and its micro-kernels are G_kern_c and G_simd[] (AVX2 and
+   AVX-512), the first one with a 4-X-8 tile and the others 6 rows
+   high. A product is described by a Tile:
+
+     C = C + alpha * op(A) * op(B), op(X) = X (t = 'N') or
+     transpose( X ) (t = 'T'),
+
+   for the block of C made by rows i0 to i1 - 1 and columns j0 to
+   j1 - 1, where m is the inner dimension, and A, B and C start at
+   (ia,ja), (ib,jb) and (ic,jc).
+
+   - G_k is the micro-kernel, chosen once, at startup, from the CPU
+     features (G_init).
+   - G_pack_a packs the mc-X-kc block of op(A) starting at (i0,k0) in
+     slivers of mr rows, and G_pack_b the kc-X-nc panel of op(B)
+     starting at (k0,j0) in slivers of nr columns; the last sliver is
+     padded with zeros.
+   - G_pack gives the packing buffers of the calling thread (a block
+     of A, then a panel of B). Each thread allocates them at its first
+     GEMM and keeps them until it ends, so the small products of the
+     blocked factorizations do not allocate memory.
+   - G_block computes the block of C of a tile, packing into the
+     buffers of its thread, so different blocks of C may be computed
+     at the same time. It sets the flag of the tile to -1 if memory
+     is not available.
+   - G_run computes a whole n-X-p product (the block of its tile is
+     set to all of C). Below GEMM_SMALL multiplications nothing is
+     packed; above GEMM_PAR, when the thread pool runs, C is split in
+     about four blocks per thread. Each element is computed by the
+     same sequence of operations either way. It returns -1 if memory
+     is not available.
+*/
+#define GEMM_S( T )	( ( int ) ( sizeof( double ) / sizeof( T ) ) )
+#define GEMM_APACK( s )	( ( GEMM_MC + GEMM_MAXMR ) * GEMM_KC * ( s ) )
+#define GEMM_BPACK( s )	( ( GEMM_NC + GEMM_MAXNR ) * GEMM_KC * ( s ) * ( s ) )
+
+// Element (i,j) of op(X), where X starts at (x0,y0).
+#define GEMM_AT( t, X, x0, y0, i, j )	( ( t ) == 'N' \
+	? ( X )[( x0 ) + ( i )][( y0 ) + ( j )] : ( X )[( x0 ) + ( j )][( y0 ) + ( i )] )
+
+#define GEMM_TEMPLATE( T, G, Kern, Tile ) \
+typedef struct { \
+	char ta, tb; \
+	int  m, i0, i1, j0, j1; \
+	int  ia, ja, ib, jb, ic, jc; \
+	int  flag; \
+	T    alpha, **A, **B, **C; \
+} Tile; \
+\
+static struct { \
+	int  mr, nr; /* Tile of C kept in registers. */ \
+	Kern kern; \
+} G##_k = { 4, 8, G##_kern_c }; \
+\
+__attribute__(( constructor )) \
+static void G##_init( void ) { \
+	int level = simd_cpu(); \
+\
+	if( level == SIMD_AVX2 || level == SIMD_AVX512 ) { \
+	  G##_k.mr = 6; \
+	  G##_k.nr = ( level == SIMD_AVX512 ? 16 : 8 ) * GEMM_S( T ); \
+	  G##_k.kern = G##_simd[level == SIMD_AVX512]; \
+	} \
+	return; \
+} \
+\
+static void G##_pack_a( Tile *t, int mc, int kc, int i0, int k0, T *Ap ) { \
+	int i, k, r, a0, b0, mr = G##_k.mr; \
+\
+	a0 = t->ia + ( ( t->ta == 'N' ) ? i0 : k0 ); \
+	b0 = t->ja + ( ( t->ta == 'N' ) ? k0 : i0 ); \
+	for( i = 0; i < mc; i = i + mr ) { \
+	  for( r = 0; r < mr; r++ ) { \
+	    if( i + r >= mc ) { \
+	      for( k = 0; k < kc; k++ ) { \
+	        Ap[k * mr + r] = 0; \
+	      } \
+	    } \
+	    else if( t->ta == 'N' ) { \
+	      for( k = 0; k < kc; k++ ) { \
+	        Ap[k * mr + r] = t->A[a0 + i + r][b0 + k]; \
+	      } \
+	    } \
+	    else { \
+	      for( k = 0; k < kc; k++ ) { \
+	        Ap[k * mr + r] = t->A[a0 + k][b0 + i + r]; \
+	      } \
+	    } \
+	  } \
+	  Ap = Ap + mr * kc; \
+	} \
+	return; \
+} \
+\
+static void G##_pack_b( Tile *t, int kc, int nc, int k0, int j0, T *Bp ) { \
+	int j, k, c, w, a0, b0, nr = G##_k.nr; \
+\
+	a0 = t->ib + ( ( t->tb == 'N' ) ? k0 : j0 ); \
+	b0 = t->jb + ( ( t->tb == 'N' ) ? j0 : k0 ); \
+	for( j = 0; j < nc; j = j + nr ) { \
+	  w = ( nc - j < nr ) ? nc - j : nr; \
+\
+	  if( t->tb == 'N' ) { \
+	    for( k = 0; k < kc; k++ ) { \
+	      for( c = 0; c < w; c++ ) { \
+	        Bp[k * nr + c] = t->B[a0 + k][b0 + j + c]; \
+	      } \
+	      for( ; c < nr; c++ ) { \
+	        Bp[k * nr + c] = 0; \
+	      } \
+	    } \
+	  } \
+	  else { \
+	    for( c = 0; c < nr; c++ ) { \
+	      for( k = 0; k < kc; k++ ) { \
+	        Bp[k * nr + c] = ( c < w ) ? t->B[a0 + j + c][b0 + k] : 0; \
+	      } \
+	    } \
+	  } \
+	  Bp = Bp + nr * kc; \
+	} \
+	return; \
+} \
+\
+static pthread_once_t G##_once = PTHREAD_ONCE_INIT; \
+static pthread_key_t  G##_key; \
+static int            G##_keyok = 0; \
+\
+static void G##_keyinit( void ) { \
+	G##_keyok = ( pthread_key_create( &G##_key, free ) == 0 ); \
+	return; \
+} \
+\
+static T *G##_pack( void ) { \
+	T *W; \
+\
+	pthread_once( &G##_once, G##_keyinit ); \
+	if( !G##_keyok ) { \
+	  return( NULL ); \
+	} \
+	W = ( T* ) pthread_getspecific( G##_key ); \
+	if( W == NULL ) { \
+	  W = ( T* ) aligned_alloc( RMAT_ALIGN, ( GEMM_APACK( GEMM_S( T ) ) \
+	      + GEMM_BPACK( GEMM_S( T ) ) ) * sizeof( T ) ); \
+	  if( W != NULL && pthread_setspecific( G##_key, W ) != 0 ) { \
+	    free( W ); \
+	    W = NULL; \
+	  } \
+	} \
+	return( W ); \
+} \
+\
+static void G##_block( Tile *t ) { \
+	int ic, jc, pc, ir, jr, mc, nc, kc, r, c, mr, nr, KC, NC; \
+	T   *Ap, *Bp, *P, W[GEMM_MAXMR * GEMM_MAXNR * GEMM_S( T )]; \
+\
+	mr = G##_k.mr; \
+	nr = G##_k.nr; \
+	KC = GEMM_KC * GEMM_S( T ); \
+	NC = GEMM_NC * GEMM_S( T ); \
+	t->flag = 0; \
+	Ap = G##_pack(); \
+	if( Ap == NULL ) { \
+	  t->flag = -1; \
+	  return; \
+	} \
+	Bp = Ap + GEMM_APACK( GEMM_S( T ) ); \
+\
+	for( jc = t->j0; jc < t->j1; jc = jc + NC ) { \
+	  nc = ( t->j1 - jc < NC ) ? t->j1 - jc : NC; \
+\
+	  for( pc = 0; pc < t->m; pc = pc + KC ) { \
+	    kc = ( t->m - pc < KC ) ? t->m - pc : KC; \
+	    G##_pack_b( t, kc, nc, pc, jc, Bp ); \
+\
+	    for( ic = t->i0; ic < t->i1; ic = ic + ( GEMM_MC / mr ) * mr ) { \
+	      mc = ( t->i1 - ic < ( GEMM_MC / mr ) * mr ) ? t->i1 - ic \
+	           : ( GEMM_MC / mr ) * mr; \
+	      G##_pack_a( t, mc, kc, ic, pc, Ap ); \
+\
+	      for( jr = 0; jr < nc; jr = jr + nr ) { \
+	        for( ir = 0; ir < mc; ir = ir + mr ) { \
+	          G##_k.kern( kc, Ap + ir * kc, Bp + jr * kc, W ); \
+\
+	          for( r = 0; r < mr && ir + r < mc; r++ ) { \
+	            P = t->C[t->ic + ic + ir + r] + t->jc + jc + jr; \
+	            for( c = 0; c < nr && jr + c < nc; c++ ) { \
+	              P[c] = P[c] + t->alpha * W[r * nr + c]; \
+	            } \
+	          } \
+	        } \
+	      } \
+	    } \
+	  } \
+	} \
+	return; \
+} \
+\
+static void G##_task( int k, void *arg ) { \
+	G##_block( ( Tile* ) arg + k ); \
+	return; \
+} \
+\
+static int G##_run( int n, int p, Tile *t0 ) { \
+	int  i, j, k, m, rb, cb, nr, nc, flag; \
+	T    sum; \
+	Tile *t; \
+\
+	m = t0->m; \
+	if( n == 0 || p == 0 || m == 0 ) { \
+	  return( 0 ); \
+	} \
+	if( ( double ) n * m * p < GEMM_SMALL ) { \
+	  for( i = 0; i < n; i++ ) { \
+	    for( j = 0; j < p; j++ ) { \
+	      sum = 0; \
+	      for( k = 0; k < m; k++ ) { \
+	        sum = sum + GEMM_AT( t0->ta, t0->A, t0->ia, t0->ja, i, k ) \
+	                  * GEMM_AT( t0->tb, t0->B, t0->ib, t0->jb, k, j ); \
+	      } \
+	      t0->C[t0->ic + i][t0->jc + j] = t0->C[t0->ic + i][t0->jc + j] \
+	                                      + t0->alpha * sum; \
+	    } \
+	  } \
+	  return( 0 ); \
+	} \
+\
+	t0->i0 = t0->j0 = 0; \
+	t0->i1 = n; \
+	t0->j1 = p; \
+	if( ( double ) n * m * p < GEMM_PAR || !tpool_par() ) { \
+	  G##_block( t0 ); \
+	  return( t0->flag ); \
+	} \
+	rb = ( n + 2 * tpool_size() - 1 ) / ( 2 * tpool_size() ); \
+	rb = ( ( rb + G##_k.mr - 1 ) / G##_k.mr ) * G##_k.mr; \
+	rb = ( rb < 4 * G##_k.mr ) ? 4 * G##_k.mr : rb; \
+	nr = ( n + rb - 1 ) / rb; \
+	nc = ( 4 * tpool_size() + nr - 1 ) / nr; \
+	cb = ( p + nc - 1 ) / nc; \
+	cb = ( ( cb + G##_k.nr - 1 ) / G##_k.nr ) * G##_k.nr; \
+	cb = ( cb < 4 * G##_k.nr ) ? 4 * G##_k.nr : cb; \
+	nc = ( p + cb - 1 ) / cb; \
+\
+	t = ( Tile* ) malloc( nr * nc * sizeof( Tile ) ); \
+	if( t == NULL ) { \
+	  return( -1 ); \
+	} \
+	for( i = 0; i < nr; i++ ) { \
+	  for( j = 0; j < nc; j++ ) { \
+	    k = i * nc + j; \
+	    t[k] = *t0; \
+	    t[k].i0 = i * rb; \
+	    t[k].i1 = ( ( i + 1 ) * rb < n ) ? ( i + 1 ) * rb : n; \
+	    t[k].j0 = j * cb; \
+	    t[k].j1 = ( ( j + 1 ) * cb < p ) ? ( j + 1 ) * cb : p; \
+	  } \
+	} \
+	flag = tpool_for( nr * nc, G##_task, t ); \
+	for( k = 0; k < nr * nc; k++ ) { \
+	  flag = flag | t[k].flag; \
+	} \
+	free( t ); \
+	return( flag ); \
+}
+
+GEMM_TEMPLATE( double, gemm, Gemm_kern, Gemm_tile )
+
+// Comparison of two addresses, for qsort.
+static int gemm_cmp( const void *a, const void *b ) {
+	uintptr_t x = *( const uintptr_t* ) a, y = *( const uintptr_t* ) b;
+
+	return( ( x > y ) - ( x < y ) );
+}
+// Sets [lo, hi) to the range of addresses of the n rows of m
+// elements of A.
+static void gemm_range( int n, int m, double **A, uintptr_t *lo,
+                        uintptr_t *hi ) {
+	int i;
+
+	*lo = *hi = ( uintptr_t ) A[0];
+	for( i = 1; i < n; i++ ) {
+	  *lo = ( ( uintptr_t ) A[i] < *lo ) ? ( uintptr_t ) A[i] : *lo;
+	  *hi = ( ( uintptr_t ) A[i] > *hi ) ? ( uintptr_t ) A[i] : *hi;
+	}
+	*hi = *hi + m * sizeof( double );
+	return;
+}
+/* Returns 1 if a row of A (na rows of ma elements) shares memory with
+   a row of C (nc rows of mc elements), or -1 if memory is not
+   available. Disjoint blocks of the same matrix do not alias. The
+   address ranges of A and C settle the usual case of two different
+   matrices; only when they overlap are the rows of A sorted and
+   searched.
+*/
+static int gemm_alias( int na, int ma, double **A, int nc, int mc,
+                       double **C ) {
+	int       i, lo, hi, mid, flag;
+	uintptr_t *S, c, alo, ahi, clo, chi;
+
+	if( na == 0 || nc == 0 || ma == 0 || mc == 0 ) {
+	  return( 0 );
+	}
+	gemm_range( na, ma, A, &alo, &ahi );
+	gemm_range( nc, mc, C, &clo, &chi );
+	if( ahi <= clo || chi <= alo ) {
+	  return( 0 );
+	}
+	S = ( uintptr_t* ) malloc( na * sizeof( uintptr_t ) );
+	if( S == NULL ) {
+	  return( -1 );
+	}
+	for( i = 0; i < na; i++ ) {
+	  S[i] = ( uintptr_t ) A[i];
+	}
+	qsort( S, na, sizeof( uintptr_t ), gemm_cmp );
+
+	flag = 0;
+	for( i = 0; i < nc && flag == 0; i++ ) {
+	  c = ( uintptr_t ) C[i];
+	  lo = 0; // First row of A starting after c - ma elements.
+	  hi = na;
+	  while( lo < hi ) {
+	    mid = ( lo + hi ) / 2;
+	    if( S[mid] + ma * sizeof( double ) > c ) {
+	      hi = mid;
+	    }
+	    else {
+	      lo = mid + 1;
+	    }
+	  }
+	  flag = ( lo < na && S[lo] < c + mc * sizeof( double ) );
+	}
+	free( S );
+	return( flag );
+}
+/* This function performs the general matrix multiplication
+   C = alpha * op(A) * op(B) + beta * C, where op(A) is a n-X-m matrix,
+   op(B) is a m-X-p matrix and C is a n-X-p matrix. The flags ta and tb
+   are 'N' for op(X) = X or 'T' for op(X) = transpose( X ). C may share
+   its elements with A or B: the product is then computed into an
+   auxiliary matrix. When the thread pool runs (see tpool_init), large
+   products are split in blocks of C computed by different threads;
+   every element is still computed by the same sequence of operations,
+   so the result does not depend on the number of threads. It returns
+   -1 if memory is not available.
+*/
+int gemm_rmat( char ta, char tb, int n, int m, int p, double alpha,
+               double **A, double **B, double beta, double **C ) {
+	int       i, j, na, ma, nb, mb;
+	double    **W;
+	Gemm_tile t;
+
+	na = ( ta == 'N' ) ? n : m;
+	ma = ( ta == 'N' ) ? m : n;
+	nb = ( tb == 'N' ) ? m : p;
+	mb = ( tb == 'N' ) ? p : m;
+
+	if( gemm_alias( na, ma, A, n, p, C ) != 0
+	    || gemm_alias( nb, mb, B, n, p, C ) != 0 ) {
+	  if( alloc_rmat( n, p, &W ) != 0 ) {
+	    return( -1 );
+	  }
+	  for( i = 0; i < n; i++ ) {
+	    memcpy( W[i], C[i], p * sizeof( double ) );
+	  }
+	  if( gemm_rmat( ta, tb, n, m, p, alpha, A, B, beta, W ) != 0 ) {
+	    free_rmat( n, &W );
+	    return( -1 );
+	  }
+	  for( i = 0; i < n; i++ ) {
+	    memcpy( C[i], W[i], p * sizeof( double ) );
+	  }
+	  free_rmat( n, &W );
+	  return( 0 );
+	}
+
+	for( i = 0; i < n; i++ ) { // C = beta * C.
+	  for( j = 0; j < p; j++ ) {
+	    C[i][j] = ( beta == 0 ) ? 0 : beta * C[i][j];
+	  }
+	}
+	if( alpha == 0 || m == 0 ) {
+	  return( 0 );
+	}
+
+	t.ta = ta;
+	t.tb = tb;
+	t.m = m;
+	t.ia = t.ja = t.ib = t.jb = t.ic = t.jc = 0;
+	t.alpha = alpha;
+	t.A = A;
+	t.B = B;
+	t.C = C;
+	return( gemm_run( n, p, &t ) );
+}
+/* This function multiplies a n-X-m real matrix A and m-X-p real
+   matrix B, and the result is set into a n-X-p matrix C. C may be
+   the same matrix as A or B.
+*/
+void mult_rmat( int n, int m, int p, double **A, double **B,
+                double **C ) {
+	gemm_rmat( 'N', 'N', n, m, p, 1, A, B, 0, C );
+	return;
+}
+/* This function calls gemm_rmat on sub-matrices: op(A) is read from
+   A starting at A[ia][ja], op(B) from B starting at B[ib][jb] and the
+   n-X-p result goes to C starting at C[ic][jc].
+*/
+int gemm_sub_rmat( char ta, char tb, int n, int m, int p, double alpha,
+                   double **A, int ia, int ja, double **B, int ib, int jb,
+                   double beta, double **C, int ic, int jc ) {
+	int    flag;
+	double **VA, **VB, **VC;
+
+	if( n == 0 || p == 0 ) {
+	  return( 0 );
+	}
+	flag = sub_rmat( ia, ja, ( ta == 'N' ) ? n : m, A, &VA );
+	flag = flag | sub_rmat( ib, jb, ( tb == 'N' ) ? m : p, B, &VB );
+	flag = flag | sub_rmat( ic, jc, n, C, &VC );
+
+	if( flag == 0 ) {
+	  flag = gemm_rmat( ta, tb, n, m, p, alpha, VA, VB, beta, VC );
+	}
+	free_rmat( 0, &VA );
+	free_rmat( 0, &VB );
+	free_rmat( 0, &VC );
+	return( flag );
+}
+//===================================================
+//	3.4. DOUBLE-DOT MATRIX PRODUCT
+//===================================================
+/* This function returns the double dot product of two n-X-m matrices,
+   A and B.
+*/
+double dbdot_rmat( int n, int m, double **A, double **B ) {
+	int i;
+	double dbdot;
+
+	dbdot = 0;
+	for( i = 0; i < n; i++ ) {
+	  dbdot = dbdot + simd.dot( m, A[i], B[i] );
+	}
+	return( dbdot );
+}
+//===================================================
+//	3.5. POWER OF A MATRIX
+//===================================================
+// One of B, W1 and W2 which is neither X nor R.
+static double **pow_free( double **X, double **R, double **B, double **W1,
+                          double **W2 ) {
+	if( B != X && B != R ) {
+	  return( B );
+	}
+	return( ( W1 != X && W1 != R ) ? W1 : W2 );
+}
+/* This function calculates the p-th power (p >= 0) of a n-X-n square
+   matrix A by repeated squaring, with about 2 * log2( p ) products
+   instead of p - 1, and the result is set into a square matrix B. W1
+   and W2 are n-X-n workspaces, so nothing is allocated, and none of
+   A, B, W1 and W2 may share memory.
+*/
+int pown_rmat( int p, int n, double **A, double **B, double **W1,
+               double **W2 ) {
+	int    i, flag;
+	double **X, **R, **F;
+
+	if( p <= 0 ) {
+	  ident_rmat( n, B );
+	  return( 0 );
+	}
+
+	// X = A^(2^k) and R = the product of the powers of A taken so far
+	// (none yet while R is NULL).
+	flag = 0;
+	X = A;
+	R = NULL;
+	for( ; ; ) {
+	  if( p & 1 ) {
+	    if( R == NULL ) {
+	      R = X;
+	    }
+	    else {
+	      F = pow_free( X, R, B, W1, W2 );
+	      flag = flag | gemm_rmat( 'N', 'N', n, n, n, 1, R, X, 0, F );
+	      R = F;
+	    }
+	  }
+	  p = p >> 1;
+	  if( p == 0 ) {
+	    break;
+	  }
+	  F = pow_free( X, R, B, W1, W2 );
+	  flag = flag | gemm_rmat( 'N', 'N', n, n, n, 1, X, X, 0, F );
+	  X = F;
+	}
+	if( R != B ) {
+	  for( i = 0; i < n; i++ ) {
+	    memcpy( B[i], R[i], n * sizeof( double ) );
+	  }
+	}
+	return( flag );
+}
+/* This function calculates the p-th power of a n-X-n square matrix A,
+   and the result is set into a square matrix B (see pown_rmat).
+*/
+void pow_rmat( int p, int n, double **A, double **B ) {
+	double **W1, **W2;
+
+	alloc_rmat( n, n, &W1 );
+	alloc_rmat( n, n, &W2 );
+	if( W1 != NULL && W2 != NULL ) {
+	  pown_rmat( p, n, A, B, W1, W2 );
+	}
+
+	free_rmat( n, &W1 );
+	free_rmat( n, &W2 );
+	return;
+}
+//================================================================
+//	3.6. INNER PRODUCT (DOT PRODUCT) OF TWO SLENDER MATRICES
+//================================================================
+/* Case 1. This function returns the dot product of two 1-X-n row
+   matrices, A and B. For plain vectors, see dot_rvec.
 */
 double dotrow_rmat( int n, double **A, double **B ) {
 	int j;
@@ -284,23 +1474,214 @@ double dotrow_rmat( int n, double **A, double **B ) {
    matrices, A and B.
 */
 double dotcol_rmat( int n, double **A, double **B ) {
-	int j;
+	int i;
 	double dot;
 
 	dot = 0;
-	for( j = 0; j < n; j++ ) {
-	  dot = dot + A[0][j] * B[0][j];
+	for( i = 0; i < n; i++ ) {
+	  dot = dot + A[i][0] * B[i][0];
 	}
 	return( dot );
 }
 //================================================================
-//	3.7. LU DECOMPOSITION
+//	3.7. TRIANGULAR SYSTEMS WITH MANY RIGHT-HAND SIDES
+//================================================================
+#define TRSM_NB		64	// Order of the diagonal blocks.
+
+// Element (i,j) of op(T).
+#define TRSM_OP( t, T, i, j )	( ( t ) == 'N' ? ( T )[i][j] : ( T )[j][i] )
+
+/* Unblocked version of trsm_rmat (see below).
+*/
+static void trsm_unb( char side, char uplo, char trans, char diag,
+                      int n, int k, double **T, double **B ) {
+	int i, j, l;
+	double x;
+
+	if( side == 'L' && uplo == 'L' && trans == 'N' ) {
+	  for( i = 0; i < n; i++ ) {
+	    for( j = 0; j < i; j++ ) {
+	      x = T[i][j];
+	      for( l = 0; l < k; l++ ) {
+	        B[i][l] = B[i][l] - x * B[j][l];
+	      }
+	    }
+	    if( diag == 'N' ) {
+	      for( l = 0; l < k; l++ ) {
+	        B[i][l] = B[i][l] / T[i][i];
+	      }
+	    }
+	  }
+	}
+	else if( side == 'L' && uplo == 'U' && trans == 'N' ) {
+	  for( i = n - 1; i >= 0; i-- ) {
+	    for( j = i + 1; j < n; j++ ) {
+	      x = T[i][j];
+	      for( l = 0; l < k; l++ ) {
+	        B[i][l] = B[i][l] - x * B[j][l];
+	      }
+	    }
+	    if( diag == 'N' ) {
+	      for( l = 0; l < k; l++ ) {
+	        B[i][l] = B[i][l] / T[i][i];
+	      }
+	    }
+	  }
+	}
+	else if( side == 'L' && uplo == 'U' ) { // transpose( U ) * X = B.
+	  for( j = 0; j < n; j++ ) {
+	    if( diag == 'N' ) {
+	      for( l = 0; l < k; l++ ) {
+	        B[j][l] = B[j][l] / T[j][j];
+	      }
+	    }
+	    for( i = j + 1; i < n; i++ ) {
+	      x = T[j][i];
+	      for( l = 0; l < k; l++ ) {
+	        B[i][l] = B[i][l] - x * B[j][l];
+	      }
+	    }
+	  }
+	}
+	else if( side == 'L' ) { // transpose( L ) * X = B.
+	  for( j = n - 1; j >= 0; j-- ) {
+	    if( diag == 'N' ) {
+	      for( l = 0; l < k; l++ ) {
+	        B[j][l] = B[j][l] / T[j][j];
+	      }
+	    }
+	    for( i = 0; i < j; i++ ) {
+	      x = T[j][i];
+	      for( l = 0; l < k; l++ ) {
+	        B[i][l] = B[i][l] - x * B[j][l];
+	      }
+	    }
+	  }
+	}
+	else if( ( uplo == 'U' ) == ( trans == 'N' ) ) { // op(T) is upper.
+	  for( i = 0; i < n; i++ ) {
+	    for( j = 0; j < k; j++ ) {
+	      if( trans == 'N' ) { // B[i][j] is final once rows l < j are.
+	        if( diag == 'N' ) {
+	          B[i][j] = B[i][j] / T[j][j];
+	        }
+	        x = B[i][j];
+	        for( l = j + 1; l < k; l++ ) {
+	          B[i][l] = B[i][l] - x * T[j][l];
+	        }
+	      }
+	      else {
+	        x = B[i][j];
+	        for( l = 0; l < j; l++ ) {
+	          x = x - B[i][l] * T[j][l];
+	        }
+	        B[i][j] = ( diag == 'N' ) ? x / T[j][j] : x;
+	      }
+	    }
+	  }
+	}
+	else { // op(T) is lower.
+	  for( i = 0; i < n; i++ ) {
+	    for( j = k - 1; j >= 0; j-- ) {
+	      if( trans == 'N' ) {
+	        if( diag == 'N' ) {
+	          B[i][j] = B[i][j] / T[j][j];
+	        }
+	        x = B[i][j];
+	        for( l = 0; l < j; l++ ) {
+	          B[i][l] = B[i][l] - x * T[j][l];
+	        }
+	      }
+	      else {
+	        x = B[i][j];
+	        for( l = j + 1; l < k; l++ ) {
+	          x = x - B[i][l] * T[j][l];
+	        }
+	        B[i][j] = ( diag == 'N' ) ? x / T[j][j] : x;
+	      }
+	    }
+	  }
+	}
+	return;
+}
+/* This function solves the triangular systems op(T) * X = B (side
+   'L', T is n-X-n) or X * op(T) = B (side 'R', T is k-X-k), where B
+   is a n-X-k matrix which is overwritten by X. The flags are:
+   uplo = 'L' or 'U' for a lower or upper triangular T, trans = 'N' or
+   'T' for op(T) = T or transpose( T ), and diag = 'U' if T has an
+   unit diagonal (which is not read) or 'N' otherwise. Only the
+   triangle given by uplo is read. The work is done by blocks of
+   order TRSM_NB, whose off-diagonal updates run in gemm_rmat.
+*/
+int trsm_rmat( char side, char uplo, char trans, char diag, int n, int k,
+               double **T, double **B ) {
+	int    b, bs, flag, forward;
+	double **VT, **VB;
+
+	flag = 0;
+	if( side == 'L' ) {
+	  forward = ( uplo == 'L' ) == ( trans == 'N' );
+
+	  for( b = forward ? 0 : ( ( n - 1 ) / TRSM_NB ) * TRSM_NB;
+	       b >= 0 && b < n; b = forward ? b + TRSM_NB : b - TRSM_NB ) {
+	    bs = ( n - b < TRSM_NB ) ? n - b : TRSM_NB;
+
+	    if( sub_rmat( b, b, bs, T, &VT ) != 0 ) {
+	      return( -1 );
+	    }
+	    trsm_unb( side, uplo, trans, diag, bs, k, VT, B + b );
+	    free_rmat( bs, &VT );
+
+	    if( forward && b + bs < n ) { // B2 = B2 - op(T21) * X1.
+	      flag = flag | gemm_sub_rmat( trans, 'N', n - b - bs, bs, k, -1,
+	             T, ( trans == 'N' ) ? b + bs : b, ( trans == 'N' ) ? b : b + bs,
+	             B, b, 0, 1, B, b + bs, 0 );
+	    }
+	    if( !forward && b > 0 ) { // B1 = B1 - op(T12) * X2.
+	      flag = flag | gemm_sub_rmat( trans, 'N', b, bs, k, -1,
+	             T, ( trans == 'N' ) ? 0 : b, ( trans == 'N' ) ? b : 0,
+	             B, b, 0, 1, B, 0, 0 );
+	    }
+	  }
+	}
+	else {
+	  forward = ( uplo == 'U' ) == ( trans == 'N' );
+
+	  for( b = forward ? 0 : ( ( k - 1 ) / TRSM_NB ) * TRSM_NB;
+	       b >= 0 && b < k; b = forward ? b + TRSM_NB : b - TRSM_NB ) {
+	    bs = ( k - b < TRSM_NB ) ? k - b : TRSM_NB;
+
+	    if( sub_rmat( b, b, bs, T, &VT ) != 0
+	        || sub_rmat( 0, b, n, B, &VB ) != 0 ) {
+	      return( -1 );
+	    }
+	    trsm_unb( side, uplo, trans, diag, n, bs, VT, VB );
+	    free_rmat( bs, &VT );
+	    free_rmat( n, &VB );
+
+	    if( forward && b + bs < k ) { // B2 = B2 - X1 * op(T12).
+	      flag = flag | gemm_sub_rmat( 'N', trans, n, bs, k - b - bs, -1,
+	             B, 0, b, T, ( trans == 'N' ) ? b : b + bs,
+	             ( trans == 'N' ) ? b + bs : b, 1, B, 0, b + bs );
+	    }
+	    if( !forward && b > 0 ) { // B1 = B1 - X2 * op(T21).
+	      flag = flag | gemm_sub_rmat( 'N', trans, n, bs, b, -1,
+	             B, 0, b, T, ( trans == 'N' ) ? b : 0,
+	             ( trans == 'N' ) ? 0 : b, 1, B, 0, 0 );
+	    }
+	  }
+	}
+	return( flag );
+}
+//================================================================
+//	3.8. LU DECOMPOSITION
 //================================================================
 /* This function receives three n-X-n square matrices, A, L and U. L
    and U are lower and upper triangular matrices, respectively, and
    their elements will be calculated to provide L * U = A. To
    simplify the calculations, all the elements of L's main diagonal
-   will be equal to 1.
+   will be equal to 1. No pivoting is done, so A's leading minors must
+   not be zero; cpivot_rmat is the stable, in-place alternative.
 */
 void ludecomp_rmat( int n, double **A, double **L, double **U ) {
 	int i, j, k;
@@ -341,108 +1722,1007 @@ void ludecomp_rmat( int n, double **A, double **L, double **U ) {
 	return;
 }
 //================================================================
-//	3.8. CHOLESKY DECOMPOSITION
+//	3.9. CHOLESKY DECOMPOSITION
 //================================================================
-/* This function receives a n-X-n square matrix U and finds a n-X-n
-   upper triangular matrix U, which fits the relation
-   A = U * transpose( U ), applied in Cholesky decomposition. The
-   following algorithm performs decomposition by column.
-*/
-void choldecomp_rmat( int n, double **A, double **U ) {
-	int i, j, k;
-	double sum;
-
-	// Setting U's first-row elements.
-	U[0][0] = sqrt( A[0][0] ); // A[0][0] must not be zero.
-	for( i = 1; i < n; i++ ) {
-	  U[i][0] = A[i][0] / U[0][0];
-	}
+#define CHOL_NB		64	// Width of the block columns.
 
-	for( j = 1; j < n; j++ ) { // Calculating U.
-	  sum = 0;
+/* Unblocked Cholesky factorization of the lower triangle of the
+   n-X-n matrix A, by rows. It returns -1 if A is not positive
+   definite.
+*/
+static int chol_unb( int n, double **A ) {
+	int    i, j;
+	double d;
 
-	  for( k = 0; k < j; k++ ) {
-	    sum = sum + U[j][k] * U[j][k];
+	for( j = 0; j < n; j++ ) {
+	  d = A[j][j] - dot_rvec( j, A[j], A[j] );
+	  if( !( d > 0 ) ) { // Also true for NaN.
+	    return( -1 );
 	  }
-	  U[j][j] = sqrt( A[j][j] - sum );
+	  A[j][j] = sqrt( d );
 
 	  for( i = j + 1; i < n; i++ ) {
-	    sum = 0;
+	    A[i][j] = ( A[i][j] - dot_rvec( j, A[i], A[j] ) ) / A[j][j];
+	  }
+	}
+	return( 0 );
+}
+/* Lower triangle of the rank-k update A = A - X * transpose( X ) for
+   the nb-X-nb diagonal block of A at (j,j), where X is the nb-X-k
+   block of A at (j,k).
+*/
+static void chol_syrk( int nb, int j, int k, int kb, double **A ) {
+	int i, l;
 
-	    for( k = 0; k < j; k++ ) {
-	      sum = sum + U[i][k] * U[j][k];
-	    }
-	    U[i][j] = ( A[i][j] - sum ) / U[j][j];
+	for( i = j; i < j + nb; i++ ) {
+	  for( l = j; l <= i; l++ ) {
+	    A[i][l] = A[i][l] - dot_rvec( kb, A[i] + k, A[l] + k );
 	  }
 	}
 	return;
 }
+/* Lower triangle of the update A = A - X * transpose( Y ) of the
+   block of A made by rows r0 to r1 - 1 and columns c0 to c1 - 1, where
+   X and Y are the blocks of A made by the same rows and columns,
+   respectively, and by the kb columns starting at k. If the block is
+   on the main diagonal (r0 = c0), its upper triangle is not touched.
+*/
+static void chol_update( int r0, int r1, int c0, int c1, int k, int kb,
+                         double **A ) {
+	int j, jb;
 
-//ON GOING!
-//====================================================================
-//	3.9. TRIANGULAR MATRIX FACTORIZATION WITH COLUMN PIVOT SEARCH
-//====================================================================
-/* This function receives a nonsingular (n,n) matrix A and searchs for
-   an appropriate column pivot and
+	if( r0 != c0 ) {
+	  gemm_sub_rmat( 'N', 'T', r1 - r0, kb, c1 - c0, -1, A, r0, k,
+	                 A, c0, k, 1, A, r0, c0 );
+	  return;
+	}
+	for( j = c0; j < c1; j = j + CHOL_NB ) {
+	  jb = ( c1 - j < CHOL_NB ) ? c1 - j : CHOL_NB;
+
+	  chol_syrk( jb, j, k, kb, A );
+	  gemm_sub_rmat( 'N', 'T', r1 - j - jb, kb, jb, -1, A, j + jb, k,
+	                 A, j, k, 1, A, j + jb, j );
+	}
+	return;
+}
+/* Serial blocked Cholesky factorization (see chol_rmat).
 */
-int cpivot_rmat( int n, double **A, double *P ) {
-	int i, j, k, m;
+static int chol_blocked( int n, double **A ) {
+	int    k, kb, flag;
+	double **L11, **A21;
 
-	for( i = 0; i < n; i++ ) { // Singularity check.
-	  if( A[i][i] == 0 ) {
-	    printf( "Input matrix is numerically singular.\n" );
+	for( k = 0; k < n; k = k + CHOL_NB ) {
+	  kb = ( n - k < CHOL_NB ) ? n - k : CHOL_NB;
+
+	  if( sub_rmat( k, k, kb, A, &L11 ) != 0 ) {
 	    return( -1 );
 	  }
-	}
+	  flag = chol_unb( kb, L11 );
 
-	m = n - 1;
-	for( j = 0; i < m; j++ ) {
-	  for( i = j + 1; i <= m; i++ ) {
-	    A[i][j] = A[i][j]/A[j][j];
-	    for( k = j + 1; k <= m; k++ ) {
-	      A[i][k] = A[i][k] - A[j][k]*A[i][j];
+	  if( flag == 0 && k + kb < n ) { // A21 = A21 * inverse( L11' ).
+	    flag = sub_rmat( k + kb, k, n - k - kb, A, &A21 );
+	    if( flag == 0 ) {
+	      flag = trsm_rmat( 'R', 'L', 'T', 'N', n - k - kb, kb, L11, A21 );
+	      free_rmat( n - k - kb, &A21 );
 	    }
 	  }
+	  free_rmat( kb, &L11 );
+	  if( flag != 0 ) {
+	    return( -1 );
+	  }
+
+	  chol_update( k + kb, n, k + kb, n, k, kb, A ); // A22 = A22 - A21 * A21'.
 	}
-	return(0);
+	return( 0 );
 }
-// ON GOING!
-
-//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//	4. MATRIX DETERMINANTS
-//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//=================================================
-//	4.1. (1,1) MATRIX DETERMINANT
-//=================================================
-/* This function returns the determinant of a 1-X-1 square matrix A.
+/* Tasks of the parallel Cholesky factorization, on square tiles of
+   order nb: kind 0 factorizes the diagonal tile (k,k), kind 1 solves
+   tile (i,k) below it and kind 2 updates tile (i,j) with tiles (i,k)
+   and (j,k). A failed task sets the shared flag, atomically, and the
+   tasks which start later do nothing.
 */
-double det1_rmat( double **A ) {
-	return( A[0][0] );
+typedef struct {
+	int    n, nb, kind, i, j, k;
+	int    *flag;
+	double **A;
+} Chol_task;
+
+static void chol_task( void *arg ) {
+	int       ib, jb, kb;
+	double    **L11, **A21;
+	Chol_task *t = ( Chol_task* ) arg;
+
+	ib = ( t->n - t->i < t->nb ) ? t->n - t->i : t->nb;
+	jb = ( t->n - t->j < t->nb ) ? t->n - t->j : t->nb;
+	kb = ( t->n - t->k < t->nb ) ? t->n - t->k : t->nb;
+	if( __atomic_load_n( t->flag, __ATOMIC_ACQUIRE ) != 0 ) {
+	  return;
+	}
+
+	if( t->kind == 2 ) {
+	  chol_update( t->i, t->i + ib, t->j, t->j + jb, t->k, kb, t->A );
+	  return;
+	}
+	if( sub_rmat( t->k, t->k, kb, t->A, &L11 ) != 0 ) {
+	  __atomic_store_n( t->flag, -1, __ATOMIC_RELEASE );
+	  return;
+	}
+	if( t->kind == 0 ) {
+	  if( chol_blocked( kb, L11 ) != 0 ) {
+	    __atomic_store_n( t->flag, -1, __ATOMIC_RELEASE );
+	  }
+	}
+	else if( sub_rmat( t->i, t->k, ib, t->A, &A21 ) == 0 ) {
+	  if( trsm_rmat( 'R', 'L', 'T', 'N', ib, kb, L11, A21 ) != 0 ) {
+	    __atomic_store_n( t->flag, -1, __ATOMIC_RELEASE );
+	  }
+	  free_rmat( ib, &A21 );
+	}
+	else {
+	  __atomic_store_n( t->flag, -1, __ATOMIC_RELEASE );
+	}
+	free_rmat( kb, &L11 );
+	return;
 }
-//=================================================
-//	4.2. (2,2) MATRIX DETERMINANT
-//=================================================
-/* This function returns the determinant of a 2-X-2 square matrix A.
+/* Parallel version of chol_rmat: each task depends on the last tasks
+   which wrote the tiles it reads or writes, so the factorization of a
+   diagonal tile overlaps the updates of the tiles to its right.
 */
-double det2_rmat( double **A ) {
-	double det;
+static int chol_dag( int n, double **A ) {
+	int       i, j, k, nt, nb, m, flag;
+	Chol_task *t;
+	Task      **last, *T;
+	Tgraph    G;
 
-	det = A[0][0] * A[1][1] - A[0][1] * A[1][0];
-	return( det );
+	nb = CHOL_NB * ( 1 + n / ( CHOL_NB * 40 ) ); // At most about 40 tiles.
+	nt = ( n + nb - 1 ) / nb;
+	m = nt + nt * nt + nt * nt * nt;
+	t = ( Chol_task* ) malloc( m * sizeof( Chol_task ) );
+	last = ( Task** ) calloc( nt * nt, sizeof( Task* ) );
+	if( t == NULL || last == NULL ) {
+	  free( t );
+	  free( last );
+	  return( -1 );
+	}
+
+	new_tgraph( &G );
+	flag = 0;
+	m = 0;
+	for( k = 0; k < nt; k++ ) {
+	  for( i = k; i < nt; i++ ) {
+	    for( j = k; j <= i; j++ ) {
+	      t[m].n = n;
+	      t[m].nb = nb;
+	      t[m].kind = ( i == k ) ? 0 : ( ( j == k ) ? 1 : 2 );
+	      t[m].i = i * nb;
+	      t[m].j = j * nb;
+	      t[m].k = k * nb;
+	      t[m].flag = &flag;
+	      t[m].A = A;
+	      T = add_task( &G, chol_task, &t[m] );
+	      m++;
+	      if( T == NULL ) {
+	        flag = -1;
+	        continue;
+	      }
+
+	      if( last[i * nt + j] != NULL ) { // The tile written.
+	        add_dep( last[i * nt + j], T );
+	      }
+	      if( t[m - 1].kind == 1 ) { // The diagonal tile (k,k).
+	        add_dep( last[k * nt + k], T );
+	      }
+	      if( t[m - 1].kind == 2 ) { // Tiles (i,k) and (j,k).
+	        add_dep( last[i * nt + k], T );
+	        if( j != i ) {
+	          add_dep( last[j * nt + k], T );
+	        }
+	      }
+	      last[i * nt + j] = T;
+	    }
+	  }
+	}
+	if( flag == 0 && run_tgraph( &G ) != 0 ) { // Keeps the flag of the tasks.
+	  flag = -1;
+	}
+	free_tgraph( &G );
+	free( t );
+	free( last );
+	return( flag );
 }
-//=================================================
-//	4.3. (3,3) MATRIX DETERMINANT
-//=================================================
-/* This function returns the determinant of a 3-X-3 square matrix A.
+/* This function receives a n-X-n symmetric positive definite matrix A
+   and overwrites its lower triangle by the lower triangular matrix L
+   such that A = L * transpose( L ). Only the lower triangle of A is
+   read or written, so A may also be in packed storage (see
+   alloc_prmat). The factorization is blocked: for each CHOL_NB-column
+   block, the diagonal block is factorized, the block below it is
+   found by a triangular solve and the trailing lower triangle is
+   updated by GEMM (level-3 operations). When the thread pool runs (see
+   tpool_init), the tiles are tasks of a graph (see chol_dag), and L
+   agrees with the serial one up to rounding errors of the order of
+   n * 1e-16 * |A|. It returns -1 if A is not positive definite or if
+   memory is not available.
 */
-double det3_rmat( double **A ) {
-	double det;
-
-	det = A[0][1] * A[1][2] * A[2][0];
-	det = det - A[0][0] * A[1][2] * A[2][1];
-	det = det + A[0][2] * A[1][0] * A[2][1];
-	det = det - A[0][1] * A[1][0] * A[2][2]; 
-	return( det );
+int chol_rmat( int n, double **A ) {
+	if( tpool_par() && n > 2 * CHOL_NB ) {
+	  return( chol_dag( n, A ) );
+	}
+	return( chol_blocked( n, A ) );
+}
+/* This function solves A * X = B, where A = L * transpose( L ) was
+   factorized by chol_rmat and B is a n-X-k matrix, which is
+   overwritten by X. L may be in packed storage.
+*/
+int cholsolve_rmat( int n, int k, double **L, double **B ) {
+	if( trsm_rmat( 'L', 'L', 'N', 'N', n, k, L, B ) != 0 ) {
+	  return( -1 );
+	}
+	return( trsm_rmat( 'L', 'L', 'T', 'N', n, k, L, B ) );
+}
+/* This function receives a n-X-n square matrix A and finds a n-X-n
+   lower triangular matrix, set into the lower triangle of U, which
+   fits the relation A = U * transpose( U ), applied in Cholesky
+   decomposition. A is not modified, and U's upper triangle is not
+   written. See chol_rmat for the in-place factorization.
+*/
+void choldecomp_rmat( int n, double **A, double **U ) {
+	int i;
+
+	for( i = 0; i < n; i++ ) {
+	  memcpy( U[i], A[i], ( i + 1 ) * sizeof( double ) );
+	}
+	chol_rmat( n, U );
+	return;
+}
+
+//====================================================================
+//	3.10. TRIANGULAR MATRIX FACTORIZATION WITH COLUMN PIVOT SEARCH
+//====================================================================
+#define LU_NB		64	// Width of the panels.
+
+/* The blocked factorization is written once, by LU_TEMPLATE, for the
+   elements of type T: it is made here for 'double', and in section
+   3.12 for 'float'. Its functions are named by L, its trailing
+   updates run in the GEMM named by G, whose products are described by
+   a Tile (see GEMM_TEMPLATE), and Abs is the absolute value of a T.
+
+   - L_swap swaps the columns j0 to j1 - 1 of the rows i and P[i] of
+     A, for i from k0 to k1 - 1, in this order.
+   - L_trsm overwrites the nb-X-w block of A at (i,c) by inverse( L11 )
+     times itself, where L11 is the unit lower triangle at (i,j).
+   - L_sub subtracts from the n-X-p block of A at (ic,jc) the product
+     of its n-X-m block at (ia,ja) and its m-X-p block at (ib,jb). It
+     returns -1 if memory is not available.
+   - L_panel factorizes with partial pivoting the m-X-nc panel of A
+     whose first element is A[0][c0], m >= nc. The panel is split in
+     two halves: the left one is factorized recursively, the right one
+     is updated by a triangular solve and a GEMM, and then it is
+     factorized as well. P[i] gets the row (counted from 0) swapped
+     with row i. It returns the number of zero pivots, where a failed
+     update counts as one.
+   - L_blocked is the serial blocked LU factorization (see
+     cpivot_rmat), which returns the number of zero pivots as well.
+*/
+#define LU_TEMPLATE( T, L, G, Tile, Abs ) \
+static void L##_swap( int k0, int k1, int *P, int j0, int j1, T **A ) { \
+	int i, j; \
+	T   x; \
+\
+	for( i = k0; i < k1; i++ ) { \
+	  if( P[i] != i ) { \
+	    for( j = j0; j < j1; j++ ) { \
+	      x = A[i][j]; \
+	      A[i][j] = A[P[i]][j]; \
+	      A[P[i]][j] = x; \
+	    } \
+	  } \
+	} \
+	return; \
+} \
+\
+static void L##_trsm( int nb, int w, int i, int j, int c, T **A ) { \
+	int r, l, q; \
+	T   a, *x, *y; \
+\
+	for( r = 1; r < nb; r++ ) { \
+	  y = A[i + r] + c; \
+	  for( l = 0; l < r; l++ ) { \
+	    a = A[i + r][j + l]; \
+	    x = A[i + l] + c; \
+	    for( q = 0; q < w; q++ ) { \
+	      y[q] = y[q] - a * x[q]; \
+	    } \
+	  } \
+	} \
+	return; \
+} \
+\
+static int L##_sub( int n, int m, int p, T **A, int ia, int ja, int ib, \
+                    int jb, int ic, int jc ) { \
+	Tile t; \
+\
+	t.ta = t.tb = 'N'; \
+	t.m = m; \
+	t.ia = ia; \
+	t.ja = ja; \
+	t.ib = ib; \
+	t.jb = jb; \
+	t.ic = ic; \
+	t.jc = jc; \
+	t.alpha = -1; \
+	t.A = t.B = t.C = A; \
+	return( G##_run( n, p, &t ) ); \
+} \
+\
+static int L##_panel( int m, int nc, int c0, T **A, int *P ) { \
+	int i, ip, n1, zero; \
+	T   x, amax; \
+\
+	if( nc == 1 ) { \
+	  ip = 0; \
+	  amax = Abs( A[0][c0] ); \
+	  for( i = 1; i < m; i++ ) { /* Pivot search in the column. */ \
+	    if( Abs( A[i][c0] ) > amax ) { \
+	      amax = Abs( A[i][c0] ); \
+	      ip = i; \
+	    } \
+	  } \
+	  P[0] = ip; \
+	  if( amax == 0 ) { \
+	    return( 1 ); \
+	  } \
+\
+	  x = A[0][c0]; \
+	  A[0][c0] = A[ip][c0]; \
+	  A[ip][c0] = x; \
+	  for( i = 1; i < m; i++ ) { \
+	    A[i][c0] = A[i][c0] / A[0][c0]; \
+	  } \
+	  return( 0 ); \
+	} \
+\
+	n1 = nc / 2; \
+	zero = L##_panel( m, n1, c0, A, P ); \
+	L##_swap( 0, n1, P, c0 + n1, c0 + nc, A ); \
+	L##_trsm( n1, nc - n1, 0, c0, c0 + n1, A ); \
+	zero = zero + ( L##_sub( m - n1, n1, nc - n1, A, n1, c0, 0, c0 + n1, \
+	                         n1, c0 + n1 ) != 0 ); \
+\
+	zero = zero + L##_panel( m - n1, nc - n1, c0 + n1, A + n1, P + n1 ); \
+	for( i = n1; i < nc; i++ ) { \
+	  P[i] = P[i] + n1; \
+	} \
+	L##_swap( n1, nc, P, c0, c0 + n1, A ); \
+	return( zero ); \
+} \
+\
+static int L##_blocked( int n, T **A, int *P ) { \
+	int i, k, kb, zero; \
+\
+	zero = 0; \
+	for( k = 0; k < n; k = k + LU_NB ) { \
+	  kb = ( n - k < LU_NB ) ? n - k : LU_NB; \
+\
+	  zero = zero + L##_panel( n - k, kb, k, A + k, P + k ); \
+	  for( i = k; i < k + kb; i++ ) { \
+	    P[i] = P[i] + k; \
+	  } \
+	  L##_swap( k, k + kb, P, 0, k, A ); \
+	  L##_swap( k, k + kb, P, k + kb, n, A ); \
+\
+	  if( k + kb < n ) { \
+	    L##_trsm( kb, n - k - kb, k, k, k + kb, A ); \
+	    zero = zero + ( L##_sub( n - k - kb, kb, n - k - kb, A, k + kb, k, \
+	                             k, k + kb, k + kb, k + kb ) != 0 ); \
+	  } \
+	} \
+	return( zero ); \
+}
+
+LU_TEMPLATE( double, lu, gemm, Gemm_tile, fabs )
+
+/* Tasks of the parallel LU factorization. The matrix is split in
+   block columns of width nb. Task (k,k) factorizes the panel of block
+   column k; task (k,j), j > k, applies the row interchanges of panel k
+   to block column j, solves its triangular system and updates the
+   rest of the block column by GEMM.
+*/
+typedef struct {
+	int    n, nb, k, j, zero;
+	double **A;
+	int    *P;
+} Lu_task;
+
+static void lu_task( void *arg ) {
+	int     i, kb, jb;
+	Lu_task *t = ( Lu_task* ) arg;
+
+	kb = ( t->n - t->k < t->nb ) ? t->n - t->k : t->nb;
+	if( t->j == t->k ) {
+	  t->zero = lu_panel( t->n - t->k, kb, t->k, t->A + t->k, t->P + t->k );
+	  for( i = t->k; i < t->k + kb; i++ ) {
+	    t->P[i] = t->P[i] + t->k;
+	  }
+	  return;
+	}
+
+	jb = ( t->n - t->j < t->nb ) ? t->n - t->j : t->nb;
+	lu_swap( t->k, t->k + kb, t->P, t->j, t->j + jb, t->A );
+	lu_trsm( kb, jb, t->k, t->k, t->j, t->A );
+	t->zero = ( lu_sub( t->n - t->k - kb, kb, jb, t->A, t->k + kb, t->k,
+	                    t->k, t->j, t->k + kb, t->j ) != 0 );
+	return;
+}
+/* Parallel version of cpivot_rmat: the tasks of each step depend on
+   the panel of that step and on the previous update of their block
+   column, so the next panel is factorized while the rest of the
+   trailing matrix is still being updated (look-ahead). It returns the
+   number of zero pivots, where a failed update counts as one, or -1
+   if memory is not available.
+*/
+static int lu_dag( int n, double **A, int *P ) {
+	int     k, j, nt, nb, zero;
+	Lu_task *t;
+	Task    **T;
+	Tgraph  G;
+
+	nb = LU_NB * ( 1 + n / ( LU_NB * 64 ) ); // At most about 64 blocks.
+	nt = ( n + nb - 1 ) / nb;
+	t = ( Lu_task* ) malloc( nt * nt * sizeof( Lu_task ) );
+	T = ( Task** ) calloc( nt * nt, sizeof( Task* ) );
+	if( t == NULL || T == NULL ) {
+	  free( t );
+	  free( T );
+	  return( -1 );
+	}
+
+	new_tgraph( &G );
+	zero = 0;
+	for( k = 0; k < nt; k++ ) {
+	  for( j = k; j < nt; j++ ) {
+	    t[k * nt + j].n = n;
+	    t[k * nt + j].nb = nb;
+	    t[k * nt + j].k = k * nb;
+	    t[k * nt + j].j = j * nb;
+	    t[k * nt + j].zero = 0;
+	    t[k * nt + j].A = A;
+	    t[k * nt + j].P = P;
+	    T[k * nt + j] = add_task( &G, lu_task, &t[k * nt + j] );
+	    if( T[k * nt + j] == NULL ) {
+	      zero = -1;
+	    }
+	    if( j > k && add_dep( T[k * nt + k], T[k * nt + j] ) != 0 ) {
+	      zero = -1;
+	    }
+	    if( k > 0 && add_dep( T[( k - 1 ) * nt + j], T[k * nt + j] ) != 0 ) {
+	      zero = -1;
+	    }
+	  }
+	}
+	if( zero == 0 && run_tgraph( &G ) == 0 ) {
+	  for( k = 0; k < nt; k++ ) { // Interchanges left of each panel.
+	    lu_swap( k * nb, ( k + 1 ) * nb < n ? ( k + 1 ) * nb : n, P, 0, k * nb, A );
+	  }
+	  for( k = 0; k < nt; k++ ) {
+	    for( j = k; j < nt; j++ ) {
+	      zero = zero + t[k * nt + j].zero;
+	    }
+	  }
+	}
+	else {
+	  zero = -1;
+	}
+	free_tgraph( &G );
+	free( t );
+	free( T );
+	return( zero );
+}
+/* This function receives a n-X-n matrix A and factorizes it as
+   P * A = L * U with partial pivoting, i.e., searching the largest
+   pivot down each column. A is overwritten by L (below the main
+   diagonal, whose unit elements are not stored) and U. The row
+   interchanges are set into the pivot vector P: row i was swapped
+   with row P[i] >= i, for i = 0, ..., n - 1, in this order. The
+   factorization is blocked and right-looking: each LU_NB-column panel
+   is factorized and the trailing matrix is then updated by a GEMM,
+   where most of the time is spent. When the thread pool runs (see
+   tpool_init), the block columns are tasks of a graph (see lu_dag);
+   the pivots are the same as in the serial case unless two candidates
+   differ only by rounding, and L and U agree with the serial ones up
+   to rounding errors of the order of n * 1e-16 * |A|. It returns -1
+   if A is singular or if memory is not available.
+*/
+int cpivot_rmat( int n, double **A, int *P ) {
+	int zero;
+
+	if( tpool_par() && n > 2 * LU_NB ) {
+	  zero = lu_dag( n, A, P );
+	}
+	else {
+	  zero = lu_blocked( n, A, P );
+	}
+
+	if( zero > 0 ) {
+	  printf( "Input matrix is numerically singular.\n" );
+	}
+	return( zero == 0 ? 0 : -1 );
+}
+
+//================================================================
+//	3.11. MATRIX-VECTOR PRODUCTS AND TRIANGULAR SYSTEMS
+//================================================================
+/* The routines below work on plain 'double' vectors. A vector x of
+   length n with stride incx has the elements x[0], x[incx], ...,
+   x[( n - 1 ) * incx]; if incx < 0 they are taken backwards, from
+   x[( n - 1 ) * |incx|] to x[0], as in BLAS. Strided vectors are
+   copied into contiguous ones, so the SIMD loops of section 1 do the
+   work.
+*/
+#define GEMV_PAR	262144	// Elements of A above which threads are used.
+#define GEMV_NB		512	// Rows or columns per parallel task.
+
+// The contiguous copy of a strided vector x (x itself if incx = 1).
+static double *vec_get( int n, double *x, int incx ) {
+	int    i;
+	double *v;
+
+	if( incx == 1 ) {
+	  return( x );
+	}
+	v = ( double* ) malloc( ( n > 0 ? n : 1 ) * sizeof( double ) );
+	if( v == NULL ) {
+	  return( NULL );
+	}
+	if( incx < 0 ) {
+	  x = x - ( long ) ( n - 1 ) * incx;
+	}
+	for( i = 0; i < n; i++ ) {
+	  v[i] = x[( long ) i * incx];
+	}
+	return( v );
+}
+// The contiguous copy v of x is written back into x and set free.
+static void vec_put( int n, double *v, double *x, int incx ) {
+	int i;
+
+	if( v == x ) {
+	  return;
+	}
+	if( incx < 0 ) {
+	  x = x - ( long ) ( n - 1 ) * incx;
+	}
+	for( i = 0; i < n; i++ ) {
+	  x[( long ) i * incx] = v[i];
+	}
+	free( v );
+	return;
+}
+// The contiguous copy v of x is set free, and x is not changed.
+static void vec_drop( double *v, double *x ) {
+	if( v != x ) {
+	  free( v );
+	}
+	return;
+}
+
+typedef struct {
+	char   ta;
+	int    n, m;
+	double alpha, beta, **A, *x, *y;
+} Gemv_arg;
+
+// Rows (ta = 'N') or columns (ta = 'T') b * GEMV_NB, ... of y.
+static void gemv_task( int b, void *arg ) {
+	Gemv_arg *a = ( Gemv_arg* ) arg;
+	int      i, i0, i1;
+
+	i0 = b * GEMV_NB;
+	i1 = ( a->ta == 'N' ) ? a->n : a->m;
+	i1 = ( i0 + GEMV_NB < i1 ) ? i0 + GEMV_NB : i1;
+	if( a->ta == 'N' ) {
+	  for( i = i0; i < i1; i++ ) {
+	    a->y[i] = a->alpha * simd.dot( a->m, a->A[i], a->x )
+	              + ( ( a->beta == 0 ) ? 0 : a->beta * a->y[i] );
+	  }
+	  return;
+	}
+	if( a->beta == 0 ) {
+	  memset( a->y + i0, 0, ( i1 - i0 ) * sizeof( double ) );
+	}
+	else if( a->beta != 1 ) {
+	  simd.scale( i1 - i0, a->beta, a->y + i0, a->y + i0 );
+	}
+	for( i = 0; i < a->n; i++ ) {
+	  if( a->x[i] != 0 ) {
+	    simd.axpby( i1 - i0, a->alpha * a->x[i], a->A[i] + i0, 1, a->y + i0 );
+	  }
+	}
+	return;
+}
+
+/* This function sets y = alpha * op(A) * x + beta * y, where A is a
+   n-X-m matrix and op(A) = A (ta = 'N', x has m elements and y has n)
+   or op(A) = transpose( A ) (ta = 'T', x has n elements and y has m).
+   If beta = 0, y need not be set on input. x and y must not overlap.
+   It returns -1 if ta is not valid or if memory is not available.
+*/
+int gemv_rmat( char ta, int n, int m, double alpha, double **A, double *x,
+               int incx, double beta, double *y, int incy ) {
+	int      nb;
+	Gemv_arg a;
+
+	if( ta != 'N' && ta != 'T' ) {
+	  return( -1 );
+	}
+	a.ta = ta;
+	a.n = n;
+	a.m = m;
+	a.alpha = alpha;
+	a.beta = beta;
+	a.A = A;
+	a.x = vec_get( ( ta == 'N' ) ? m : n, x, incx );
+	a.y = vec_get( ( ta == 'N' ) ? n : m, y, incy );
+	if( a.x == NULL || a.y == NULL ) {
+	  vec_drop( a.x, x );
+	  vec_drop( a.y, y );
+	  return( -1 );
+	}
+
+	nb = ( ( ( ta == 'N' ) ? n : m ) + GEMV_NB - 1 ) / GEMV_NB;
+	if( tpool_par() && ( double ) n * m > GEMV_PAR ) {
+	  tpool_for( nb, gemv_task, &a );
+	}
+	else {
+	  for( ; nb > 0; nb-- ) {
+	    gemv_task( nb - 1, &a );
+	  }
+	}
+
+	vec_drop( a.x, x );
+	vec_put( ( ta == 'N' ) ? n : m, a.y, y, incy );
+	return( 0 );
+}
+
+typedef struct {
+	int    n, m;
+	double alpha, **A, *x, *y;
+} Ger_arg;
+
+static void ger_task( int b, void *arg ) {
+	Ger_arg *a = ( Ger_arg* ) arg;
+	int     i, i1;
+
+	i1 = ( ( b + 1 ) * GEMV_NB < a->n ) ? ( b + 1 ) * GEMV_NB : a->n;
+	for( i = b * GEMV_NB; i < i1; i++ ) {
+	  simd.axpby( a->m, a->alpha * a->x[i], a->y, 1, a->A[i] );
+	}
+	return;
+}
+
+/* This function sets A = A + alpha * x * transpose( y ) (a rank-one
+   update), where A is a n-X-m matrix, x has n elements and y has m.
+   It returns -1 if memory is not available.
+*/
+int ger_rmat( int n, int m, double alpha, double *x, int incx, double *y,
+              int incy, double **A ) {
+	int     nb;
+	Ger_arg a;
+
+	a.n = n;
+	a.m = m;
+	a.alpha = alpha;
+	a.A = A;
+	a.x = vec_get( n, x, incx );
+	a.y = vec_get( m, y, incy );
+	if( a.x == NULL || a.y == NULL ) {
+	  vec_drop( a.x, x );
+	  vec_drop( a.y, y );
+	  return( -1 );
+	}
+
+	nb = ( n + GEMV_NB - 1 ) / GEMV_NB;
+	if( tpool_par() && ( double ) n * m > GEMV_PAR ) {
+	  tpool_for( nb, ger_task, &a );
+	}
+	else {
+	  for( ; nb > 0; nb-- ) {
+	    ger_task( nb - 1, &a );
+	  }
+	}
+
+	vec_drop( a.x, x );
+	vec_drop( a.y, y );
+	return( 0 );
+}
+
+/* This function sets y = alpha * A * x + beta * y, where A is a n-X-n
+   symmetric matrix of which only the lower (uplo = 'L') or the upper
+   (uplo = 'U') triangle is read; with uplo = 'L', A may be in packed
+   storage (see alloc_prmat). Each row of the triangle is read once,
+   both as a row and as a column of A. It returns -1 if uplo is not
+   valid or if memory is not available.
+*/
+int symv_rmat( char uplo, int n, double alpha, double **A, double *x,
+               int incx, double beta, double *y, int incy ) {
+	int    i;
+	double *u, *v;
+
+	if( uplo != 'L' && uplo != 'U' ) {
+	  return( -1 );
+	}
+	u = vec_get( n, x, incx );
+	v = vec_get( n, y, incy );
+	if( u == NULL || v == NULL ) {
+	  vec_drop( u, x );
+	  vec_drop( v, y );
+	  return( -1 );
+	}
+
+	if( beta == 0 ) {
+	  memset( v, 0, n * sizeof( double ) );
+	}
+	else if( beta != 1 ) {
+	  simd.scale( n, beta, v, v );
+	}
+	for( i = 0; i < n; i++ ) {
+	  if( uplo == 'L' ) { // Row i holds A(i,0:i) and column i below it.
+	    v[i] = v[i] + alpha * ( simd.dot( i, A[i], u ) + A[i][i] * u[i] );
+	    simd.axpby( i, alpha * u[i], A[i], 1, v );
+	  }
+	  else {
+	    v[i] = v[i] + alpha * ( simd.dot( n - i - 1, A[i] + i + 1, u + i + 1 )
+	           + A[i][i] * u[i] );
+	    simd.axpby( n - i - 1, alpha * u[i], A[i] + i + 1, 1, v + i + 1 );
+	  }
+	}
+
+	vec_drop( u, x );
+	vec_put( n, v, y, incy );
+	return( 0 );
+}
+
+/* This function solves op(T) * x = b for a n-X-n triangular matrix T,
+   and x is set into b. The flags are as in trsm_rmat: uplo = 'L' or
+   'U', trans = 'N' or 'T' and diag = 'U' if T has an implicit unit
+   diagonal ('N' otherwise). Only the triangle of T is read, so a
+   lower T may be in packed storage. It returns -1 if a flag is not
+   valid or if memory is not available.
+*/
+int trsv_rmat( char uplo, char trans, char diag, int n, double **T,
+               double *b, int incb ) {
+	int    i;
+	double *x;
+
+	if( ( uplo != 'L' && uplo != 'U' ) || ( trans != 'N' && trans != 'T' ) ) {
+	  return( -1 );
+	}
+	x = vec_get( n, b, incb );
+	if( x == NULL ) {
+	  return( -1 );
+	}
+
+	if( uplo == 'L' && trans == 'N' ) {
+	  for( i = 0; i < n; i++ ) {
+	    x[i] = x[i] - simd.dot( i, T[i], x );
+	    x[i] = ( diag == 'U' ) ? x[i] : x[i] / T[i][i];
+	  }
+	}
+	else if( uplo == 'U' && trans == 'N' ) {
+	  for( i = n - 1; i >= 0; i-- ) {
+	    x[i] = x[i] - simd.dot( n - i - 1, T[i] + i + 1, x + i + 1 );
+	    x[i] = ( diag == 'U' ) ? x[i] : x[i] / T[i][i];
+	  }
+	}
+	else if( uplo == 'L' ) { // transpose( L ) * x = b, by columns of it.
+	  for( i = n - 1; i >= 0; i-- ) {
+	    x[i] = ( diag == 'U' ) ? x[i] : x[i] / T[i][i];
+	    simd.axpby( i, -x[i], T[i], 1, x );
+	  }
+	}
+	else { // transpose( U ) * x = b.
+	  for( i = 0; i < n; i++ ) {
+	    x[i] = ( diag == 'U' ) ? x[i] : x[i] / T[i][i];
+	    simd.axpby( n - i - 1, -x[i], T[i] + i + 1, 1, x + i + 1 );
+	  }
+	}
+
+	vec_put( n, x, b, incb );
+	return( 0 );
+}
+
+//================================================================
+//	3.12. LU DECOMPOSITION IN SINGLE PRECISION
+//================================================================
+/* The LU factorization below is cpivot_rmat in 'float': it moves half
+   of the bytes of the 'double' one, and its SIMD registers hold twice
+   as many numbers, so it takes about half of the time. It is only
+   meant for the mixed-precision solver of section 5.1 (FACT_MIXED),
+   which recovers the 'double' accuracy by iterative refinement. The
+   matrices are allocated as by alloc_rmat. Only the micro-kernels are
+   written here: the GEMM and the blocked factorization are the ones
+   of sections 3.3 and 3.10, made for 'float' by GEMM_TEMPLATE and
+   LU_TEMPLATE.
+*/
+// Micro-kernel: T (MR-X-NR, row-major) = Ap * Bp over a depth kc.
+typedef void ( *Fgemm_kern )( int kc, const float *Ap, const float *Bp, float *T );
+
+static void fgemm_kern_c( int kc, const float *Ap, const float *Bp, float *T ) {
+	int   k, r, c;
+	float acc[4 * 8] = { 0 };
+
+	for( k = 0; k < kc; k++ ) {
+	  for( r = 0; r < 4; r++ ) {
+	    for( c = 0; c < 8; c++ ) {
+	      acc[r * 8 + c] = acc[r * 8 + c] + Ap[r] * Bp[c];
+	    }
+	  }
+	  Ap = Ap + 4;
+	  Bp = Bp + 8;
+	}
+	memcpy( T, acc, sizeof( acc ) );
+	return;
+}
+
+#ifdef LILA_X86
+__attribute__(( target( "avx2,fma" ) ))
+static void fgemm_kern_avx2( int kc, const float *Ap, const float *Bp, float *T ) {
+	int    k, r;
+	__m256 a, b0, b1, c[12];
+
+	for( r = 0; r < 12; r++ ) {
+	  c[r] = _mm256_setzero_ps();
+	}
+	for( k = 0; k < kc; k++ ) { // 6-X-16 tile in 12 registers.
+	  b0 = _mm256_load_ps( Bp );
+	  b1 = _mm256_load_ps( Bp + 8 );
+	  for( r = 0; r < 6; r++ ) {
+	    a = _mm256_broadcast_ss( Ap + r );
+	    c[2 * r] = _mm256_fmadd_ps( a, b0, c[2 * r] );
+	    c[2 * r + 1] = _mm256_fmadd_ps( a, b1, c[2 * r + 1] );
+	  }
+	  Ap = Ap + 6;
+	  Bp = Bp + 16;
+	}
+	for( r = 0; r < 12; r++ ) {
+	  _mm256_storeu_ps( T + 8 * r, c[r] );
+	}
+	_mm256_zeroupper();
+	return;
+}
+
+__attribute__(( target( "avx512f" ) ))
+static void fgemm_kern_avx512( int kc, const float *Ap, const float *Bp, float *T ) {
+	int    k, r;
+	__m512 a, b0, b1, c[12];
+
+	for( r = 0; r < 12; r++ ) {
+	  c[r] = _mm512_setzero_ps();
+	}
+	for( k = 0; k < kc; k++ ) { // 6-X-32 tile in 12 registers.
+	  b0 = _mm512_load_ps( Bp );
+	  b1 = _mm512_load_ps( Bp + 16 );
+	  for( r = 0; r < 6; r++ ) {
+	    a = _mm512_set1_ps( Ap[r] );
+	    c[2 * r] = _mm512_fmadd_ps( a, b0, c[2 * r] );
+	    c[2 * r + 1] = _mm512_fmadd_ps( a, b1, c[2 * r + 1] );
+	  }
+	  Ap = Ap + 6;
+	  Bp = Bp + 32;
+	}
+	for( r = 0; r < 12; r++ ) {
+	  _mm512_storeu_ps( T + 16 * r, c[r] );
+	}
+	_mm256_zeroupper();
+	return;
+}
+static const Fgemm_kern fgemm_simd[2] = { fgemm_kern_avx2, fgemm_kern_avx512 };
+#else
+static const Fgemm_kern fgemm_simd[2] = { NULL, NULL }; // Never chosen.
+#endif
+
+GEMM_TEMPLATE( float, fgemm, Fgemm_kern, Fgemm_tile )
+LU_TEMPLATE( float, flu, fgemm, Fgemm_tile, fabsf )
+
+/* This function allocates a n-X-n 'float' matrix as alloc_rmat does,
+   in one memory block which is set free by free( *A ).
+*/
+static int alloc_fsq( int n, float ***A ) {
+	int    i;
+	size_t head;
+	char   *block;
+	float  *val;
+
+	head = ( n > 0 ? n : 1 ) * sizeof( float* ) + RMAT_ALIGN;
+	block = ( char* ) malloc( head + ( size_t ) n * n * sizeof( float ) );
+	if( block == NULL ) {
+	  *A = NULL;
+	  return( -1 );
+	}
+	*A = ( float** ) block;
+	val = ( float* ) ( ( ( uintptr_t ) ( block + ( n > 0 ? n : 1 ) * sizeof( float* ) )
+	      + RMAT_ALIGN - 1 ) & ~( uintptr_t ) ( RMAT_ALIGN - 1 ) );
+	for( i = 0; i < n; i++ ) {
+	  ( *A )[i] = val + ( size_t ) i * n;
+	}
+	return( 0 );
+}
+/* cpivot_rmat for a n-X-n 'float' matrix, by flu_blocked. It returns
+   -1 if A is singular in 'float' or if memory is not available.
+*/
+static int flu_fact( int n, float **A, int *P ) {
+	return( flu_blocked( n, A, P ) == 0 ? 0 : -1 );
+}
+// Dot product of two 'float' vectors, in eight partial sums.
+static float flu_dot( int n, const float *x, const float *y ) {
+	int   i, k;
+	float s[8] = { 0 };
+
+	for( i = 0; i + 8 <= n; i = i + 8 ) {
+	  for( k = 0; k < 8; k++ ) {
+	    s[k] = s[k] + x[i + k] * y[i + k];
+	  }
+	}
+	for( ; i < n; i++ ) {
+	  s[0] = s[0] + x[i] * y[i];
+	}
+	return( ( ( s[0] + s[1] ) + ( s[2] + s[3] ) ) + ( ( s[4] + s[5] ) + ( s[6] + s[7] ) ) );
+}
+/* Solves A * x = b in 'float' by the factorization of flu_fact; b is
+   overwritten by x.
+*/
+static void flu_solve( int n, float **A, int *P, float *b ) {
+	int   i;
+	float x;
+
+	for( i = 0; i < n; i++ ) {
+	  x = b[i];
+	  b[i] = b[P[i]];
+	  b[P[i]] = x;
+	}
+	for( i = 0; i < n; i++ ) {
+	  b[i] = b[i] - flu_dot( i, A[i], b );
+	}
+	for( i = n - 1; i >= 0; i-- ) {
+	  b[i] = ( b[i] - flu_dot( n - i - 1, A[i] + i + 1, b + i + 1 ) ) / A[i][i];
+	}
+	return;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	4. MATRIX DETERMINANTS
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//=================================================
+//	4.1. (1,1) MATRIX DETERMINANT
+//=================================================
+/* This function returns the determinant of a 1-X-1 square matrix A.
+*/
+double det1_rmat( double **A ) {
+	return( A[0][0] );
+}
+//=================================================
+//	4.2. (2,2) MATRIX DETERMINANT
+//=================================================
+/* This function returns the determinant of a 2-X-2 square matrix A.
+*/
+double det2_rmat( double **A ) {
+	double det;
+
+	det = A[0][0] * A[1][1] - A[0][1] * A[1][0];
+	return( det );
+}
+//=================================================
+//	4.3. (3,3) MATRIX DETERMINANT
+//=================================================
+/* This function returns the determinant of a 3-X-3 square matrix A.
+*/
+double det3_rmat( double **A ) {
+	double det;
+
+	det = A[0][1] * A[1][2] * A[2][0];
+	det = det - A[0][0] * A[1][2] * A[2][1];
+	det = det + A[0][2] * A[1][0] * A[2][1];
+	det = det - A[0][1] * A[1][0] * A[2][2]; 
+	return( det );
 }
 //========================================================
 //	4.4. DIAGONAL AND TRIANGULAR MATRIX DETERMINANT
@@ -450,94 +2730,1657 @@ double det3_rmat( double **A ) {
 // This function returns the determinant of a n-X-n triangular or diagonal matrix A.
 double ditridet_rmat( int n, double **A ) {
 	int i;
-	double det = A[0][0];
+	double det = A[0][0];
+
+	for( i = 1; i < n; i++ ) {
+	  det = det * A[i][i];
+	}
+	return( det );
+}
+//========================================================
+//	4.5. DETERMINANT CALCULATION BY LU DECOMPOSITION
+//========================================================
+/* This functions uses the LU factorization with partial pivoting to
+   calculate the determinant of a n-X-n square matrix A, which is not
+   modified. The function returns the determinant value.
+*/
+double ludet_rmat( int n, double **A ) {
+	int    i, *P;
+	double det, **W;
+
+	alloc_rmat( n, n, &W );
+	P = ( int* ) malloc( ( n > 0 ? n : 1 ) * sizeof( int ) );
+	for( i = 0; i < n; i++ ) {
+	  memcpy( W[i], A[i], n * sizeof( double ) );
+	}
+
+	det = 0;
+	if( cpivot_rmat( n, W, P ) == 0 ) {
+	  det = ditridet_rmat( n, W ); // det(L) = 1. (^-^)
+
+	  for( i = 0; i < n; i++ ) { // Each row swap changes the sign.
+	    if( P[i] != i ) {
+	      det = -det;
+	    }
+	  }
+	}
+
+	free( P );
+	free_rmat( n, &W );
+	return( det );
+}
+//================================================================
+//	4.6. DETERMINAT CALCULATION BY CHOLESKY DECOMPOSITION
+//================================================================
+/* This functions uses Cholesky decomposition to calculate and return
+   the determinant of a n-X-n symmetric positive definite matrix A.
+   Only A's lower triangle is read, and it is copied to packed storage.
+*/
+double choldet_rmat( int n, double **A ) {
+	int i;
+	double det, **L;
+
+	alloc_prmat( n, &L ); // Lower triangular matrix.
+	for( i = 0; i < n; i++ ) {
+	  memcpy( L[i], A[i], ( i + 1 ) * sizeof( double ) );
+	}
+
+	det = 0;
+	if( chol_rmat( n, L ) == 0 ) {
+	  det = 1;
+	  for( i = 0; i < n; i++ ) {
+	    det = det * L[i][i];
+	  }
+	  // The matrix and its tranpose determinants.
+	  det = det * det;
+	}
+
+	free_rmat( n, &L );
+	return( det );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	5. SYSTEMS OF LINEAR ALGEBRAIC EQUATIONS
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//============================================================
+//	5.1. FACTORIZATION HANDLE (FACTORIZE ONCE, SOLVE MANY)
+//============================================================
+#define FACT_LU		0	// P * A = L * U, A nonsingular.
+#define FACT_CHOL	1	// A = L * transpose( L ), A positive definite.
+#define FACT_PCHOL	2	// FACT_CHOL with L in packed storage.
+#define FACT_MIXED	3	// FACT_LU in 'float', refined in 'double'.
+
+#define MIX_ITERS	30	// Largest number of refinement steps.
+
+/* This struct keeps the factorization of a n-X-n matrix A, so the
+   systems A * X = B can be solved in O(n^2) operations per right-hand
+   side instead of factorizing A again.
+*/
+typedef struct {
+	int    n;	// Order of A.
+	int    kind;	// FACT_LU, FACT_CHOL, FACT_PCHOL or FACT_MIXED.
+	double **F;	// Factors: L and U, or L (lower triangle, maybe packed).
+	int    *P;	// Row interchanges (FACT_LU and FACT_MIXED).
+	float  **S;	// FACT_MIXED: L and U in 'float',
+	double **A;	// A itself (not copied),
+	double anorm;	// and its infinity norm.
+	int    iter;	// FACT_MIXED: refinement steps of the last solve, or -1.
+} Rfact;
+
+/* This function sets free the memory held by a factorization F.
+*/
+int free_rfact( Rfact *F ) {
+	if( F->F != NULL ) {
+	  free_rmat( F->n, &F->F );
+	}
+	free( F->P );
+	free( F->S );
+	F->P = NULL;
+	F->S = NULL;
+	F->n = 0;
+
+	return( 0 );
+}
+/* This function returns the number of bytes held by a factorization F.
+*/
+size_t mem_rfact( Rfact *F ) {
+	size_t bytes;
+
+	bytes = sizeof( Rfact );
+	if( F->F != NULL ) {
+	  bytes = bytes + F->n * sizeof( double* ) + RMAT_ALIGN;
+	  if( F->kind == FACT_PCHOL ) {
+	    bytes = bytes + ( size_t ) F->n * ( F->n + 1 ) / 2 * sizeof( double );
+	  }
+	  else {
+	    bytes = bytes + ( size_t ) F->n * F->n * sizeof( double );
+	  }
+	}
+	if( F->P != NULL ) {
+	  bytes = bytes + F->n * sizeof( int );
+	}
+	if( F->S != NULL ) {
+	  bytes = bytes + F->n * sizeof( float* ) + RMAT_ALIGN
+	          + ( size_t ) F->n * F->n * sizeof( float );
+	}
+	return( bytes );
+}
+/* FACT_MIXED in F: A in 'float', its norm and its factorization by
+   flu_fact. It returns -1 if some element of A does not fit in a
+   'float', if A is singular in 'float' or if memory is not available.
+*/
+static int mix_fact( int n, double **A, Rfact *F ) {
+	int    i, j;
+	double s;
+
+	F->A = A;
+	F->anorm = 0;
+	if( alloc_fsq( n, &F->S ) != 0 ) {
+	  return( -1 );
+	}
+	for( i = 0; i < n; i++ ) {
+	  s = 0;
+	  for( j = 0; j < n; j++ ) {
+	    if( !( fabs( A[i][j] ) <= FLT_MAX ) ) {
+	      return( -1 );
+	    }
+	    s = s + fabs( A[i][j] );
+	    F->S[i][j] = ( float ) A[i][j];
+	  }
+	  F->anorm = ( s > F->anorm ) ? s : F->anorm;
+	}
+	return( flu_fact( n, F->S, F->P ) );
+}
+/* Replaces FACT_MIXED in F by FACT_LU, made in 'double'. It returns -1
+   if A is singular or if memory is not available.
+*/
+static int mix_fallback( Rfact *F ) {
+	int i;
+
+	free( F->S );
+	F->S = NULL;
+	F->kind = FACT_LU;
+	F->iter = -1;
+	if( alloc_rmat( F->n, F->n, &F->F ) != 0 ) {
+	  return( -1 );
+	}
+	for( i = 0; i < F->n; i++ ) {
+	  memcpy( F->F[i], F->A[i], F->n * sizeof( double ) );
+	}
+	return( cpivot_rmat( F->n, F->F, F->P ) );
+}
+/* Solves A * x = b (b is overwritten by x) by FACT_MIXED: x is found
+   in 'float', and then corrected by x = x + d, where the residual r =
+   b - A * x is found in 'double' and A * d = r is solved in 'float',
+   until ||r|| <= ||x|| * ||A|| * eps * sqrt( n ) (infinity norms, eps
+   the 'double' rounding unit) as in LAPACK's dsgesv. It returns 1 if
+   this is not reached within MIX_ITERS steps, and -1 if memory is not
+   available.
+*/
+static int mix_solve( Rfact *F, double *b ) {
+	int    i, k, n, flag;
+	double rn, xn, *x, *r;
+	float  *w;
+
+	n = F->n;
+	x = r = NULL;
+	w = ( float* ) malloc( ( n > 0 ? n : 1 ) * sizeof( float ) );
+	if( w == NULL || alloc_rvec( n > 0 ? n : 1, &x ) != 0
+	    || alloc_rvec( n > 0 ? n : 1, &r ) != 0 ) {
+	  free( w );
+	  free( x );
+	  free( r );
+	  return( -1 );
+	}
+	for( i = 0; i < n; i++ ) {
+	  w[i] = ( float ) b[i];
+	}
+	flu_solve( n, F->S, F->P, w );
+	for( i = 0; i < n; i++ ) {
+	  x[i] = w[i];
+	}
+
+	flag = 1;
+	for( k = 0; k <= MIX_ITERS; k++ ) {
+	  memcpy( r, b, n * sizeof( double ) );
+	  if( gemv_rmat( 'N', n, n, -1, F->A, x, 1, 1, r, 1 ) != 0 ) {
+	    flag = -1;
+	    break;
+	  }
+	  rn = xn = 0;
+	  for( i = 0; i < n; i++ ) {
+	    rn = ( fabs( r[i] ) > rn ) ? fabs( r[i] ) : rn;
+	    xn = ( fabs( x[i] ) > xn ) ? fabs( x[i] ) : xn;
+	  }
+	  if( rn <= xn * F->anorm * ( DBL_EPSILON / 2 ) * sqrt( n ) ) {
+	    flag = 0;
+	    break;
+	  }
+	  if( k == MIX_ITERS || !( rn <= DBL_MAX ) || !( xn <= FLT_MAX ) ) {
+	    break; // Not converging, or overflow.
+	  }
+	  for( i = 0; i < n; i++ ) {
+	    w[i] = ( float ) r[i];
+	  }
+	  flu_solve( n, F->S, F->P, w );
+	  for( i = 0; i < n; i++ ) {
+	    x[i] = x[i] + w[i];
+	  }
+	}
+	F->iter = k;
+	if( flag == 0 ) {
+	  memcpy( b, x, n * sizeof( double ) );
+	}
+	free( w );
+	free( x );
+	free( r );
+	return( flag );
+}
+/* This function factorizes a n-X-n matrix A, which is not modified,
+   into F. The kind of factorization is FACT_LU (LU with partial
+   pivoting, see cpivot_rmat), FACT_CHOL (Cholesky, for symmetric
+   positive definite matrices; only A's lower triangle is read) or
+   FACT_PCHOL (the same, keeping L in packed storage, which takes
+   about half of the memory; see alloc_prmat) or FACT_MIXED. It
+   returns -1 if A is singular (or not positive definite) or if memory
+   is not available. F must be set free by free_rfact in any case.
+
+   FACT_MIXED makes the O(n^3) LU factorization in 'float' (see
+   section 3.12), which takes about half of the time and of the memory
+   traffic of FACT_LU, and each solve then recovers the accuracy of
+   FACT_LU by a few O(n^2) refinement steps in 'double' (see mix_solve).
+   The steps read A, which is not copied, so it must not change while
+   F is used. If A does not fit in 'float' (or is singular in 'float'),
+   or if some solve does not converge (when A is ill-conditioned, about
+   cond( A ) > 1e7), F falls back to FACT_LU made in 'double', and
+   F->iter is -1; otherwise F->iter is the number of steps of the last
+   solve.
+*/
+int fact_rmat( int kind, int n, double **A, Rfact *F ) {
+	int i;
+
+	F->n = n;
+	F->kind = kind;
+	F->F = NULL;
+	F->P = NULL;
+	F->S = NULL;
+	F->A = A;
+	F->iter = 0;
+
+	if( kind == FACT_MIXED ) {
+	  F->P = ( int* ) malloc( ( n > 0 ? n : 1 ) * sizeof( int ) );
+	  if( F->P == NULL ) {
+	    return( -1 );
+	  }
+	  if( mix_fact( n, A, F ) == 0 ) {
+	    return( 0 );
+	  }
+	  return( mix_fallback( F ) );
+	}
+
+	if( kind == FACT_PCHOL ) {
+	  i = alloc_prmat( n, &F->F );
+	}
+	else {
+	  i = alloc_rmat( n, n, &F->F );
+	}
+	if( i != 0 ) {
+	  return( -1 );
+	}
+
+	if( kind == FACT_LU ) {
+	  F->P = ( int* ) malloc( ( n > 0 ? n : 1 ) * sizeof( int ) );
+	  if( F->P == NULL ) {
+	    return( -1 );
+	  }
+	  for( i = 0; i < n; i++ ) {
+	    memcpy( F->F[i], A[i], n * sizeof( double ) );
+	  }
+	  return( cpivot_rmat( n, F->F, F->P ) );
+	}
+
+	for( i = 0; i < n; i++ ) {
+	  memcpy( F->F[i], A[i], ( i + 1 ) * sizeof( double ) );
+	}
+	return( chol_rmat( n, F->F ) );
+}
+/* This function solves A * x = b for a single n-dimensional vector b,
+   which is overwritten by x, using the factorization F of A.
+*/
+int vsolve_rfact( Rfact *F, double *b ) {
+	int    i, n, flag;
+	double x;
+
+	n = F->n;
+	if( F->kind == FACT_MIXED ) {
+	  flag = mix_solve( F, b );
+	  if( flag <= 0 ) {
+	    return( flag );
+	  }
+	  if( mix_fallback( F ) != 0 ) {
+	    return( -1 );
+	  }
+	}
+	if( F->kind == FACT_LU ) {
+	  for( i = 0; i < n; i++ ) { // b = P * b.
+	    x = b[i];
+	    b[i] = b[F->P[i]];
+	    b[F->P[i]] = x;
+	  }
+	  trsv_rmat( 'L', 'N', 'U', n, F->F, b, 1 );
+	  return( trsv_rmat( 'U', 'N', 'N', n, F->F, b, 1 ) );
+	}
+
+	trsv_rmat( 'L', 'N', 'N', n, F->F, b, 1 );
+	return( trsv_rmat( 'L', 'T', 'N', n, F->F, b, 1 ) );
+}
+/* This function solves A * X = B for a n-X-k matrix B, which is
+   overwritten by X, using the factorization F of A. Its cost is
+   O(n^2 * k), and the triangular solves run by blocks (trsm_rmat).
+*/
+int solve_rfact( Rfact *F, int k, double **B ) {
+	int    i, j, n;
+	double x, *b;
+
+	n = F->n;
+	if( F->kind == FACT_MIXED ) { // Column by column.
+	  if( alloc_rvec( n > 0 ? n : 1, &b ) != 0 ) {
+	    return( -1 );
+	  }
+	  for( j = 0; j < k; j++ ) {
+	    for( i = 0; i < n; i++ ) {
+	      b[i] = B[i][j];
+	    }
+	    if( vsolve_rfact( F, b ) != 0 ) {
+	      free( b );
+	      return( -1 );
+	    }
+	    for( i = 0; i < n; i++ ) {
+	      B[i][j] = b[i];
+	    }
+	  }
+	  free( b );
+	  return( 0 );
+	}
+	if( F->kind == FACT_LU ) {
+	  for( i = 0; i < n; i++ ) { // B = P * B.
+	    if( F->P[i] != i ) {
+	      for( j = 0; j < k; j++ ) {
+	        x = B[i][j];
+	        B[i][j] = B[F->P[i]][j];
+	        B[F->P[i]][j] = x;
+	      }
+	    }
+	  }
+	  if( trsm_rmat( 'L', 'L', 'N', 'U', n, k, F->F, B ) != 0 ) {
+	    return( -1 );
+	  }
+	  return( trsm_rmat( 'L', 'U', 'N', 'N', n, k, F->F, B ) );
+	}
+
+	return( cholsolve_rmat( n, k, F->F, B ) );
+}
+//============================================================
+//	5.2. SOLVING OF A LINEAR SYSTEM BY LU DECOMPOSITION
+//============================================================
+/* This function employs LU decomposition with partial pivoting to
+   solve a linear system A * x = b, which A is a n-X-n square matrix,
+   b is a n-dimensional vector and x is the solution of the system.
+   A and b are not modified. To solve many systems with the same A,
+   see fact_rmat above. It returns -1 if A is singular or if memory is
+   not available.
+*/
+int lusolve_rvec( int n, double **A, double *x, double *b ) {
+	int   flag;
+	Rfact F;
+
+	flag = fact_rmat( FACT_LU, n, A, &F );
+	if( flag == 0 ) {
+	  memcpy( x, b, n * sizeof( double ) );
+	  flag = vsolve_rfact( &F, x );
+	}
+
+	free_rfact( &F );
+	return( flag );
+}
+/* This function is lusolve_rvec for b and X given as n-X-1 slender
+   matrices.
+*/
+void lusolve_rmat( int n, double **A, double **X, double **B ) {
+	int   i;
+	Rfact F;
+
+	if( fact_rmat( FACT_LU, n, A, &F ) != 0 ) {
+	  free_rfact( &F );
+	  return;
+	}
+	for( i = 0; i < n; i++ ) {
+	  X[i][0] = B[i][0];
+	}
+	solve_rfact( &F, 1, X );
+
+	free_rfact( &F );
+	return;
+}
+//============================================================
+//	5.3. BANDED AND TRIDIAGONAL SYSTEMS
+//============================================================
+/* A n-X-n band matrix with kl subdiagonals and ku superdiagonals is
+   kept by rows in a Bmat: row i holds the columns i - kl, ..., i + kl
+   + ku, so each row takes 2 * kl + ku + 1 numbers, whatever n is. The
+   kl columns past the band are zero, and make room for the fill of
+   the row interchanges of the LU factorization, which then takes
+   O(n * kl * ( kl + ku )) operations instead of O(n^3), and each
+   solve O(n * ( 2 * kl + ku )). Each row update is a SIMD axpby over
+   a contiguous part of a row.
+*/
+typedef struct {
+	int    n;		// Order.
+	int    kl, ku;		// Number of sub- and superdiagonals.
+	int    ld;		// Elements per row: 2 * kl + ku + 1.
+	double *val;		// Element (i,j) is val[i * ld + kl + j - i].
+	int    *P;		// Row interchanges of lu_bmat (or NULL).
+} Bmat;
+
+// The address of element (i,j) of a band matrix A.
+#define BMAT( A, i, j )	( ( A )->val[( size_t ) ( i ) * ( A )->ld + ( A )->kl + ( j ) - ( i )] )
+
+/* This function allocates a n-X-n band matrix A with kl subdiagonals
+   and ku superdiagonals, whose elements are all zero. Element (i,j),
+   |j - i| in the band, is BMAT( A, i, j ). It returns -1 if n, kl or
+   ku is negative (nothing is allocated then) or if memory is not
+   available.
+*/
+int alloc_bmat( int n, int kl, int ku, Bmat *A ) {
+	A->n = n;
+	A->kl = kl;
+	A->ku = ku;
+	A->ld = 2 * kl + ku + 1;
+	A->P = NULL;
+	A->val = NULL;
+	if( n < 0 || kl < 0 || ku < 0 ) {
+	  return( -1 );
+	}
+	A->val = ( double* ) calloc( ( n > 0 ? ( size_t ) n * A->ld : 1 ), sizeof( double ) );
+
+	return( ( A->val == NULL ) ? -1 : 0 );
+}
+/* This function sets free a band matrix A.
+*/
+int free_bmat( Bmat *A ) {
+	free( A->val );
+	free( A->P );
+	A->val = NULL;
+	A->P = NULL;
+	A->n = 0;
+
+	return( 0 );
+}
+/* This function sets into a new band matrix B (see alloc_bmat) the
+   band of kl subdiagonals and ku superdiagonals of a n-X-n matrix A.
+   It returns -1 if memory is not available.
+*/
+int dense_bmat( int n, int kl, int ku, double **A, Bmat *B ) {
+	int i, j;
+
+	if( alloc_bmat( n, kl, ku, B ) != 0 ) {
+	  return( -1 );
+	}
+	for( i = 0; i < n; i++ ) {
+	  for( j = ( i > kl ? i - kl : 0 ); j <= i + ku && j < n; j++ ) {
+	    BMAT( B, i, j ) = A[i][j];
+	  }
+	}
+	return( 0 );
+}
+/* This function factorizes a band matrix A, in place, as P * A = L *
+   U with partial pivoting: U, which has kl + ku superdiagonals, takes
+   the upper part of A, and the multipliers of L the kl subdiagonals.
+   The row interchanges are kept in A->P: row k was swapped with row
+   P[k] >= k, for k = 0, ..., n - 1, in this order, as in cpivot_rmat.
+   It returns -1 if A is singular or if memory is not available.
+*/
+int lu_bmat( Bmat *A ) {
+	int    n, k, i, p, j, im, ju;
+	double t;
+
+	n = A->n;
+	free( A->P );
+	A->P = ( int* ) malloc( ( n > 0 ? n : 1 ) * sizeof( int ) );
+	if( A->P == NULL ) {
+	  return( -1 );
+	}
+	ju = 0; // Last column of U reached so far.
+	for( k = 0; k < n; k++ ) {
+	  im = ( k + A->kl < n - 1 ) ? k + A->kl : n - 1;
+	  p = k;
+	  for( i = k + 1; i <= im; i++ ) {
+	    p = ( fabs( BMAT( A, i, k ) ) > fabs( BMAT( A, p, k ) ) ) ? i : p;
+	  }
+	  A->P[k] = p;
+	  if( BMAT( A, p, k ) == 0 ) {
+	    return( -1 );
+	  }
+	  j = ( p + A->ku < n - 1 ) ? p + A->ku : n - 1;
+	  ju = ( j > ju ) ? j : ju;
+	  if( p != k ) {
+	    for( j = k; j <= ju; j++ ) {
+	      t = BMAT( A, k, j );
+	      BMAT( A, k, j ) = BMAT( A, p, j );
+	      BMAT( A, p, j ) = t;
+	    }
+	  }
+	  for( i = k + 1; i <= im; i++ ) {
+	    BMAT( A, i, k ) = BMAT( A, i, k ) / BMAT( A, k, k );
+	    simd.axpby( ju - k, -BMAT( A, i, k ), &BMAT( A, k, k + 1 ), 1,
+	                &BMAT( A, i, k + 1 ) );
+	  }
+	}
+	return( 0 );
+}
+/* This function solves A * X = B for a n-X-k matrix B, which is
+   overwritten by X, using the factorization of the band matrix A made
+   by lu_bmat.
+*/
+int solve_bmat( Bmat *A, int k, double **B ) {
+	int    i, j, jm, n;
+	double x;
+
+	n = A->n;
+	if( A->P == NULL ) {
+	  return( -1 );
+	}
+	for( j = 0; j < n; j++ ) { // L * Y = P * B.
+	  if( A->P[j] != j ) {
+	    for( i = 0; i < k; i++ ) {
+	      x = B[j][i];
+	      B[j][i] = B[A->P[j]][i];
+	      B[A->P[j]][i] = x;
+	    }
+	  }
+	  jm = ( j + A->kl < n - 1 ) ? j + A->kl : n - 1;
+	  for( i = j + 1; i <= jm; i++ ) {
+	    simd.axpby( k, -BMAT( A, i, j ), B[j], 1, B[i] );
+	  }
+	}
+	for( i = n - 1; i >= 0; i-- ) { // U * X = Y.
+	  jm = ( i + A->kl + A->ku < n - 1 ) ? i + A->kl + A->ku : n - 1;
+	  for( j = i + 1; j <= jm; j++ ) {
+	    simd.axpby( k, -BMAT( A, i, j ), B[j], 1, B[i] );
+	  }
+	  simd.scale( k, 1 / BMAT( A, i, i ), B[i], B[i] );
+	}
+	return( 0 );
+}
+/* This function solves A * x = b for a single n-dimensional vector b,
+   which is overwritten by x, using the factorization of the band
+   matrix A made by lu_bmat. The rows of U are read as dot products.
+*/
+int vsolve_bmat( Bmat *A, double *b ) {
+	int    i, j, jm, n;
+	double x;
+
+	n = A->n;
+	if( A->P == NULL ) {
+	  return( -1 );
+	}
+	for( j = 0; j < n; j++ ) {
+	  x = b[j];
+	  b[j] = b[A->P[j]];
+	  b[A->P[j]] = x;
+	  jm = ( j + A->kl < n - 1 ) ? j + A->kl : n - 1;
+	  for( i = j + 1; i <= jm; i++ ) {
+	    b[i] = b[i] - BMAT( A, i, j ) * b[j];
+	  }
+	}
+	for( i = n - 1; i >= 0; i-- ) {
+	  jm = ( i + A->kl + A->ku < n - 1 ) ? i + A->kl + A->ku : n - 1;
+	  b[i] = ( b[i] - simd.dot( jm - i, &BMAT( A, i, i + 1 ), b + i + 1 ) )
+	         / BMAT( A, i, i );
+	}
+	return( 0 );
+}
+
+/* A tridiagonal system, with subdiagonal a (a[0] is not used),
+   diagonal b and superdiagonal c (c[n - 1] is not used), is solved by
+   the Thomas algorithm: Gaussian elimination with no pivoting, in
+   O(n) operations, which is stable when A is diagonally dominant or
+   symmetric positive definite (e.g. 1-D diffusion and spline
+   systems). An alternating direction (ADI) sweep solves many such
+   systems of the same order at once, one per grid line; tri_batch
+   keeps them interleaved, element i of system s at [i * ns + s], so
+   the same step of the elimination runs on 4 (AVX2) or 8 (AVX-512)
+   systems together, one per SIMD lane, and the blocks of TRI_LANES
+   systems are shared among the threads of the pool.
+*/
+#define TRI_LANES	256	// Systems per parallel task.
+
+typedef void Tri_kern( int n, int ns, int w, const double *a, const double *b,
+                       const double *c, double *d, double *cp );
+
+// Systems 0, ..., w - 1 of the interleaved arrays (stride ns); cp
+// keeps the modified superdiagonal.
+static void tri_c( int n, int ns, int w, const double *a, const double *b,
+                   const double *c, double *d, double *cp ) {
+	int    i, s;
+	size_t k;
+	double den;
+
+	for( s = 0; s < w; s++ ) {
+	  cp[s] = c[s] / b[s];
+	  d[s] = d[s] / b[s];
+	  for( i = 1, k = ns + s; i < n; i++, k = k + ns ) {
+	    den = b[k] - a[k] * cp[k - ns];
+	    cp[k] = c[k] / den;
+	    d[k] = ( d[k] - a[k] * d[k - ns] ) / den;
+	  }
+	  for( i = n - 2, k = ( size_t ) i * ns + s; i >= 0; i--, k = k - ns ) {
+	    d[k] = d[k] - cp[k] * d[k + ns];
+	  }
+	}
+	return;
+}
+
+#ifdef LILA_X86
+__attribute__(( target( "avx2,fma" ) ))
+static void tri_avx2( int n, int ns, int w, const double *a, const double *b,
+                      const double *c, double *d, double *cp ) {
+	int     i, s;
+	size_t  k;
+	__m256d den, cq, dq;
+
+	for( s = 0; s + 4 <= w; s = s + 4 ) {
+	  den = _mm256_loadu_pd( b + s );
+	  cq = _mm256_div_pd( _mm256_loadu_pd( c + s ), den );
+	  dq = _mm256_div_pd( _mm256_loadu_pd( d + s ), den );
+	  _mm256_storeu_pd( cp + s, cq );
+	  _mm256_storeu_pd( d + s, dq );
+	  for( i = 1, k = ns + s; i < n; i++, k = k + ns ) {
+	    den = _mm256_fnmadd_pd( _mm256_loadu_pd( a + k ), cq, _mm256_loadu_pd( b + k ) );
+	    cq = _mm256_div_pd( _mm256_loadu_pd( c + k ), den );
+	    dq = _mm256_div_pd( _mm256_fnmadd_pd( _mm256_loadu_pd( a + k ), dq,
+	                        _mm256_loadu_pd( d + k ) ), den );
+	    _mm256_storeu_pd( cp + k, cq );
+	    _mm256_storeu_pd( d + k, dq );
+	  }
+	  for( i = n - 2, k = ( size_t ) i * ns + s; i >= 0; i--, k = k - ns ) {
+	    dq = _mm256_fnmadd_pd( _mm256_loadu_pd( cp + k ), dq, _mm256_loadu_pd( d + k ) );
+	    _mm256_storeu_pd( d + k, dq );
+	  }
+	}
+	_mm256_zeroupper();
+	tri_c( n, ns, w - s, a + s, b + s, c + s, d + s, cp + s );
+	return;
+}
+
+__attribute__(( target( "avx512f" ) ))
+static void tri_avx512( int n, int ns, int w, const double *a, const double *b,
+                        const double *c, double *d, double *cp ) {
+	int     i, s;
+	size_t  k;
+	__m512d den, cq, dq;
+
+	for( s = 0; s + 8 <= w; s = s + 8 ) {
+	  den = _mm512_loadu_pd( b + s );
+	  cq = _mm512_div_pd( _mm512_loadu_pd( c + s ), den );
+	  dq = _mm512_div_pd( _mm512_loadu_pd( d + s ), den );
+	  _mm512_storeu_pd( cp + s, cq );
+	  _mm512_storeu_pd( d + s, dq );
+	  for( i = 1, k = ns + s; i < n; i++, k = k + ns ) {
+	    den = _mm512_fnmadd_pd( _mm512_loadu_pd( a + k ), cq, _mm512_loadu_pd( b + k ) );
+	    cq = _mm512_div_pd( _mm512_loadu_pd( c + k ), den );
+	    dq = _mm512_div_pd( _mm512_fnmadd_pd( _mm512_loadu_pd( a + k ), dq,
+	                        _mm512_loadu_pd( d + k ) ), den );
+	    _mm512_storeu_pd( cp + k, cq );
+	    _mm512_storeu_pd( d + k, dq );
+	  }
+	  for( i = n - 2, k = ( size_t ) i * ns + s; i >= 0; i--, k = k - ns ) {
+	    dq = _mm512_fnmadd_pd( _mm512_loadu_pd( cp + k ), dq, _mm512_loadu_pd( d + k ) );
+	    _mm512_storeu_pd( d + k, dq );
+	  }
+	}
+	_mm256_zeroupper();
+	tri_c( n, ns, w - s, a + s, b + s, c + s, d + s, cp + s );
+	return;
+}
+#endif
+
+typedef struct {
+	int      n, ns;
+	double   *a, *b, *c, *d, *cp;
+	Tri_kern *kern;
+} Tri_arg;
+
+static void tri_task( int t, void *arg ) {
+	Tri_arg *a = ( Tri_arg* ) arg;
+	int     s, w;
+
+	s = t * TRI_LANES;
+	w = ( a->ns - s < TRI_LANES ) ? a->ns - s : TRI_LANES;
+	a->kern( a->n, a->ns, w, a->a + s, a->b + s, a->c + s, a->d + s, a->cp + s );
+	return;
+}
+
+/* This function solves the n-X-n tridiagonal system with subdiagonal
+   a, diagonal b and superdiagonal c (see above), with no pivoting;
+   d has the right-hand side, and it is overwritten by x. a, b and c
+   are not modified. It returns -1 if some pivot is zero or if memory
+   is not available.
+*/
+int tri_rvec( int n, double *a, double *b, double *c, double *d ) {
+	int    i;
+	double den, *cp;
+
+	if( n < 1 ) {
+	  return( 0 );
+	}
+	if( alloc_rvec( n, &cp ) != 0 ) {
+	  return( -1 );
+	}
+	for( i = 0; i < n; i++ ) {
+	  den = ( i == 0 ) ? b[0] : b[i] - a[i] * cp[i - 1];
+	  if( den == 0 ) {
+	    free_rvec( &cp );
+	    return( -1 );
+	  }
+	  cp[i] = c[i] / den;
+	  d[i] = ( i == 0 ) ? d[0] / den : ( d[i] - a[i] * d[i - 1] ) / den;
+	}
+	for( i = n - 2; i >= 0; i-- ) {
+	  d[i] = d[i] - cp[i] * d[i + 1];
+	}
+	free_rvec( &cp );
+	return( 0 );
+}
+/* This function solves ns independent n-X-n tridiagonal systems,
+   interleaved: a[i * ns + s], b[i * ns + s] and c[i * ns + s] are the
+   elements of row i of system s, and d[i * ns + s] its right-hand side,
+   which is overwritten by the solution. a, b and c are not modified.
+   There is no pivoting and no check of zero pivots (which give inf or
+   nan in the solution of that system alone). It returns -1 if memory
+   is not available.
+*/
+int tri_batch( int n, int ns, double *a, double *b, double *c, double *d ) {
+	Tri_arg t;
+
+	if( n < 1 || ns < 1 ) {
+	  return( 0 );
+	}
+	t.cp = ( double* ) malloc( ( size_t ) n * ns * sizeof( double ) );
+	if( t.cp == NULL ) {
+	  return( -1 );
+	}
+	t.n = n;
+	t.ns = ns;
+	t.a = a;
+	t.b = b;
+	t.c = c;
+	t.d = d;
+	t.kern = tri_c;
+#ifdef LILA_X86
+	if( simd.level == SIMD_AVX512 ) {
+	  t.kern = tri_avx512;
+	}
+	if( simd.level == SIMD_AVX2 ) {
+	  t.kern = tri_avx2;
+	}
+#endif
+	tpool_for( ( ns + TRI_LANES - 1 ) / TRI_LANES, tri_task, &t );
+
+	free( t.cp );
+	return( 0 );
+}
+//============================================================
+//	5.4. QR FACTORIZATION AND LEAST SQUARES
+//============================================================
+/* A m-X-n matrix A is factorized as A * P = Q * R, where Q is a m-X-m
+   orthogonal matrix, R is a m-X-n upper triangle and P is a column
+   permutation (or the identity). Q = H(0) * H(1) * ... * H(k - 1), k
+   = min( m, n ), is kept as k Householder reflections H(j) = I - tau[j]
+   * v * transpose( v ), with v[i] = 0 for i < j, v[j] = 1 and v[i],
+   i > j, in A[i][j]; R overwrites the upper triangle of A. Since
+   transpose( Q ) * A * P = R, the condition number is that of A, not
+   its square as in the normal equations.
+
+   A block of nb reflections is I - V * T * transpose( V ), with V the
+   m-X-nb matrix of the vectors v and T a nb-X-nb upper triangle (the
+   compact WY form), so it is applied to the rest of the matrix by
+   three calls to gemm_rmat. As A is kept by rows, a panel of nb
+   columns is first copied into a nb-X-m buffer where each column is a
+   contiguous row, which is factorized recursively, also by GEMMs.
+*/
+#define QR_NB		64	// Width of the panels.
+#define QR_LEAF		16	// Width below which a panel is not split.
+
+typedef struct {
+	double **V;	// QR_NB-X-m panel, transposed.
+	double **T;	// QR_NB-X-QR_NB block factor.
+	double **W, **Y;	// QR_NB-X-nc work matrices.
+	double *S;	// QR_NB * QR_NB saved elements of V.
+} Qr_work;
+
+static void qr_free( Qr_work *K ) {
+	free_rmat( QR_NB, &K->V );
+	free_rmat( QR_NB, &K->T );
+	free_rmat( QR_NB, &K->W );
+	free_rmat( QR_NB, &K->Y );
+	free_rvec( &K->S );
+	return;
+}
+static int qr_alloc( int m, int nc, Qr_work *K ) {
+	int flag;
+
+	nc = ( nc > QR_NB ) ? nc : QR_NB;
+	K->V = NULL;
+	K->T = NULL;
+	K->W = NULL;
+	K->Y = NULL;
+	K->S = NULL;
+	flag = alloc_rmat( QR_NB, m, &K->V );
+	flag = flag | alloc_rmat( QR_NB, QR_NB, &K->T );
+	flag = flag | alloc_rmat( QR_NB, nc, &K->W );
+	flag = flag | alloc_rmat( QR_NB, nc, &K->Y );
+	flag = flag | alloc_rvec( QR_NB * QR_NB, &K->S );
+	if( flag != 0 ) {
+	  qr_free( K );
+	  return( -1 );
+	}
+	return( 0 );
+}
+/* Householder reflection of the n-dimensional vector x: it gives tau
+   and v, v[0] = 1, such that ( I - tau * v * transpose( v ) ) * x =
+   ( beta, 0, ..., 0 ). beta overwrites x[0] and v[i] overwrites x[i],
+   i > 0. It returns tau, which is 0 if x[1] = ... = x[n - 1] = 0.
+*/
+static double qr_house( int n, double *x ) {
+	double alpha, beta, xnorm;
+
+	if( n < 2 ) {
+	  return( 0 );
+	}
+	xnorm = nrm2_rvec( n - 1, x + 1 );
+	if( xnorm == 0 ) {
+	  return( 0 );
+	}
+	alpha = x[0];
+	beta = -copysign( hypot( alpha, xnorm ), alpha );
+	scal_rvec( n - 1, 1 / ( alpha - beta ), x + 1 );
+	x[0] = beta;
+	return( ( beta - alpha ) / beta );
+}
+/* The rows r to r + nb - 1 of the transposed panel V, from column r,
+   hold R above the diagonal. If save = 1, the nb-X-nb block at (r,r)
+   is copied into S (unless S is NULL) and its upper triangle is set
+   to the ones and zeros of the vectors v; if save = 0, it is copied
+   back from S.
+*/
+static void qr_unit( int nb, int r, double **V, double *S, int save ) {
+	int c, q;
+
+	for( c = 0; c < nb; c++ ) {
+	  for( q = 0; q <= c; q++ ) {
+	    if( save == 0 ) {
+	      V[r + c][r + q] = S[c * nb + q];
+	      continue;
+	    }
+	    if( S != NULL ) {
+	      S[c * nb + q] = V[r + c][r + q];
+	    }
+	    V[r + c][r + q] = ( q == c ) ? 1 : 0;
+	  }
+	}
+	return;
+}
+/* Sets the nb-X-nb upper triangle T of the block of reflections whose
+   vectors are the rows r to r + nb - 1 of V, from column r to r + n -
+   1, with their ones and zeros (see qr_unit). The Gram matrix of the
+   vectors is computed by GEMM, and then T(0:j,j) = -tau[j] * T(0:j,0:j)
+   * G(0:j,j), column after column, in place.
+*/
+static int qr_larft( int nb, int n, int r, double **V, double *tau,
+                     double **T ) {
+	int    i, j, l;
+	double sum;
+
+	if( gemm_sub_rmat( 'N', 'T', nb, n, nb, 1, V, r, r, V, r, r, 0,
+	                   T, 0, 0 ) != 0 ) {
+	  return( -1 );
+	}
+	for( j = 0; j < nb; j++ ) {
+	  for( i = 0; i < j; i++ ) {
+	    sum = 0;
+	    for( l = i; l < j; l++ ) {
+	      sum = sum + T[i][l] * T[l][j];
+	    }
+	    T[i][j] = -tau[j] * sum;
+	  }
+	  T[j][j] = tau[j];
+	  for( i = j + 1; i < nb; i++ ) {
+	    T[i][j] = 0;
+	  }
+	}
+	return( 0 );
+}
+/* Applies the block of nb reflections whose vectors are the rows 0
+   to nb - 1 of K->V (n columns, with their ones and zeros) and whose
+   factor is K->T to the n-X-nc block of C at (ic,jc), from the left:
+   C = C - V * op(T) * transpose( V ) * C, where op(T) = T (trans =
+   'N', the block is applied) or transpose( T ) (trans = 'T', its
+   transpose is applied).
+*/
+static int qr_larfb( char trans, int nb, int n, Qr_work *K, int nc,
+                     double **C, int ic, int jc ) {
+	int flag;
+
+	flag = gemm_sub_rmat( 'N', 'N', nb, n, nc, 1, K->V, 0, 0, C, ic, jc,
+	                      0, K->W, 0, 0 );
+	flag = flag | gemm_rmat( trans, 'N', nb, nb, nc, 1, K->T, K->W, 0,
+	                         K->Y );
+	flag = flag | gemm_sub_rmat( 'T', 'N', n, nb, nc, -1, K->V, 0, 0,
+	                             K->Y, 0, 0, 1, C, ic, jc );
+	return( flag );
+}
+/* Factorizes the columns c to c + w - 1 of the transposed panel V (n
+   elements per row), which are already updated by the reflections
+   before c. The left half is factorized recursively, its block of
+   reflections is applied to the right half by GEMMs, and then the
+   right half is factorized.
+*/
+static int qr_panel( int n, int c, int w, double **V, double *tau,
+                     Qr_work *K ) {
+	int    j, r, w1, w2, flag;
+	double beta, d;
+
+	if( w <= QR_LEAF ) { // One column after another.
+	  for( j = c; j < c + w; j++ ) {
+	    tau[j] = qr_house( n - j, V[j] + j );
+	    beta = V[j][j];
+	    V[j][j] = 1;
+	    for( r = j + 1; r < c + w && tau[j] != 0; r++ ) {
+	      d = tau[j] * simd.dot( n - j, V[j] + j, V[r] + j );
+	      simd.axpby( n - j, -d, V[j] + j, 1, V[r] + j );
+	    }
+	    V[j][j] = beta;
+	  }
+	  return( 0 );
+	}
+	w1 = w / 2;
+	w2 = w - w1;
+	flag = qr_panel( n, c, w1, V, tau, K );
+
+	qr_unit( w1, c, V, K->S, 1 );
+	flag = flag | qr_larft( w1, n - c, c, V, tau + c, K->T );
+	// Transposed: A2 = A2 - A2 * V1 * T * transpose( V1 ).
+	flag = flag | gemm_sub_rmat( 'N', 'T', w2, n - c, w1, 1, V, c + w1, c,
+	                             V, c, c, 0, K->W, 0, 0 );
+	flag = flag | gemm_rmat( 'N', 'N', w2, w1, w1, 1, K->W, K->T, 0, K->Y );
+	flag = flag | gemm_sub_rmat( 'N', 'N', w2, w1, n - c, -1, K->Y, 0, 0,
+	                             V, c, c, 1, V, c + w1, c );
+	qr_unit( w1, c, V, K->S, 0 );
+
+	return( flag | qr_panel( n, c + w1, w2, V, tau, K ) );
+}
+/* Copies the n-X-nb block of A at (j,j) into the rows of V, transposed
+   (get = 1), or back into A (get = 0).
+*/
+static void qr_copy( int n, int nb, int j, double **A, double **V, int get ) {
+	int i, c;
+
+	for( i = 0; i < n; i++ ) {
+	  for( c = 0; c < nb; c++ ) {
+	    if( get == 1 ) {
+	      V[c][i] = A[j + i][j + c];
+	    }
+	    else {
+	      A[j + i][j + c] = V[c][i];
+	    }
+	  }
+	}
+	return;
+}
+// Blocked factorization without pivoting (see qr_rmat).
+static int qr_blocked( int m, int n, double **A, double *tau ) {
+	int     j, jb, kmax, flag;
+	Qr_work K;
+
+	if( qr_alloc( m, n, &K ) != 0 ) {
+	  return( -1 );
+	}
+	kmax = ( m < n ) ? m : n;
+	flag = 0;
+	for( j = 0; j < kmax && flag == 0; j = j + jb ) {
+	  jb = ( kmax - j < QR_NB ) ? kmax - j : QR_NB;
+
+	  qr_copy( m - j, jb, j, A, K.V, 1 );
+	  flag = qr_panel( m - j, 0, jb, K.V, tau + j, &K );
+	  qr_copy( m - j, jb, j, A, K.V, 0 );
+
+	  if( j + jb < n ) { // The rest of the matrix.
+	    qr_unit( jb, 0, K.V, NULL, 1 );
+	    flag = flag | qr_larft( jb, m - j, 0, K.V, tau + j, K.T );
+	    flag = flag | qr_larfb( 'T', jb, m - j, &K, n - j - jb, A, j, j + jb );
+	  }
+	}
+	qr_free( &K );
+	return( flag );
+}
+/* The norm of the rows r to m - 1 of column c of A. v is a work
+   vector.
+*/
+static double qr_cnorm( int m, int r, int c, double **A, double *v ) {
+	int i;
 
-	for( i = 1; i < n; i++ ) {
-	  det = det * A[i][i];
+	for( i = r; i < m; i++ ) {
+	  v[i - r] = A[i][c];
 	}
-	return( det );
+	return( nrm2_rvec( m - r, v ) );
 }
-//========================================================
-//	4.5. DETERMINANT CALCULATION BY LU DECOMPOSITION
-//========================================================
-// This functions uses LU decomposition to calculate the determinant of a n-X-n square matrix A. The function returns the determinant value.
-double ludet_rmat( int n, double **A ) {
-	double det, **L, **U;
+/* Blocked factorization with column pivoting (see qr_rmat), as in
+   LAPACK's xGEQP3: at each step the column of largest norm is moved
+   to the front. The reflections of a panel are not applied at once:
+   F = transpose( A ) * V * T is built instead, and only the next
+   column and the next row of R are updated, so the rest of the matrix
+   is updated by a GEMM at the end of the panel. The norms of the
+   columns are downdated, and the panel stops when a norm has lost too
+   many digits, so it is computed again. Half of the work is still a
+   matrix-vector product per column.
+*/
+static int qr_pivot( int m, int n, double **A, double *tau, int *P ) {
+	int    i, j, k, c, g, nn, kb, rk, len, kmax, lst, flag;
+	double **F, **Av, *vn1, *vn2, *v, *y, *aux, akk, t, tol;
 
-	alloc_rmat( n, n, &L );      // L matrix.
-	alloc_rmat( n, n, &U );      // U matrix.
-	ludecomp_rmat( n, A, L, U ); // L's and U's elements.
-	det = ditridet_rmat( n, U ); // det(L) = 1. (^-^)
+	kmax = ( m < n ) ? m : n;
+	F = NULL;
+	vn1 = NULL;
+	vn2 = NULL;
+	v = NULL;
+	y = NULL;
+	aux = NULL;
+	flag = alloc_rmat( n, QR_NB, &F );
+	flag = flag | alloc_rvec( n, &vn1 ) | alloc_rvec( n, &vn2 );
+	flag = flag | alloc_rvec( m, &v ) | alloc_rvec( n, &y );
+	flag = flag | alloc_rvec( QR_NB, &aux );
 
-	free_rmat( n, &L );
-	free_rmat( n, &U );
-	return( det );
+	tol = sqrt( DBL_EPSILON );
+	for( c = 0; c < n && flag == 0; c++ ) {
+	  P[c] = c;
+	  vn1[c] = qr_cnorm( m, 0, c, A, v );
+	  vn2[c] = vn1[c];
+	}
+	for( j = 0; j < kmax && flag == 0; j = j + kb ) {
+	  nn = n - j; // Columns j to n - 1, counted from 0.
+	  lst = -1;   // List of the norms to compute again.
+	  k = 0;
+	  do {
+	    rk = j + k;
+	    len = m - rk;
+
+	    g = k; // Pivot.
+	    for( c = k + 1; c < nn; c++ ) {
+	      g = ( vn1[j + c] > vn1[j + g] ) ? c : g;
+	    }
+	    if( g != k ) {
+	      for( i = 0; i < m; i++ ) {
+	        t = A[i][j + g];
+	        A[i][j + g] = A[i][j + k];
+	        A[i][j + k] = t;
+	      }
+	      for( i = 0; i < k; i++ ) {
+	        t = F[g][i];
+	        F[g][i] = F[k][i];
+	        F[k][i] = t;
+	      }
+	      i = P[j + g];
+	      P[j + g] = P[j + k];
+	      P[j + k] = i;
+	      vn1[j + g] = vn1[j + k];
+	      vn2[j + g] = vn2[j + k];
+	    }
+
+	    for( i = rk; i < m && k > 0; i++ ) { // Earlier reflections.
+	      A[i][j + k] = A[i][j + k] - simd.dot( k, A[i] + j, F[k] );
+	    }
+	    for( i = 0; i < len; i++ ) {
+	      v[i] = A[rk + i][j + k];
+	    }
+	    tau[rk] = qr_house( len, v );
+	    for( i = 1; i < len; i++ ) {
+	      A[rk + i][j + k] = v[i];
+	    }
+	    akk = v[0];
+	    v[0] = 1;
+	    A[rk][j + k] = 1;
+
+	    // F(k+1:nn,k) = tau * transpose( A(rk:m,k+1:nn) ) * v.
+	    for( c = 0; c < nn; c++ ) {
+	      F[c][k] = 0;
+	    }
+	    if( k + 1 < nn ) {
+	      flag = sub_rmat( rk, j + k + 1, len, A, &Av );
+	      flag = flag | gemv_rmat( 'T', len, nn - k - 1, tau[rk], Av, v, 1,
+	                               0, y, 1 );
+	      free_rmat( 0, &Av );
+	      for( c = k + 1; c < nn; c++ ) {
+	        F[c][k] = y[c - k - 1];
+	      }
+	    }
+	    // F(:,k) = F(:,k) - tau * F(:,0:k) * transpose( A(rk:m,0:k) ) * v.
+	    if( k > 0 && flag == 0 ) {
+	      flag = sub_rmat( rk, j, len, A, &Av );
+	      flag = flag | gemv_rmat( 'T', len, k, -tau[rk], Av, v, 1, 0, aux, 1 );
+	      free_rmat( 0, &Av );
+	      for( c = 0; c < nn; c++ ) {
+	        F[c][k] = F[c][k] + simd.dot( k, F[c], aux );
+	      }
+	    }
+	    for( c = k + 1; c < nn; c++ ) { // Row rk of R.
+	      A[rk][j + c] = A[rk][j + c] - simd.dot( k + 1, A[rk] + j, F[c] );
+	    }
+
+	    for( c = k + 1; c < nn && rk < kmax - 1; c++ ) { // Norms.
+	      g = j + c;
+	      if( vn1[g] != 0 ) {
+	        t = fabs( A[rk][g] ) / vn1[g];
+	        t = ( 1 + t ) * ( 1 - t );
+	        t = ( t > 0 ) ? t : 0;
+	        if( t * ( vn1[g] / vn2[g] ) * ( vn1[g] / vn2[g] ) <= tol ) {
+	          vn2[g] = lst;
+	          lst = g;
+	        }
+	        else {
+	          vn1[g] = vn1[g] * sqrt( t );
+	        }
+	      }
+	    }
+	    A[rk][j + k] = akk;
+	    k++;
+	  } while( k < QR_NB && j + k < kmax && lst < 0 && flag == 0 );
+
+	  kb = k;
+	  rk = j + kb;
+	  if( kb < nn && rk < m && flag == 0 ) { // The rest of the matrix.
+	    flag = gemm_sub_rmat( 'N', 'T', m - rk, kb, nn - kb, -1, A, rk, j,
+	                          F, kb, 0, 1, A, rk, j + kb );
+	  }
+	  while( lst >= 0 ) {
+	    g = ( int ) vn2[lst];
+	    vn1[lst] = qr_cnorm( m, rk, lst, A, v );
+	    vn2[lst] = vn1[lst];
+	    lst = g;
+	  }
+	}
+
+	free_rmat( n, &F );
+	free_rvec( &vn1 );
+	free_rvec( &vn2 );
+	free_rvec( &v );
+	free_rvec( &y );
+	free_rvec( &aux );
+	return( flag );
 }
-//================================================================
-//	4.6. DETERMINAT CALCULATION BY CHOLESKY DECOMPOSITION
-//================================================================
-// This functions uses Cholesky decomposition by column to calculate and return the determinant of a n-X-n square matrix A.
-double choldet_rmat( int n, double **A ) {
-	int i, j;
-	double det, **U;
 
-	alloc_rmat( n, n, &U );     // Upper triangular matrix.
-	choldecomp_rmat( n, A, U ); // U's elements.
+/* This function factorizes a m-X-n matrix A as A * P = Q * R (see
+   above): R and the reflections overwrite A, and tau gets the min( m,
+   n ) factors of the reflections. If P is NULL, there is no pivoting;
+   otherwise, P gets n elements: column j of A * P is column P[j] of
+   A, and the diagonal of R decreases in absolute value, which shows
+   the numerical rank of A. Without pivoting nearly all the work is
+   done by gemm_rmat. It returns -1 if memory is not available.
+*/
+int qr_rmat( int m, int n, double **A, double *tau, int *P ) {
+	if( m < 1 || n < 1 ) {
+	  return( 0 );
+	}
+	if( P != NULL ) {
+	  return( qr_pivot( m, n, A, tau, P ) );
+	}
+	return( qr_blocked( m, n, A, tau ) );
+}
+/* This function sets C = Q * C (trans = 'N') or C = transpose( Q ) *
+   C (trans = 'T'), where C is a m-X-nc matrix and Q is the m-X-m
+   orthogonal matrix of a QR factorization of a m-X-n matrix by
+   qr_rmat, kept in A and tau. The reflections are applied in blocks of
+   QR_NB, by GEMMs. It returns -1 if trans is not valid or if memory is
+   not available.
+*/
+int qmult_rmat( char trans, int m, int n, double **A, double *tau,
+                int nc, double **C ) {
+	int     j, j0, jb, nb, kmax, flag;
+	Qr_work K;
+
+	if( trans != 'N' && trans != 'T' ) {
+	  return( -1 );
+	}
+	kmax = ( m < n ) ? m : n;
+	if( kmax < 1 || nc < 1 ) {
+	  return( 0 );
+	}
+	if( qr_alloc( m, nc, &K ) != 0 ) {
+	  return( -1 );
+	}
+	j0 = ( ( kmax - 1 ) / QR_NB ) * QR_NB; // The last block.
+	flag = 0;
+	for( j = 0; j < kmax && flag == 0; j = j + QR_NB ) {
+	  jb = ( trans == 'T' ) ? j : j0 - j; // Q from its last block.
+	  nb = ( kmax - jb < QR_NB ) ? kmax - jb : QR_NB;
+
+	  qr_copy( m - jb, nb, jb, A, K.V, 1 );
+	  qr_unit( nb, 0, K.V, NULL, 1 );
+	  flag = qr_larft( nb, m - jb, 0, K.V, tau + jb, K.T );
+	  flag = flag | qr_larfb( trans, nb, m - jb, &K, nc, C, jb, 0 );
+	}
+	qr_free( &K );
+	return( flag );
+}
+/* This function sets the m-X-nc matrix Q to the first nc columns of
+   the orthogonal matrix of a QR factorization of a m-X-n matrix by
+   qr_rmat, kept in A and tau; nc <= m. With nc = n <= m it gives the
+   economy-size factorization A * P = Q * R1, where R1 is the upper n-X-n
+   block of R; with nc = m, the full Q. It returns -1 if memory is not
+   available.
+*/
+int qform_rmat( int m, int n, double **A, double *tau, int nc, double **Q ) {
+	int i;
 
-	det = ditridet_rmat( n, U );
-	// The matrix and its tranpose determinants.
-	det = det * det;
+	zero_rmat( m, nc, Q );
+	for( i = 0; i < m && i < nc; i++ ) {
+	  Q[i][i] = 1;
+	}
+	return( qmult_rmat( 'N', m, n, A, tau, nc, Q ) );
+}
+/* This function solves the linear least-squares problems min || A *
+   X - B ||, column by column, for the m-X-n matrix A, m >= n, and the
+   m-X-nc matrix B, by the QR factorization of A: X is the n-X-nc
+   solution. A is overwritten by its factorization (see qr_rmat) and
+   B by transpose( Q ) * B, whose rows r to m - 1 give the norm of the
+   residual of each column. If pivot = 'N', A must have full rank (r =
+   n); if pivot = 'P', the columns are pivoted, and the rank r is the
+   number of diagonal elements of R above DBL_EPSILON * m * |R[0][0]|:
+   the basic solution is found, with n - r elements of X equal to 0. It
+   returns the rank, or -1 if pivot is not valid, if m < n, if A is
+   rank deficient with pivot = 'N' or if memory is not available.
+*/
+int lsq_rmat( char pivot, int m, int n, double **A, int nc, double **B,
+              double **X ) {
+	int    i, r, *P;
+	double *tau, **Y;
 
-	free_rmat( n, &U );
-	return( det );
+	if( ( pivot != 'N' && pivot != 'P' ) || m < n || n < 1 ) {
+	  return( -1 );
+	}
+	P = NULL;
+	Y = NULL;
+	if( alloc_rvec( n, &tau ) != 0 ) {
+	  return( -1 );
+	}
+	if( pivot == 'P' ) {
+	  P = ( int* ) malloc( n * sizeof( int ) );
+	  if( P == NULL || alloc_rmat( n, nc, &Y ) != 0 ) {
+	    free( P );
+	    free_rvec( &tau );
+	    return( -1 );
+	  }
+	}
+
+	r = -1;
+	if( qr_rmat( m, n, A, tau, P ) == 0
+	    && qmult_rmat( 'T', m, n, A, tau, nc, B ) == 0 ) {
+	  for( r = 0; r < n; r++ ) {
+	    if( ( pivot == 'N' && A[r][r] == 0 ) || ( pivot == 'P'
+	        && fabs( A[r][r] ) <= DBL_EPSILON * m * fabs( A[0][0] ) ) ) {
+	      break;
+	    }
+	  }
+	  if( pivot == 'N' && r < n ) {
+	    r = -1;
+	  }
+	}
+	if( r >= 0 ) {
+	  for( i = 0; i < n; i++ ) {
+	    if( i < r ) {
+	      memcpy( X[i], B[i], nc * sizeof( double ) );
+	    }
+	    else {
+	      memset( X[i], 0, nc * sizeof( double ) );
+	    }
+	  }
+	  if( r > 0 && trsm_rmat( 'L', 'U', 'N', 'N', r, nc, A, X ) != 0 ) {
+	    r = -1;
+	  }
+	}
+	if( r >= 0 && P != NULL ) { // Row P[i] of X is row i of Y.
+	  for( i = 0; i < n; i++ ) {
+	    memcpy( Y[i], X[i], nc * sizeof( double ) );
+	  }
+	  for( i = 0; i < n; i++ ) {
+	    memcpy( X[P[i]], Y[i], nc * sizeof( double ) );
+	  }
+	}
+
+	if( P != NULL ) {
+	  free( P );
+	  free_rmat( n, &Y );
+	}
+	free_rvec( &tau );
+	return( r );
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//	5. SYSTEMS OF LINEAR ALGEBRAIC EQUATIONS
+//	6. MATRIX FUNCTIONS
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //============================================================
-//	5.1. SOLVING OF A LINEAR SYSTEM BY LU DECOMPOSITION
+//	6.1. MATRIX EXPONENTIAL
 //============================================================
-/* This function employs LU decomposition to solve a linear system
-   A * X = B, which A is a n-X-n square matrix, b is a n-X-1
-   slender matrix and X is the solution of the system.
+/* exp( A ) is approximated by the [m/m] Pade approximant
+   r( A ) = ( V - U )^(-1) * ( V + U ), where U holds the odd powers of
+   A and V the even ones, for the lowest degree m in 3, 5, 7, 9, 13
+   whose bound expm_theta[k] on the 1-norm of A keeps the error below
+   the unit roundoff. If even m = 13 is not enough, A is scaled by
+   2^(-s) and r( A / 2^s ) is squared s times (N. J. Higham, SIAM J.
+   Matrix Anal. Appl. 26 (2005) 1179).
 */
-void lusolve_rmat( int n, double **A, double **X, double **B ) {
-	int i, j;
-	double sum, **L, **U, **Y; // Auxiliary matrices.
-	
-	alloc_rmat( n, n, &L );
-	alloc_rmat( n, n, &U );
-	alloc_rmat( n, 1, &Y );
-	ludecomp_rmat( n, A, L, U ); // A*X=L*(U*X)=L*Y=B.
-
-	Y[0][0] = B[0][0]; // Y's calculation (L*Y=B).
-	for( i = 1; i < n; i++ ) {
-	  sum = 0;
-	  for( j = 0; j < i; j++ ) {
-	    sum = sum + L[i][j] * Y[j][0];
+static const int    expm_m[5] = { 3, 5, 7, 9, 13 };
+static const double expm_theta[5] = { 1.495585217958292e-2,
+       2.539398330063230e-1, 9.504178996162932e-1, 2.097847961257068e0,
+       5.371920351148152e0 };
+static const double expm_b[5][14] = {
+	{ 120, 60, 12, 1 },
+	{ 30240, 15120, 3360, 420, 30, 1 },
+	{ 17297280, 8648640, 1995840, 277200, 25200, 1512, 56, 1 },
+	{ 17643225600., 8821612800., 2075673600, 302702400, 30270240,
+	  2162160, 110880, 3960, 90, 1 },
+	{ 64764752532480000., 32382376266240000., 7771770303897600.,
+	  1187353796428800., 129060195264000., 10559470521600.,
+	  670442572800., 33522128640., 1323241920, 40840800, 960960, 16380,
+	  182, 1 }
+};
+
+// The 1-norm (largest column sum of absolute values) of A.
+static double expm_norm1( int n, double **A ) {
+	int    i, j;
+	double norm, *S;
+
+	S = ( double* ) calloc( n > 0 ? n : 1, sizeof( double ) );
+	norm = 0;
+	if( S == NULL ) {
+	  return( norm );
+	}
+	for( i = 0; i < n; i++ ) {
+	  for( j = 0; j < n; j++ ) {
+	    S[j] = S[j] + fabs( A[i][j] );
 	  }
-	  Y[i][0] = B[i][0] - sum;
 	}
+	for( j = 0; j < n; j++ ) {
+	  norm = ( S[j] > norm ) ? S[j] : norm;
+	}
+	free( S );
+	return( norm );
+}
 
-	// X's calculation (U*X=Y)
-	X[n - 1][0] = Y[n - 1][0] / U[n - 1][n - 1];
-	for( i = n - 2; i >= 0; i-- ) {
-	  sum = 0;
-	  for( j = n - 1; j >= 0; j-- ) {
-	    sum = sum + U[i][j] * X[j][0];
-	  }		
-	  X[i][0] = ( Y[i][0] - sum ) / U[i][i];
+/* This function calculates the exponential of a n-X-n square matrix
+   A, and the result is set into a square matrix B (which may not be
+   A). It returns -1 if memory is not available or if the Pade
+   denominator is singular.
+*/
+int expm_rmat( int n, double **A, double **B ) {
+	int    i, j, k, m, s, flag;
+	double norm, c;
+	double **W[6], **S, **A2, **A4, **A6, **U, **V;
+	const double *b;
+	Rfact  F;
+
+	flag = 0;
+	for( i = 0; i < 6; i++ ) {
+	  flag = flag | alloc_rmat( n, n, &W[i] );
+	}
+	if( flag != 0 ) {
+	  for( i = 0; i < 6; i++ ) {
+	    free_rmat( n, &W[i] );
+	  }
+	  return( -1 );
 	}
+	S = W[0];
+	A2 = W[1];
+	A4 = W[2];
+	A6 = W[3];
+	U = W[4];
+	V = W[5];
 
-	free_rmat( n, &L );
-	free_rmat( n, &U );
-	free_rmat( n, &Y );
-	return;
+	norm = expm_norm1( n, A );
+	k = 0;
+	while( k < 4 && norm > expm_theta[k] ) {
+	  k++;
+	}
+	s = 0;
+	if( k == 4 && norm > expm_theta[4] ) {
+	  s = ( int ) ceil( log2( norm / expm_theta[4] ) );
+	}
+	m = expm_m[k];
+	b = expm_b[k];
+
+	c = ldexp( 1, -s );
+	for( i = 0; i < n; i++ ) {
+	  for( j = 0; j < n; j++ ) {
+	    S[i][j] = c * A[i][j];
+	  }
+	}
+	flag = flag | gemm_rmat( 'N', 'N', n, n, n, 1, S, S, 0, A2 );
+	if( m >= 5 ) {
+	  flag = flag | gemm_rmat( 'N', 'N', n, n, n, 1, A2, A2, 0, A4 );
+	}
+	if( m >= 7 ) {
+	  flag = flag | gemm_rmat( 'N', 'N', n, n, n, 1, A4, A2, 0, A6 );
+	}
+
+	// The odd part over A, sum of b[2k+1] * A^(2k), is set into B and
+	// the even part V, sum of b[2k] * A^(2k), into U. For m = 13, A^8,
+	// A^10 and A^12 come from A6 times combinations of A2, A4 and A6.
+	for( i = 0; i < n; i++ ) {
+	  for( j = 0; j < n; j++ ) {
+	    if( m == 13 ) {
+	      B[i][j] = b[13] * A6[i][j] + b[11] * A4[i][j] + b[9] * A2[i][j];
+	      U[i][j] = b[12] * A6[i][j] + b[10] * A4[i][j] + b[8] * A2[i][j];
+	    }
+	    else {
+	      B[i][j] = b[1] * ( i == j ) + b[3] * A2[i][j];
+	      U[i][j] = b[0] * ( i == j ) + b[2] * A2[i][j];
+	      if( m >= 5 ) {
+	        B[i][j] = B[i][j] + b[5] * A4[i][j];
+	        U[i][j] = U[i][j] + b[4] * A4[i][j];
+	      }
+	      if( m >= 7 ) {
+	        B[i][j] = B[i][j] + b[7] * A6[i][j];
+	        U[i][j] = U[i][j] + b[6] * A6[i][j];
+	      }
+	    }
+	  }
+	}
+	if( m == 9 ) { // A^8 = A4 * A4.
+	  flag = flag | gemm_rmat( 'N', 'N', n, n, n, b[9], A4, A4, 1, B );
+	  flag = flag | gemm_rmat( 'N', 'N', n, n, n, b[8], A4, A4, 1, U );
+	}
+	if( m == 13 ) {
+	  flag = flag | gemm_rmat( 'N', 'N', n, n, n, 1, A6, B, 0, V );
+	  for( i = 0; i < n; i++ ) {
+	    for( j = 0; j < n; j++ ) {
+	      B[i][j] = V[i][j] + b[7] * A6[i][j] + b[5] * A4[i][j]
+	                + b[3] * A2[i][j] + b[1] * ( i == j );
+	    }
+	  }
+	  flag = flag | gemm_rmat( 'N', 'N', n, n, n, 1, A6, U, 0, V );
+	  for( i = 0; i < n; i++ ) {
+	    for( j = 0; j < n; j++ ) {
+	      U[i][j] = V[i][j] + b[6] * A6[i][j] + b[4] * A4[i][j]
+	                + b[2] * A2[i][j] + b[0] * ( i == j );
+	    }
+	  }
+	}
+	// V = S * B is the odd part, then V + U and V - U (U still holds the
+	// even part) are set into B and U.
+	flag = flag | gemm_rmat( 'N', 'N', n, n, n, 1, S, B, 0, V );
+	for( i = 0; i < n; i++ ) {
+	  for( j = 0; j < n; j++ ) {
+	    B[i][j] = U[i][j] + V[i][j];
+	    U[i][j] = U[i][j] - V[i][j];
+	  }
+	}
+
+	// r = ( V - U )^(-1) * ( V + U ), then r is squared s times.
+	if( flag == 0 ) {
+	  flag = fact_rmat( FACT_LU, n, U, &F );
+	  if( flag == 0 ) {
+	    flag = solve_rfact( &F, n, B );
+	  }
+	  free_rfact( &F );
+	}
+	for( k = 0; k < s && flag == 0; k++ ) { // Ping-pong between B and S.
+	  if( k % 2 == 0 ) {
+	    flag = gemm_rmat( 'N', 'N', n, n, n, 1, B, B, 0, S );
+	  }
+	  else {
+	    flag = gemm_rmat( 'N', 'N', n, n, n, 1, S, S, 0, B );
+	  }
+	}
+	if( s % 2 == 1 ) {
+	  for( i = 0; i < n; i++ ) {
+	    memcpy( B[i], S[i], n * sizeof( double ) );
+	  }
+	}
+
+	for( i = 0; i < 6; i++ ) {
+	  free_rmat( n, &W[i] );
+	}
+	return( flag );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	7. OUT-OF-CORE OPERATIONS
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/* The routines below take a n-X-m matrix A from a panel stream P (see
+   pstream_open), so only two panels of A are in memory at once, and
+   the next panel is read while one is used. They start P from its
+   first row, and read it once.
+*/
+//============================================================
+//	7.1. OUT-OF-CORE MATRIX MULTIPLICATION
+//============================================================
+/* This function calculates C = A * B, where B is a m-X-p matrix in
+   memory, panel by panel, and writes the n-X-p matrix C into a binary
+   file inside the folder "files" (see bin_map_rmat) as its panels are
+   found. It returns -1 if A or the file cannot be read or written.
+*/
+int ooc_gemm_rmat( Pstream *P, int p, double **B, char filename[] ) {
+	FILE     *file;
+	int      i0, nr, n, i, flag;
+	char     *path;
+	double   **A, **C;
+	Bin_head H;
+
+	flag = pstream_rewind( P );
+	if( flag != 0 || alloc_rmat( P->rows, p, &C ) != 0 ) {
+	  return( -1 );
+	}
+	path = file_path( filename );
+	file = ( path != NULL ) ? fopen( path, "wb" ) : NULL;
+	free_chvec( &path );
+	if( file == NULL ) {
+	  free_rmat( P->rows, &C );
+	  return( -1 );
+	}
+
+	memset( &H, 0, sizeof( H ) );
+	memcpy( H.magic, "LILAMAT", 8 );
+	H.version = BIN_VERSION;
+	H.endian = BIN_ENDIAN;
+	H.dtype = BIN_DOUBLE;
+	H.layout = BIN_ROWMAJOR;
+	H.align = BIN_HEAD;
+	H.m = p;
+	H.offset = BIN_HEAD;
+	flag = ( fwrite( &H, sizeof( H ), 1, file ) == 1 ) ? 0 : -1;
+	n = nr = 0;
+	while( flag == 0 && ( nr = pstream_next( P, &i0, &A ) ) > 0 ) {
+	  flag = gemm_rmat( 'N', 'N', nr, P->m, p, 1, A, B, 0, C );
+	  for( i = 0; i < nr && flag == 0; i++ ) {
+	    flag = ( fwrite( C[i], sizeof( double ), p, file ) == ( size_t ) p ) ? 0 : -1;
+	  }
+	  n = n + nr;
+	}
+	flag = ( nr < 0 ) ? -1 : flag;
+
+	H.n = n; // Now the number of rows is known.
+	if( flag == 0 && ( fseek( file, 0, SEEK_SET ) != 0
+	    || fwrite( &H, sizeof( H ), 1, file ) != 1 ) ) {
+	  flag = -1;
+	}
+	if( fclose( file ) != 0 ) {
+	  flag = -1;
+	}
+	free_rmat( P->rows, &C );
+	return( flag );
+}
+//============================================================
+//	7.2. OUT-OF-CORE GRAM MATRIX
+//============================================================
+/* This function calculates the m-X-m Gram matrix G = transpose( A ) *
+   A as a sum over the panels of A, e.g. for the normal equations of a
+   least-squares problem. It returns -1 if A cannot be read.
+*/
+int ooc_gram_rmat( Pstream *P, double **G ) {
+	int    i0, nr, flag;
+	double **A;
+
+	if( pstream_rewind( P ) != 0 ) {
+	  return( -1 );
+	}
+	zero_rmat( P->m, P->m, G );
+	flag = 0;
+	while( ( nr = pstream_next( P, &i0, &A ) ) > 0 ) {
+	  flag = flag | gemm_rmat( 'T', 'N', P->m, nr, P->m, 1, A, A, 1, G );
+	}
+	return( ( nr < 0 ) ? -1 : flag );
+}
+//============================================================
+//	7.3. OUT-OF-CORE MATRIX-VECTOR PRODUCTS
+//============================================================
+/* This function sets y = alpha * op(A) * x + beta * y, as gemv_rmat
+   does, where op(A) = A (ta = 'N', y must have a room for each row of
+   A) or op(A) = transpose( A ) (ta = 'T', x must have an element for
+   each row of A). It returns -1 if ta is not valid or if A cannot be
+   read.
+*/
+int ooc_gemv_rmat( char ta, Pstream *P, double alpha, double *x,
+                   double beta, double *y ) {
+	int    i0, nr, flag;
+	double **A;
+
+	if( ( ta != 'N' && ta != 'T' ) || pstream_rewind( P ) != 0 ) {
+	  return( -1 );
+	}
+	if( ta == 'T' ) {
+	  if( beta == 0 ) {
+	    memset( y, 0, P->m * sizeof( double ) );
+	  }
+	  else {
+	    scal_rvec( P->m, beta, y );
+	  }
+	}
+	flag = 0;
+	while( ( nr = pstream_next( P, &i0, &A ) ) > 0 ) {
+	  if( ta == 'N' ) {
+	    flag = flag | gemv_rmat( 'N', nr, P->m, alpha, A, x, 1, beta, y + i0, 1 );
+	  }
+	  else {
+	    flag = flag | gemv_rmat( 'T', nr, P->m, alpha, A, x + i0, 1, 1, y, 1 );
+	  }
+	}
+	return( ( nr < 0 ) ? -1 : flag );
 }
 
 // Main function.
+/*
 int main() {
+	int    i, P[3];
 	double **mA, *vA;
 
 	alloc_rmat( 3, 3, &mA );
@@ -546,7 +4389,10 @@ int main() {
 	get_rmat( 3, 3, mA, "mat.in" );
 	//get_rvec( 3, vA, "vec.in" );
 
-	cpivot_rmat( 3, mA, vA );
+	cpivot_rmat( 3, mA, P );
+	for( i = 0; i < 3; i++ ) {
+	  vA[i] = P[i];
+	}
 	out_rmat( 3, 3, mA, "mat.out" );
 	out_rvec( 3, vA, "vec.out" );
 
@@ -554,3 +4400,4 @@ int main() {
 	free_rvec( &vA );
 	return( 0 );
 }
+*/
@@ -0,0 +1,2212 @@
+#include "matrices-and-vectors.c"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	1. SPARSE MATRICES
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/* A sparse n-X-m matrix (Smat) keeps only its nonzero elements, in
+   compressed sparse rows (format 'R', CSR) or columns (format 'C',
+   CSC). In CSR, the elements of row i are val[ptr[i]], ...,
+   val[ptr[i + 1] - 1], in the columns ind[ptr[i]], ...; in CSC, the
+   same holds for column j, with the rows of its elements in ind. The
+   rows (columns) are called the major vectors of the matrix. The
+   builders below give each major vector its indices in increasing
+   order, with no repeated index.
+
+   The arrays of a CSR matrix A are also the arrays of the CSC matrix
+   transpose( A ), so a matrix is transposed by swapping n and m and
+   changing its format.
+*/
+//=====================================================
+//	1.1. ALLOCATING AND DELETING A SPARSE MATRIX
+//=====================================================
+typedef struct {
+	int    n, m;		// Number of rows and columns.
+	int    nnz;		// Number of stored elements.
+	char   format;		// 'R' (CSR) or 'C' (CSC).
+	int    *ptr;		// First element of each major vector, and nnz.
+	int    *ind;		// Minor index of each element.
+	double *val;
+} Smat;
+
+// Number of major vectors of A.
+static int smat_major( Smat *A ) {
+	return( ( A->format == 'R' ) ? A->n : A->m );
+}
+
+/* This function allocates a n-X-m sparse matrix A in the format 'R'
+   or 'C' with room for nnz elements, with all its major vectors empty
+   (A->ptr set to zero). It returns -1 if the format is not valid or if
+   memory is not available.
+*/
+int alloc_smat( int n, int m, int nnz, char format, Smat *A ) {
+	A->n = n;
+	A->m = m;
+	A->nnz = 0;
+	A->format = format;
+	A->ind = NULL;
+	A->val = NULL;
+	A->ptr = NULL;
+	if( ( format != 'R' && format != 'C' ) || n < 0 || m < 0 || nnz < 0 ) {
+	  return( -1 );
+	}
+	A->ptr = ( int* ) calloc( smat_major( A ) + 1, sizeof( int ) );
+	A->ind = ( int* ) malloc( ( nnz > 0 ? nnz : 1 ) * sizeof( int ) );
+	A->val = ( double* ) malloc( ( nnz > 0 ? nnz : 1 ) * sizeof( double ) );
+	if( A->ptr == NULL || A->ind == NULL || A->val == NULL ) {
+	  free( A->ptr );
+	  free( A->ind );
+	  free( A->val );
+	  A->ptr = A->ind = NULL;
+	  A->val = NULL;
+	  return( -1 );
+	}
+	return( 0 );
+}
+/* This function sets free a sparse matrix A.
+*/
+int free_smat( Smat *A ) {
+	free( A->ptr );
+	free( A->ind );
+	free( A->val );
+	A->ptr = A->ind = NULL;
+	A->val = NULL;
+	A->n = A->m = A->nnz = 0;
+
+	return( 0 );
+}
+//=====================================================
+//	1.2. BUILDING A SPARSE MATRIX FROM TRIPLETS
+//=====================================================
+/* The triplets are sorted by two counting passes, so a matrix is
+   built in a time proportional to nt + n + m. A triplet matrix may
+   also be given by its lower (or upper) triangle alone, with sym set
+   to 'S' (symmetric), 'K' (skew-symmetric) or 'H' (Hermitian), as a
+   Matrix Market file stores it (see section 2): the mirror (j,i) of
+   each triplet (i,j) off the diagonal is then made while the triplets
+   are sorted, and never stored anywhere else. In the sorting, entry
+   q >= 0 is triplet q, and entry q < 0 is the mirror of triplet
+   -q - 1.
+*/
+static int smat_build( int n, int m, int nt, int *I, int *J, double *X,
+                       double *Xi, char sym, char format, Smat *A, double **Ai ) {
+	int       k, i, p, q, ne, nmaj, nmin, *maj, *min, *cnt, *perm;
+	long long total;
+	double    re, im, *V;
+
+	A->n = A->m = A->nnz = 0;
+	A->ptr = A->ind = NULL;
+	A->val = V = NULL;
+	if( Ai != NULL ) {
+	  *Ai = NULL;
+	}
+	total = nt;
+	for( k = 0; k < nt; k++ ) {
+	  if( I[k] < 0 || I[k] >= n || J[k] < 0 || J[k] >= m ) {
+	    return( -1 );
+	  }
+	  total = total + ( sym != 'G' && I[k] != J[k] );
+	}
+	if( total > INT32_MAX || ( sym != 'G' && n != m ) ) {
+	  return( -1 );
+	}
+	ne = ( int ) total;
+	if( alloc_smat( n, m, ne, format, A ) != 0 ) {
+	  return( -1 );
+	}
+	if( Ai != NULL && Xi != NULL && alloc_rvec( ne > 0 ? ne : 1, &V ) != 0 ) {
+	  free_smat( A );
+	  return( -1 );
+	}
+	maj = ( format == 'R' ) ? I : J;
+	min = ( format == 'R' ) ? J : I;
+	nmaj = smat_major( A );
+	nmin = ( format == 'R' ) ? m : n;
+	cnt = ( int* ) calloc( nmin + 1, sizeof( int ) );
+	perm = ( int* ) malloc( ( ne > 0 ? ne : 1 ) * sizeof( int ) );
+	if( cnt == NULL || perm == NULL ) {
+	  free( cnt );
+	  free( perm );
+	  free( V );
+	  free_smat( A );
+	  return( -1 );
+	}
+
+	// The entries by minor index...
+	for( k = 0; k < nt; k++ ) {
+	  cnt[min[k] + 1]++;
+	  if( sym != 'G' && I[k] != J[k] ) {
+	    cnt[maj[k] + 1]++;
+	  }
+	}
+	for( i = 0; i < nmin; i++ ) {
+	  cnt[i + 1] = cnt[i + 1] + cnt[i];
+	}
+	for( k = 0; k < nt; k++ ) {
+	  perm[cnt[min[k]]++] = k;
+	  if( sym != 'G' && I[k] != J[k] ) {
+	    perm[cnt[maj[k]]++] = -k - 1;
+	  }
+	}
+	// ...then, stably, by major index.
+	for( k = 0; k < nt; k++ ) {
+	  A->ptr[maj[k] + 1]++;
+	  if( sym != 'G' && I[k] != J[k] ) {
+	    A->ptr[min[k] + 1]++;
+	  }
+	}
+	for( i = 0; i < nmaj; i++ ) {
+	  A->ptr[i + 1] = A->ptr[i + 1] + A->ptr[i];
+	}
+	free( cnt );
+	cnt = ( int* ) malloc( ( nmaj > 0 ? nmaj : 1 ) * sizeof( int ) );
+	if( cnt == NULL ) {
+	  free( perm );
+	  free( V );
+	  free_smat( A );
+	  return( -1 );
+	}
+	memcpy( cnt, A->ptr, nmaj * sizeof( int ) );
+	for( q = 0; q < ne; q++ ) {
+	  k = ( perm[q] >= 0 ) ? perm[q] : -perm[q] - 1;
+	  re = ( X == NULL ) ? 1 : X[k];
+	  im = ( V == NULL ) ? 0 : Xi[k];
+	  if( perm[q] >= 0 ) {
+	    p = cnt[maj[k]]++;
+	    A->ind[p] = min[k];
+	  }
+	  else { // The mirror: transpose, conjugate transpose or minus.
+	    p = cnt[min[k]]++;
+	    A->ind[p] = maj[k];
+	    re = ( sym == 'K' ) ? -re : re;
+	    im = ( sym == 'K' || sym == 'H' ) ? -im : im;
+	  }
+	  A->val[p] = re;
+	  if( V != NULL ) {
+	    V[p] = im;
+	  }
+	}
+	free( cnt );
+	free( perm );
+
+	// The repeated indices of each major vector are merged.
+	p = 0;
+	for( i = 0; i < nmaj; i++ ) {
+	  q = A->ptr[i];
+	  A->ptr[i] = p;
+	  for( k = q; k < A->ptr[i + 1]; k++ ) {
+	    if( p > A->ptr[i] && A->ind[p - 1] == A->ind[k] ) {
+	      A->val[p - 1] = A->val[p - 1] + A->val[k];
+	      if( V != NULL ) {
+	        V[p - 1] = V[p - 1] + V[k];
+	      }
+	    }
+	    else {
+	      A->ind[p] = A->ind[k];
+	      A->val[p] = A->val[k];
+	      if( V != NULL ) {
+	        V[p] = V[k];
+	      }
+	      p++;
+	    }
+	  }
+	}
+	A->ptr[nmaj] = p;
+	A->nnz = p;
+	if( Ai != NULL ) {
+	  *Ai = V;
+	}
+	return( 0 );
+}
+
+/* This function builds a n-X-m sparse matrix A, in the format 'R' or
+   'C', from nt triplets (I[k], J[k], X[k]): element (I[k],J[k]) is
+   X[k], and the values of repeated pairs (I[k],J[k]) are summed, as a
+   finite element assembly needs. It takes a time proportional to
+   nt + n + m. A must be set free by free_smat. It returns -1 if some
+   index is out of the matrix, if the format is not valid or if memory
+   is not available.
+*/
+int trip_smat( int n, int m, int nt, int *I, int *J, double *X, char format,
+               Smat *A ) {
+	return( smat_build( n, m, nt, I, J, X, NULL, 'G', format, A, NULL ) );
+}
+//=====================================================
+//	1.3. CONVERSIONS
+//=====================================================
+/* This function builds a sparse matrix S, in the format 'R' or 'C',
+   from the elements of a n-X-m dense matrix A whose absolute values
+   are greater than tol (the nonzero ones, for tol = 0). S must be set
+   free by free_smat. It returns -1 if the format is not valid or if
+   memory is not available.
+*/
+int dense_smat( int n, int m, double **A, double tol, char format, Smat *S ) {
+	int i, j, nnz, *next;
+
+	nnz = 0;
+	for( i = 0; i < n; i++ ) {
+	  for( j = 0; j < m; j++ ) {
+	    nnz = nnz + ( fabs( A[i][j] ) > tol );
+	  }
+	}
+	if( alloc_smat( n, m, nnz, format, S ) != 0 ) {
+	  return( -1 );
+	}
+	for( i = 0; i < n; i++ ) {
+	  for( j = 0; j < m; j++ ) {
+	    if( fabs( A[i][j] ) > tol ) {
+	      S->ptr[( format == 'R' ? i : j ) + 1]++;
+	    }
+	  }
+	}
+	for( i = 0; i < smat_major( S ); i++ ) {
+	  S->ptr[i + 1] = S->ptr[i + 1] + S->ptr[i];
+	}
+	next = ( int* ) malloc( ( smat_major( S ) + 1 ) * sizeof( int ) );
+	if( next == NULL ) {
+	  free_smat( S );
+	  return( -1 );
+	}
+	memcpy( next, S->ptr, ( smat_major( S ) + 1 ) * sizeof( int ) );
+	for( i = 0; i < n; i++ ) {
+	  for( j = 0; j < m; j++ ) {
+	    if( fabs( A[i][j] ) > tol ) {
+	      S->ind[next[format == 'R' ? i : j]] = ( format == 'R' ) ? j : i;
+	      S->val[next[format == 'R' ? i : j]++] = A[i][j];
+	    }
+	  }
+	}
+	S->nnz = nnz;
+	free( next );
+	return( 0 );
+}
+/* This function sets the elements of a sparse matrix S into the
+   S->n-X-S->m dense matrix A, and zero into the others.
+*/
+int full_smat( Smat *S, double **A ) {
+	int i, k;
+
+	zero_rmat( S->n, S->m, A );
+	for( i = 0; i < smat_major( S ); i++ ) {
+	  for( k = S->ptr[i]; k < S->ptr[i + 1]; k++ ) {
+	    if( S->format == 'R' ) {
+	      A[i][S->ind[k]] = A[i][S->ind[k]] + S->val[k];
+	    }
+	    else {
+	      A[S->ind[k]][i] = A[S->ind[k]][i] + S->val[k];
+	    }
+	  }
+	}
+	return( 0 );
+}
+/* This function sets into B the sparse matrix A in the format 'R' or
+   'C' (a copy, if A has that format already). B must be set free by
+   free_smat. It returns -1 if the format is not valid or if memory is
+   not available.
+*/
+int conv_smat( Smat *A, char format, Smat *B ) {
+	int i, k, p, nmin, *next;
+
+	if( alloc_smat( A->n, A->m, A->nnz, format, B ) != 0 ) {
+	  return( -1 );
+	}
+	if( format == A->format ) {
+	  memcpy( B->ptr, A->ptr, ( smat_major( A ) + 1 ) * sizeof( int ) );
+	  memcpy( B->ind, A->ind, A->nnz * sizeof( int ) );
+	  memcpy( B->val, A->val, A->nnz * sizeof( double ) );
+	  B->nnz = A->nnz;
+	  return( 0 );
+	}
+
+	nmin = smat_major( B );
+	for( k = 0; k < A->nnz; k++ ) {
+	  B->ptr[A->ind[k] + 1]++;
+	}
+	for( i = 0; i < nmin; i++ ) {
+	  B->ptr[i + 1] = B->ptr[i + 1] + B->ptr[i];
+	}
+	next = ( int* ) malloc( ( nmin + 1 ) * sizeof( int ) );
+	if( next == NULL ) {
+	  free_smat( B );
+	  return( -1 );
+	}
+	memcpy( next, B->ptr, ( nmin + 1 ) * sizeof( int ) );
+	for( i = 0; i < smat_major( A ); i++ ) {
+	  for( k = A->ptr[i]; k < A->ptr[i + 1]; k++ ) {
+	    p = next[A->ind[k]]++;
+	    B->ind[p] = i;
+	    B->val[p] = A->val[k];
+	  }
+	}
+	B->nnz = A->nnz;
+	free( next );
+	return( 0 );
+}
+//=====================================================
+//	1.4. SPARSE MATRIX-VECTOR PRODUCTS
+//=====================================================
+/* A product with a sparse matrix runs along its major vectors in one
+   of two ways: a gather, y[i] = dot( vector i, x ) (CSR times x, or
+   CSC transposed times x), or a scatter, y[ind] += x[i] * vector i
+   (CSR transposed times x, or CSC times x). The major vectors are cut
+   into blocks of about equal work, counted as their elements plus one
+   per vector, so rows of very different lengths (e.g. a network with
+   a few hubs) are still shared evenly among the threads. A gather
+   writes each y[i] once, so its blocks run freely; in a scatter, each
+   thread adds into its own vector, and the vectors are summed at the
+   end. The sums of the gather use SIMD gathers of x (AVX2 and
+   AVX-512), as do the updates of the scatter (AVX-512), which relies
+   on the indices of a vector being distinct.
+*/
+#define SMAT_PAR	65536	// Elements of the smallest parallel product.
+#define SMAT_BLOCKS	4	// Blocks per thread of a gather.
+
+typedef double Smat_dot( int k, const double *val, const int *ind, const double *x );
+typedef void Smat_axpy( int k, double a, const double *val, const int *ind, double *y );
+
+static double smat_dot_c( int k, const double *val, const int *ind, const double *x ) {
+	int    p;
+	double s0, s1, s2, s3;
+
+	s0 = s1 = s2 = s3 = 0;
+	for( p = 0; p + 4 <= k; p = p + 4 ) {
+	  s0 = s0 + val[p] * x[ind[p]];
+	  s1 = s1 + val[p + 1] * x[ind[p + 1]];
+	  s2 = s2 + val[p + 2] * x[ind[p + 2]];
+	  s3 = s3 + val[p + 3] * x[ind[p + 3]];
+	}
+	for( ; p < k; p++ ) {
+	  s0 = s0 + val[p] * x[ind[p]];
+	}
+	return( ( s0 + s1 ) + ( s2 + s3 ) );
+}
+static void smat_axpy_c( int k, double a, const double *val, const int *ind, double *y ) {
+	int p;
+
+	for( p = 0; p < k; p++ ) {
+	  y[ind[p]] = y[ind[p]] + a * val[p];
+	}
+	return;
+}
+
+#ifdef LILA_X86
+__attribute__(( target( "avx2,fma" ) ))
+static double smat_dot_avx2( int k, const double *val, const int *ind, const double *x ) {
+	int     p;
+	double  s[4];
+	__m256d s0, s1;
+
+	s0 = s1 = _mm256_setzero_pd();
+	for( p = 0; p + 8 <= k; p = p + 8 ) {
+	  s0 = _mm256_fmadd_pd( _mm256_loadu_pd( val + p ), _mm256_i32gather_pd( x,
+	       _mm_loadu_si128( ( const __m128i* ) ( ind + p ) ), 8 ), s0 );
+	  s1 = _mm256_fmadd_pd( _mm256_loadu_pd( val + p + 4 ), _mm256_i32gather_pd( x,
+	       _mm_loadu_si128( ( const __m128i* ) ( ind + p + 4 ) ), 8 ), s1 );
+	}
+	_mm256_storeu_pd( s, _mm256_add_pd( s0, s1 ) );
+	_mm256_zeroupper();
+	return( ( s[0] + s[1] ) + ( s[2] + s[3] ) + smat_dot_c( k - p, val + p, ind + p, x ) );
+}
+
+__attribute__(( target( "avx512f" ) ))
+static double smat_dot_avx512( int k, const double *val, const int *ind, const double *x ) {
+	int     p;
+	double  s;
+	__m512d s0, s1;
+
+	s0 = s1 = _mm512_setzero_pd();
+	for( p = 0; p + 16 <= k; p = p + 16 ) {
+	  s0 = _mm512_fmadd_pd( _mm512_loadu_pd( val + p ), _mm512_i32gather_pd(
+	       _mm256_loadu_si256( ( const __m256i* ) ( ind + p ) ), x, 8 ), s0 );
+	  s1 = _mm512_fmadd_pd( _mm512_loadu_pd( val + p + 8 ), _mm512_i32gather_pd(
+	       _mm256_loadu_si256( ( const __m256i* ) ( ind + p + 8 ) ), x, 8 ), s1 );
+	}
+	s = _mm512_reduce_add_pd( _mm512_add_pd( s0, s1 ) );
+	_mm256_zeroupper();
+	return( s + smat_dot_c( k - p, val + p, ind + p, x ) );
+}
+__attribute__(( target( "avx512f" ) ))
+static void smat_axpy_avx512( int k, double a, const double *val, const int *ind, double *y ) {
+	int     p;
+	__m256i vi;
+	__m512d va = _mm512_set1_pd( a );
+
+	for( p = 0; p + 8 <= k; p = p + 8 ) {
+	  vi = _mm256_loadu_si256( ( const __m256i* ) ( ind + p ) );
+	  _mm512_i32scatter_pd( y, vi, _mm512_fmadd_pd( va, _mm512_loadu_pd( val + p ),
+	                        _mm512_i32gather_pd( vi, y, 8 ) ), 8 );
+	}
+	_mm256_zeroupper();
+	smat_axpy_c( k - p, a, val + p, ind + p, y );
+	return;
+}
+#endif
+
+// The kernels of the SIMD level in use.
+static Smat_dot *smat_dot( void ) {
+#ifdef LILA_X86
+	if( simd.level == SIMD_AVX512 ) {
+	  return( smat_dot_avx512 );
+	}
+	if( simd.level == SIMD_AVX2 ) {
+	  return( smat_dot_avx2 );
+	}
+#endif
+	return( smat_dot_c );
+}
+static Smat_axpy *smat_axpy( void ) {
+#ifdef LILA_X86
+	if( simd.level == SIMD_AVX512 ) {
+	  return( smat_axpy_avx512 );
+	}
+#endif
+	return( smat_axpy_c );
+}
+
+// The first major vector of block b of nb blocks of about equal work
+// (elements plus vectors) of A.
+static int smat_split( Smat *A, int b, int nb ) {
+	int    lo, hi, mid, nmaj;
+	double work;
+
+	nmaj = smat_major( A );
+	work = ( ( double ) A->ptr[nmaj] + nmaj ) * b / nb;
+	lo = 0;
+	hi = nmaj;
+	while( lo < hi ) { // The first vector i with ptr[i] + i >= work.
+	  mid = lo + ( hi - lo ) / 2;
+	  if( A->ptr[mid] + ( double ) mid < work ) {
+	    lo = mid + 1;
+	  }
+	  else {
+	    hi = mid;
+	  }
+	}
+	return( lo );
+}
+
+typedef struct {
+	Smat      *A;
+	int       nb;		// Number of blocks.
+	int       ny;		// Length of y.
+	double    alpha, beta, *x, *y;
+	double    **Y;		// Scatter: the vector of each block (Y[0] = y).
+	Smat_dot  *dot;
+	Smat_axpy *axpy;
+} Smat_arg;
+
+static void smat_gather( int b, void *arg ) {
+	Smat_arg *a = ( Smat_arg* ) arg;
+	int      i, i1, *ptr;
+	double   s;
+
+	ptr = a->A->ptr;
+	i1 = smat_split( a->A, b + 1, a->nb );
+	for( i = smat_split( a->A, b, a->nb ); i < i1; i++ ) {
+	  s = a->alpha * a->dot( ptr[i + 1] - ptr[i], a->A->val + ptr[i],
+	                         a->A->ind + ptr[i], a->x );
+	  a->y[i] = ( a->beta == 0 ) ? s : s + a->beta * a->y[i];
+	}
+	return;
+}
+static void smat_scatter( int b, void *arg ) {
+	Smat_arg *a = ( Smat_arg* ) arg;
+	int      i, i1, *ptr;
+
+	ptr = a->A->ptr;
+	if( b > 0 ) {
+	  memset( a->Y[b], 0, a->ny * sizeof( double ) );
+	}
+	i1 = smat_split( a->A, b + 1, a->nb );
+	for( i = smat_split( a->A, b, a->nb ); i < i1; i++ ) {
+	  if( a->x[i] != 0 ) {
+	    a->axpy( ptr[i + 1] - ptr[i], a->alpha * a->x[i], a->A->val + ptr[i],
+	             a->A->ind + ptr[i], a->Y[b] );
+	  }
+	}
+	return;
+}
+// Sums the vectors of the blocks 1, ..., nb - 1 into y, part b of it.
+static void smat_sum( int b, void *arg ) {
+	Smat_arg *a = ( Smat_arg* ) arg;
+	int      k, j0, j1;
+
+	j0 = ( int ) ( ( double ) a->ny * b / a->nb );
+	j1 = ( int ) ( ( double ) a->ny * ( b + 1 ) / a->nb );
+	for( k = 1; k < a->nb; k++ ) {
+	  simd.add( j1 - j0, a->y + j0, a->Y[k] + j0, a->y + j0 );
+	}
+	return;
+}
+
+/* This function sets y = alpha * op(A) * x + beta * y for a sparse
+   n-X-m matrix A, where op(A) = A (ta = 'N') or op(A) = transpose( A )
+   (ta = 'T'); y is not read if beta is 0. Large products run on the
+   thread pool (see tpool_init). It returns -1 if ta is not valid or if
+   memory is not available.
+*/
+int spmv_smat( char ta, double alpha, Smat *A, double *x, double beta, double *y ) {
+	int      b, nb, flag;
+	Smat_arg a;
+
+	if( ta != 'N' && ta != 'T' ) {
+	  return( -1 );
+	}
+	a.A = A;
+	a.alpha = alpha;
+	a.beta = beta;
+	a.x = x;
+	a.y = y;
+	a.ny = ( ta == 'N' ) ? A->n : A->m;
+	nb = ( tpool_par() && A->nnz >= SMAT_PAR ) ? tpool_size() : 1;
+
+	if( ( ta == 'N' ) == ( A->format == 'R' ) ) { // A gather.
+	  a.dot = smat_dot();
+	  a.nb = nb * ( nb > 1 ? SMAT_BLOCKS : 1 );
+	  tpool_for( a.nb, smat_gather, &a );
+	  return( 0 );
+	}
+
+	if( beta == 0 ) {
+	  memset( y, 0, a.ny * sizeof( double ) );
+	}
+	else if( beta != 1 ) {
+	  scal_rvec( a.ny, beta, y );
+	}
+	a.axpy = smat_axpy();
+	a.nb = nb;
+	a.Y = ( double** ) calloc( nb, sizeof( double* ) );
+	flag = ( a.Y == NULL ) ? -1 : 0;
+	for( b = 1; b < nb && flag == 0; b++ ) {
+	  flag = alloc_rvec( a.ny, &a.Y[b] );
+	}
+	if( flag == 0 ) {
+	  a.Y[0] = y;
+	  tpool_for( nb, smat_scatter, &a );
+	  if( nb > 1 ) {
+	    tpool_for( nb, smat_sum, &a );
+	  }
+	}
+	for( b = 1; a.Y != NULL && b < nb; b++ ) {
+	  free_rvec( &a.Y[b] );
+	}
+	free( a.Y );
+	return( flag );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	2. MATRIX MARKET FILES
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/* A Matrix Market (.mtx) file starts with the line
+
+	%%MatrixMarket matrix <format> <field> <symmetry>
+
+   and then comment lines (starting with '%') and a line with the size
+   of the matrix. The format is "coordinate", for a list of elements,
+   one "i j value" line each (indices from 1), or "array", for all the
+   elements, one value per line, column after column. The field is
+   "real", "integer", "complex" (each value is a real and an imaginary
+   part) or "pattern" (no value: the elements are 1), and the symmetry
+   is "general", "symmetric", "skew-symmetric" or "hermitian". A matrix
+   which is not general is given by its lower triangle alone (its
+   strict lower triangle, if skew-symmetric); the readers below make
+   the other triangle while they fill the sparse or dense matrix, with
+   no expanded copy of the file. The imaginary parts of a complex
+   matrix are kept apart, with the same layout as the real parts.
+
+   The whole file is read, and its entry lines are parsed in chunks by
+   the threads of the pool, as in txt_get_rmat. When writing, the
+   lines are formatted in blocks by the threads, as in txt_out.
+*/
+#define MTX_LINE	80	// Longest line written: 2 indices, 2 numbers.
+#define MTX_BLOCK	( FMT_CHUNK / MTX_LINE )	// Entries per block written.
+
+typedef struct {
+	int       n, m;		// Number of rows and columns.
+	long long nnz;		// Number of entry lines.
+	char      format;	// 'C' (coordinate) or 'A' (array).
+	char      field;	// 'R' (real or integer), 'C' (complex) or 'P' (pattern).
+	char      sym;		// 'G' (general), 'S' (symmetric), 'K' (skew-symmetric)
+				// or 'H' (Hermitian).
+} Mtx_head;
+
+//=====================================================
+//	2.1. READING OF MATRIX MARKET FILES
+//=====================================================
+// Copies into w, in lower case, the first 15 characters of the word
+// which starts at (or after the separators at) p, and returns the
+// first character after the word.
+static const char *mtx_word( const char *p, const char *eol, char w[16] ) {
+	int k;
+
+	while( p < eol && txt_sep( *p ) ) {
+	  p++;
+	}
+	for( k = 0; p < eol && !txt_sep( *p ); p++ ) {
+	  if( k < 15 ) {
+	    w[k++] = ( *p >= 'A' && *p <= 'Z' ) ? *p - 'A' + 'a' : *p;
+	  }
+	}
+	w[k] = '\0';
+	return( p );
+}
+// Reads the first line p, ..., eol - 1 of a file into H.
+static int mtx_banner( const char *p, const char *eol, Mtx_head *H ) {
+	char w[16];
+
+	p = mtx_word( p, eol, w );
+	if( strcmp( w, "%%matrixmarket" ) != 0 ) {
+	  return( -1 );
+	}
+	p = mtx_word( p, eol, w );
+	if( strcmp( w, "matrix" ) != 0 ) {
+	  return( -1 );
+	}
+	p = mtx_word( p, eol, w );
+	H->format = !strcmp( w, "coordinate" ) ? 'C' : !strcmp( w, "array" ) ? 'A' : 0;
+	p = mtx_word( p, eol, w );
+	H->field = ( !strcmp( w, "real" ) || !strcmp( w, "integer" )
+	             || !strcmp( w, "double" ) ) ? 'R'
+	         : !strcmp( w, "complex" ) ? 'C' : !strcmp( w, "pattern" ) ? 'P' : 0;
+	p = mtx_word( p, eol, w );
+	H->sym = !strcmp( w, "general" ) ? 'G' : !strcmp( w, "symmetric" ) ? 'S'
+	       : !strcmp( w, "skew-symmetric" ) ? 'K' : !strcmp( w, "hermitian" ) ? 'H' : 0;
+	if( H->format == 0 || H->field == 0 || H->sym == 0
+	    || ( H->format == 'A' && H->field == 'P' ) ) {
+	  return( -1 );
+	}
+	if( H->sym == 'H' && H->field != 'C' ) { // A real Hermitian matrix.
+	  H->sym = 'S';
+	}
+	return( 0 );
+}
+// Reads the size line p, ..., eol - 1 of a file into H.
+static int mtx_size( const char *p, const char *eol, Mtx_head *H ) {
+	int    k, nk;
+	double x[3];
+
+	nk = ( H->format == 'C' ) ? 3 : 2;
+	if( txt_line( p, eol, 3, x ) != nk ) {
+	  return( -1 );
+	}
+	for( k = 0; k < nk; k++ ) {
+	  if( !( x[k] >= 0 && x[k] <= INT32_MAX ) || x[k] != floor( x[k] ) ) {
+	    return( -1 );
+	  }
+	}
+	H->n = ( int ) x[0];
+	H->m = ( int ) x[1];
+	if( H->sym != 'G' && H->n != H->m ) {
+	  return( -1 );
+	}
+	if( H->format == 'C' ) {
+	  H->nnz = ( long long ) x[2];
+	}
+	else if( H->sym == 'G' ) {
+	  H->nnz = ( long long ) H->n * H->m;
+	}
+	else {
+	  H->nnz = ( long long ) H->n * ( H->n + ( H->sym == 'K' ? -1 : 1 ) ) / 2;
+	}
+	return( 0 );
+}
+// Reads the header of the len-byte text s into H, and returns the
+// offset of its first entry line, or -1 if the header is not valid.
+static long long mtx_head( const char *s, size_t len, Mtx_head *H ) {
+	const char *p, *q, *eol, *end;
+
+	end = s + len;
+	eol = txt_eol( s, end );
+	if( mtx_banner( s, eol, H ) != 0 ) {
+	  return( -1 );
+	}
+	for( p = eol + 1; p < end; p = eol + 1 ) {
+	  eol = txt_eol( p, end );
+	  q = txt_first( p, eol );
+	  if( q < eol && *q != '%' ) {
+	    if( mtx_size( q, eol, H ) != 0 ) {
+	      return( -1 );
+	    }
+	    return( ( eol < end ) ? eol + 1 - s : ( long long ) len );
+	  }
+	}
+	return( -1 );
+}
+
+/* This function reads into H the header of a Matrix Market file
+   inside the folder "files", that is its format, field, symmetry and
+   size, with no need to read the rest of the file. It returns -1 if
+   the file cannot be read or if its header is not valid.
+*/
+int mtx_info( char filename[], Mtx_head *H ) {
+	FILE       *file;
+	char       *path, *line;
+	size_t     cap;
+	ssize_t    len;
+	int        k, flag;
+	const char *q, *eol;
+
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	file = fopen( path, "r" );
+	free_chvec( &path );
+	if( file == NULL ) {
+	  return( -1 );
+	}
+	line = NULL;
+	cap = 0;
+	flag = -1;
+	for( k = 0; ( len = getline( &line, &cap, file ) ) > 0; k++ ) {
+	  eol = line + len - ( line[len - 1] == '\n' );
+	  if( k == 0 ) {
+	    if( mtx_banner( line, eol, H ) != 0 ) {
+	      break;
+	    }
+	    continue;
+	  }
+	  q = txt_first( line, eol );
+	  if( q < eol && *q != '%' ) {
+	    flag = mtx_size( q, eol, H );
+	    break;
+	  }
+	}
+	free( line );
+	fclose( file );
+	return( flag );
+}
+
+typedef struct {
+	const char *s;		// Entry lines.
+	size_t     *cut;	// Chunk c is s[cut[c]], ..., s[cut[c + 1] - 1].
+	long long  *first;	// First entry of each chunk, after counting lines.
+	int        *err;	// Nonzero for chunks with some bad line.
+	Mtx_head   *H;
+	int        *I, *J;	// Sparse: the triplets, with their values...
+	double     *X, *Xi;	// ...(or NULL, if not read).
+	double     **A, **Ai;	// Dense: the matrix and its imaginary parts.
+} Mtx_arg;
+
+static void mtx_count( int c, void *arg ) {
+	Mtx_arg    *a = ( Mtx_arg* ) arg;
+	const char *p, *eol, *end;
+
+	a->first[c] = 0;
+	end = a->s + a->cut[c + 1];
+	for( p = a->s + a->cut[c]; p < end; p = eol + 1 ) {
+	  eol = txt_eol( p, end );
+	  a->first[c] = a->first[c] + ( txt_first( p, eol ) < eol );
+	}
+	return;
+}
+
+// Sets the element (i,j) of the dense matrix of a, and its mirror.
+static void mtx_set( Mtx_arg *a, int i, int j, double re, double im ) {
+	char sym;
+
+	sym = a->H->sym;
+	a->A[i][j] = re;
+	if( sym != 'G' && i != j ) {
+	  a->A[j][i] = ( sym == 'K' ) ? -re : re;
+	}
+	if( a->Ai != NULL ) {
+	  a->Ai[i][j] = im;
+	  if( sym != 'G' && i != j ) {
+	    a->Ai[j][i] = ( sym == 'K' || sym == 'H' ) ? -im : im;
+	  }
+	}
+	return;
+}
+
+static void mtx_parse( int c, void *arg ) {
+	Mtx_arg    *a = ( Mtx_arg* ) arg;
+	Mtx_head   *H = a->H;
+	int        nv, i, j, len;
+	long long  k, r;
+	double     x[4];
+	const char *p, *eol, *end;
+
+	nv = ( H->format == 'C' ? 2 : 0 ) + ( H->field == 'C' ? 2 : H->field == 'R' );
+	k = a->first[c];
+	i = j = 0;
+	if( H->format == 'A' && k < H->nnz ) { // The element of entry k, by columns.
+	  for( r = k; j < H->m; j++ ) { // ( m = n, if not general. )
+	    len = ( H->sym == 'G' ) ? H->n : H->n - j - ( H->sym == 'K' );
+	    if( r < len ) {
+	      i = H->n - len + ( int ) r;
+	      break;
+	    }
+	    r = r - len;
+	  }
+	}
+	end = a->s + a->cut[c + 1];
+	for( p = a->s + a->cut[c]; p < end; p = eol + 1 ) {
+	  eol = txt_eol( p, end );
+	  if( txt_first( p, eol ) == eol ) {
+	    continue;
+	  }
+	  if( k >= H->nnz || txt_line( p, eol, 4, x ) != nv ) {
+	    a->err[c] = 1;
+	    return;
+	  }
+	  if( H->format == 'A' ) {
+	    mtx_set( a, i, j, x[0], ( nv > 1 ) ? x[1] : 0 );
+	    if( ++i == H->n ) {
+	      j++;
+	      i = ( H->sym == 'G' ) ? 0 : j + ( H->sym == 'K' );
+	    }
+	  }
+	  else {
+	    if( !( x[0] >= 1 && x[0] <= H->n && x[1] >= 1 && x[1] <= H->m )
+	        || x[0] != floor( x[0] ) || x[1] != floor( x[1] ) ) {
+	      a->err[c] = 1;
+	      return;
+	    }
+	    i = ( int ) x[0] - 1;
+	    j = ( int ) x[1] - 1;
+	    if( a->A != NULL ) {
+	      mtx_set( a, i, j, ( nv > 2 ) ? x[2] : 1, ( nv > 3 ) ? x[3] : 0 );
+	    }
+	    else {
+	      a->I[k] = i;
+	      a->J[k] = j;
+	      if( a->X != NULL ) {
+	        a->X[k] = x[2];
+	      }
+	      if( a->Xi != NULL ) {
+	        a->Xi[k] = x[3];
+	      }
+	    }
+	  }
+	  k++;
+	}
+	return;
+}
+
+// Reads a Matrix Market file into a (whose arrays are allocated by
+// alloc, after the header is read into H and the entries counted),
+// and returns the text read (which must be set free) or NULL. The
+// whole file is read at once by txt_read, not streamed: the lines are
+// counted before the arrays are allocated, and then parsed in chunks
+// on the thread pool, so the text takes as much memory as the file.
+static char *mtx_read( char filename[], Mtx_head *H, Mtx_arg *a,
+                       int ( *alloc )( Mtx_head *H, Mtx_arg *a, void *arg ),
+                       void *arg ) {
+	int       c, nc, flag;
+	char      *path, *buf;
+	size_t    len;
+	long long at, k;
+
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( NULL );
+	}
+	buf = txt_read( path, &len );
+	free_chvec( &path );
+	if( buf == NULL ) {
+	  return( NULL );
+	}
+	at = mtx_head( buf, len, H );
+	if( at < 0 ) {
+	  free( buf );
+	  return( NULL );
+	}
+
+	nc = 1 + ( len - at ) / TXT_CHUNK;
+	a->s = buf + at;
+	a->H = H;
+	a->cut = ( size_t* ) malloc( ( nc + 1 ) * sizeof( size_t ) );
+	a->first = ( long long* ) malloc( nc * sizeof( long long ) );
+	a->err = ( int* ) calloc( nc, sizeof( int ) );
+	flag = ( a->cut == NULL || a->first == NULL || a->err == NULL ) ? -1 : 0;
+	if( flag == 0 ) {
+	  txt_cuts( a->s, len - at, nc, a->cut );
+	  tpool_for( nc, mtx_count, a );
+	  for( k = 0, c = 0; c < nc; c++ ) { // Entries before each chunk.
+	    k = k + a->first[c];
+	    a->first[c] = k - a->first[c];
+	  }
+	  flag = ( k == H->nnz ) ? alloc( H, a, arg ) : -1;
+	}
+	if( flag == 0 ) {
+	  tpool_for( nc, mtx_parse, a );
+	  for( c = 0; c < nc; c++ ) {
+	    flag = ( a->err[c] != 0 ) ? -1 : flag;
+	  }
+	}
+
+	free( a->cut );
+	free( a->first );
+	free( a->err );
+	if( flag != 0 ) {
+	  free( buf );
+	  return( NULL );
+	}
+	return( buf );
+}
+
+// Allocates the triplets of a coordinate file; arg is not NULL if the
+// imaginary parts are read.
+static int mtx_alloc_trip( Mtx_head *H, Mtx_arg *a, void *arg ) {
+	size_t nt;
+
+	nt = ( H->nnz > 0 ) ? H->nnz : 1;
+	a->A = a->Ai = NULL;
+	a->I = ( int* ) malloc( nt * sizeof( int ) );
+	a->J = ( int* ) malloc( nt * sizeof( int ) );
+	a->X = ( H->field == 'P' ) ? NULL : ( double* ) malloc( nt * sizeof( double ) );
+	a->Xi = ( H->field == 'C' && arg != NULL ) ? ( double* ) malloc( nt * sizeof( double ) )
+	                                            : NULL;
+	if( H->format != 'C' || H->nnz > INT32_MAX || a->I == NULL || a->J == NULL
+	    || ( H->field != 'P' && a->X == NULL )
+	    || ( H->field == 'C' && arg != NULL && a->Xi == NULL ) ) {
+	  return( -1 );
+	}
+	return( 0 );
+}
+
+/* This function reads a coordinate Matrix Market file inside the
+   folder "files" into a new sparse matrix A in the format 'R' or 'C'
+   (see trip_smat): the mirror of each element of a symmetric, skew-
+   symmetric or Hermitian matrix is made while the elements are
+   sorted, and repeated elements are summed. For a complex matrix, if
+   Ai is not NULL, a new vector *Ai gets the imaginary parts of the
+   elements, in the order of A->val (and *Ai is NULL for other
+   matrices); it must be set free by free_rvec. It returns -1 if the
+   file cannot be read, if it is not a valid coordinate file (an array
+   file may be read by mtx_get_rmat) or if memory is not available.
+*/
+int mtx_get_smat( char filename[], char format, Smat *A, double **Ai ) {
+	int      flag;
+	char     *buf;
+	Mtx_head H;
+	Mtx_arg  a;
+
+	a.I = a.J = NULL;
+	a.X = a.Xi = NULL;
+	if( Ai != NULL ) {
+	  *Ai = NULL;
+	}
+	buf = mtx_read( filename, &H, &a, mtx_alloc_trip, Ai );
+	flag = ( buf == NULL ) ? -1 : 0;
+	if( flag == 0 ) {
+	  flag = smat_build( H.n, H.m, ( int ) H.nnz, a.I, a.J, a.X, a.Xi, H.sym,
+	                     format, A, Ai );
+	}
+	else {
+	  A->n = A->m = A->nnz = 0;
+	  A->ptr = A->ind = NULL;
+	  A->val = NULL;
+	}
+	free( a.I );
+	free( a.J );
+	free( a.X );
+	free( a.Xi );
+	free( buf );
+	return( flag );
+}
+
+// Allocates the dense matrix of a file, and its imaginary parts if arg
+// is not NULL; the elements a coordinate file leaves out are zero.
+static int mtx_alloc_dense( Mtx_head *H, Mtx_arg *a, void *arg ) {
+	int  i;
+	Rmat *A = ( ( Rmat** ) arg )[0], *Ai = ( ( Rmat** ) arg )[1];
+
+	a->I = a->J = NULL;
+	a->X = a->Xi = NULL;
+	if( new_rmat( H->n, H->m, A ) != 0 ) {
+	  return( -1 );
+	}
+	a->A = A->row;
+	a->Ai = NULL;
+	if( Ai != NULL && H->field == 'C' ) {
+	  if( new_rmat( H->n, H->m, Ai ) != 0 ) {
+	    return( -1 );
+	  }
+	  a->Ai = Ai->row;
+	}
+	if( H->format == 'C' ) {
+	  zero_rmat( H->n, H->m, a->A );
+	  if( a->Ai != NULL ) {
+	    zero_rmat( H->n, H->m, a->Ai );
+	  }
+	}
+	for( i = 0; H->sym == 'K' && i < H->n; i++ ) { // Not in the file.
+	  a->A[i][i] = 0;
+	  if( a->Ai != NULL ) {
+	    a->Ai[i][i] = 0;
+	  }
+	}
+	return( 0 );
+}
+
+/* This function reads a Matrix Market file inside the folder "files",
+   coordinate or array, into a new dense matrix A (see new_rmat). The
+   elements go straight into A, and the mirror of each element of a
+   symmetric, skew-symmetric or Hermitian matrix too; the elements of a
+   pattern matrix are 1. An element must not be repeated. For a
+   complex matrix, if Ai is not NULL, a new matrix Ai gets the
+   imaginary parts (and Ai is left empty for other matrices). It
+   returns -1 if the file cannot be read, if it is not valid or if
+   memory is not available.
+*/
+int mtx_get_rmat( char filename[], Rmat *A, Rmat *Ai ) {
+	char     *buf;
+	Rmat     *R[2];
+	Mtx_head H;
+	Mtx_arg  a;
+
+	A->n = A->m = A->ld = A->own = 0;
+	A->val = NULL;
+	A->row = NULL;
+	if( Ai != NULL ) {
+	  *Ai = *A;
+	}
+	R[0] = A;
+	R[1] = Ai;
+	buf = mtx_read( filename, &H, &a, mtx_alloc_dense, R );
+	if( buf == NULL ) {
+	  del_rmat( A );
+	  if( Ai != NULL ) {
+	    del_rmat( Ai );
+	  }
+	  return( -1 );
+	}
+	free( buf );
+	return( 0 );
+}
+//=====================================================
+//	2.2. WRITING OF MATRIX MARKET FILES
+//=====================================================
+typedef struct {
+	Mtx_head H;
+	Smat     *S;		// Coordinate: the matrix...
+	double   *Si;		// ...and its imaginary parts.
+	double   **A, **Ai;	// Array: the matrix and its imaginary parts.
+	int      *cut;		// Block b: major vectors (columns) cut[b], ..., cut[b + 1] - 1.
+	int      b0;		// First block of this round.
+	char     **buf;		// One buffer per block of the round...
+	size_t   *len;		// ...and its length.
+} Mtx_out;
+
+// Writes the index i + 1, and a space, into s.
+static int mtx_index( int i, char *s ) {
+	int  k, nd;
+	char d[12];
+
+	i = i + 1;
+	nd = 0;
+	do {
+	  d[nd++] = '0' + i % 10;
+	  i = i / 10;
+	} while( i > 0 );
+	for( k = 0; k < nd; k++ ) {
+	  s[k] = d[nd - 1 - k];
+	}
+	s[nd] = ' ';
+	return( nd + 1 );
+}
+// 1 if the element (i,j) is written for a matrix of symmetry sym.
+static int mtx_keep( char sym, int i, int j ) {
+	return( sym == 'G' || i > j || ( i == j && sym != 'K' ) );
+}
+
+static void mtx_put_coo( int k, void *arg ) {
+	Mtx_out *a = ( Mtx_out* ) arg;
+	Smat    *S = a->S;
+	int     b, i, p, r, c;
+	char    *s;
+
+	b = a->b0 + k;
+	s = a->buf[k];
+	for( i = a->cut[b]; i < a->cut[b + 1]; i++ ) {
+	  for( p = S->ptr[i]; p < S->ptr[i + 1]; p++ ) {
+	    r = ( S->format == 'R' ) ? i : S->ind[p];
+	    c = ( S->format == 'R' ) ? S->ind[p] : i;
+	    if( !mtx_keep( a->H.sym, r, c ) ) {
+	      continue;
+	    }
+	    s = s + mtx_index( r, s );
+	    s = s + mtx_index( c, s );
+	    if( a->H.field != 'P' ) {
+	      s = s + fmt_double( S->val[p], 0, s );
+	      *s++ = ' ';
+	    }
+	    if( a->H.field == 'C' ) {
+	      s = s + fmt_double( a->Si[p], 0, s );
+	      *s++ = ' ';
+	    }
+	    s[-1] = '\n';
+	  }
+	}
+	a->len[k] = s - a->buf[k];
+	return;
+}
+static void mtx_put_array( int k, void *arg ) {
+	Mtx_out *a = ( Mtx_out* ) arg;
+	int     b, i, j;
+	char    *s;
+
+	b = a->b0 + k;
+	s = a->buf[k];
+	for( j = a->cut[b]; j < a->cut[b + 1]; j++ ) {
+	  for( i = 0; i < a->H.n; i++ ) {
+	    if( mtx_keep( a->H.sym, i, j ) ) {
+	      s = s + fmt_double( a->A[i][j], 0, s );
+	      if( a->H.field == 'C' ) {
+	        *s++ = ' ';
+	        s = s + fmt_double( a->Ai[i][j], 0, s );
+	      }
+	      *s++ = '\n';
+	    }
+	  }
+	}
+	a->len[k] = s - a->buf[k];
+	return;
+}
+
+// Writes the header of a->H and then the nb blocks of lines made by
+// task, of cap bytes at most each, into a file inside the folder
+// "files".
+static int mtx_write( char filename[], Mtx_out *a, int nb, size_t cap,
+                      void ( *task )( int k, void *arg ) ) {
+	static const char *format[] = { "coordinate", "array" };
+	static const char *field[] = { "real", "complex", "pattern" };
+	static const char *sym[] = { "general", "symmetric", "skew-symmetric",
+	                             "hermitian" };
+	FILE *file;
+	int  k, nbuf, flag;
+	char *path;
+
+	path = file_path( filename );
+	if( path == NULL ) {
+	  return( -1 );
+	}
+	file = fopen( path, "w" );
+	free_chvec( &path );
+	if( file == NULL ) {
+	  return( -1 );
+	}
+	fprintf( file, "%%%%MatrixMarket matrix %s %s %s\n",
+	         format[a->H.format == 'A'],
+	         field[( a->H.field == 'C' ) + 2 * ( a->H.field == 'P' )],
+	         sym[( a->H.sym == 'S' ) + 2 * ( a->H.sym == 'K' ) + 3 * ( a->H.sym == 'H' )] );
+	if( a->H.format == 'C' ) {
+	  fprintf( file, "%d %d %lld\n", a->H.n, a->H.m, a->H.nnz );
+	}
+	else {
+	  fprintf( file, "%d %d\n", a->H.n, a->H.m );
+	}
+
+	nbuf = tpool_par() ? 2 * tpool_size() : 1;
+	nbuf = ( nbuf < nb ) ? nbuf : ( nb > 0 ? nb : 1 );
+	flag = 0;
+	a->buf = ( char** ) calloc( nbuf, sizeof( char* ) );
+	a->len = ( size_t* ) malloc( nbuf * sizeof( size_t ) );
+	for( k = 0; a->buf != NULL && k < nbuf; k++ ) {
+	  a->buf[k] = ( char* ) malloc( cap + 1 );
+	  flag = ( a->buf[k] == NULL ) ? -1 : flag;
+	}
+	flag = ( a->buf == NULL || a->len == NULL ) ? -1 : flag;
+
+	for( a->b0 = 0; a->b0 < nb && flag == 0; a->b0 = a->b0 + nbuf ) {
+	  k = ( nb - a->b0 < nbuf ) ? nb - a->b0 : nbuf;
+	  tpool_for( k, task, a );
+	  for( k = 0; k < nbuf && a->b0 + k < nb && flag == 0; k++ ) {
+	    flag = ( fwrite( a->buf[k], 1, a->len[k], file ) == a->len[k] ) ? 0 : -1;
+	  }
+	}
+
+	for( k = 0; a->buf != NULL && k < nbuf; k++ ) {
+	  free( a->buf[k] );
+	}
+	free( a->buf );
+	free( a->len );
+	if( fclose( file ) != 0 ) {
+	  flag = -1;
+	}
+	return( flag );
+}
+
+/* This function writes a sparse matrix A into a coordinate Matrix
+   Market file inside the folder "files". The field is 'R' (real),
+   'C' (complex, whose imaginary parts Ai are in the order of A->val)
+   or 'P' (pattern: no value is written). If sym is 'S', 'K' or 'H',
+   A is taken as symmetric, skew-symmetric or Hermitian, and only its
+   lower triangle (strict, for 'K') is written; with 'G', all the
+   elements are. The numbers are in their shortest form (see
+   fmt_double). It returns -1 if some option is not valid or if the
+   file or the memory is not available.
+*/
+int mtx_out_smat( Smat *A, double *Ai, char field, char sym, char filename[] ) {
+	int     i, p, nb, b, cap;
+	Mtx_out a;
+
+	if( ( field != 'R' && field != 'C' && field != 'P' ) || ( field == 'C' && Ai == NULL )
+	    || ( sym != 'G' && sym != 'S' && sym != 'K' && sym != 'H' )
+	    || ( sym != 'G' && A->n != A->m ) ) {
+	  return( -1 );
+	}
+	a.H.n = A->n;
+	a.H.m = A->m;
+	a.H.format = 'C';
+	a.H.field = field;
+	a.H.sym = sym;
+	a.S = A;
+	a.Si = Ai;
+	a.H.nnz = 0;
+	for( i = 0; i < smat_major( A ); i++ ) {
+	  for( p = A->ptr[i]; p < A->ptr[i + 1]; p++ ) {
+	    a.H.nnz = a.H.nnz + mtx_keep( sym, ( A->format == 'R' ) ? i : A->ind[p],
+	                                  ( A->format == 'R' ) ? A->ind[p] : i );
+	  }
+	}
+
+	// Blocks of about MTX_BLOCK elements (see smat_split).
+	nb = 1 + ( A->nnz + smat_major( A ) ) / MTX_BLOCK;
+	a.cut = ( int* ) malloc( ( nb + 1 ) * sizeof( int ) );
+	if( a.cut == NULL ) {
+	  return( -1 );
+	}
+	cap = 0;
+	for( b = 0; b <= nb; b++ ) {
+	  a.cut[b] = smat_split( A, b, nb );
+	  if( b > 0 && A->ptr[a.cut[b]] - A->ptr[a.cut[b - 1]] > cap ) {
+	    cap = A->ptr[a.cut[b]] - A->ptr[a.cut[b - 1]];
+	  }
+	}
+	p = mtx_write( filename, &a, nb, ( size_t ) cap * MTX_LINE, mtx_put_coo );
+	free( a.cut );
+	return( p );
+}
+/* This function writes the n-X-m matrix A into an array Matrix Market
+   file inside the folder "files": real, or complex if the imaginary
+   parts Ai are not NULL. If sym is 'S', 'K' or 'H', A is taken as
+   symmetric, skew-symmetric or Hermitian, and only its lower triangle
+   (strict, for 'K') is written; with 'G', all the elements are. It
+   returns -1 if sym is not valid or if the file or the memory is not
+   available.
+*/
+int mtx_out_rmat( int n, int m, double **A, double **Ai, char sym, char filename[] ) {
+	int     b, nb, cols, flag;
+	Mtx_out a;
+
+	if( ( sym != 'G' && sym != 'S' && sym != 'K' && sym != 'H' )
+	    || ( sym != 'G' && n != m ) ) {
+	  return( -1 );
+	}
+	a.H.n = n;
+	a.H.m = m;
+	a.H.format = 'A';
+	a.H.field = ( Ai == NULL ) ? 'R' : 'C';
+	a.H.sym = sym;
+	a.H.nnz = 0;
+	a.A = A;
+	a.Ai = Ai;
+
+	// Blocks of about MTX_BLOCK elements, in whole columns.
+	cols = 1 + MTX_BLOCK / ( n > 0 ? n : 1 );
+	nb = ( m + cols - 1 ) / cols;
+	a.cut = ( int* ) malloc( ( nb + 1 ) * sizeof( int ) );
+	if( a.cut == NULL ) {
+	  return( -1 );
+	}
+	for( b = 0; b <= nb; b++ ) {
+	  a.cut[b] = ( b * cols < m ) ? b * cols : m;
+	}
+	flag = mtx_write( filename, &a, nb, ( size_t ) cols * n * MTX_LINE, mtx_put_array );
+	free( a.cut );
+	return( flag );
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+//	3. SPARSE CHOLESKY FACTORIZATION
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/* A sparse symmetric positive definite n-X-n matrix A is factorized as
+   P * A * transpose( P ) = L * transpose( L ) in two phases. The
+   symbolic phase (symb_schol) reads only the pattern of A: it finds
+   the permutation P, which reduces the fill of L, the elimination
+   tree of P * A * transpose( P ) and the pattern of L, grouped in
+   supernodes (runs of consecutive columns with the same pattern below
+   their diagonal block). The numeric phase (fact_schol) may then be
+   called for every matrix with the same pattern, as the steps of a
+   Newton iteration need, with no allocation and no search.
+
+   The numeric phase is multifrontal: the supernodes are visited in a
+   postorder of the tree, and each one assembles the elements of A in
+   its columns and the update matrices of its children into a dense
+   frontal matrix. The first columns of the front are factorized by
+   chol_rmat and trsm_rmat, and the Schur complement of the rest,
+   found by GEMM (chol_update), is the update matrix of the supernode,
+   kept on a stack until its parent is assembled. The work of large
+   fronts thus runs in the blocked (and threaded) dense kernels.
+*/
+//=====================================================
+//	3.1. NESTED DISSECTION ORDERING
+//=====================================================
+/* The graph of A (vertex i joined to j if A(i,j) or A(j,i) is not
+   zero) is split by a separator, a set of vertices whose removal
+   leaves two parts with no edge between them. The parts are ordered
+   first and the separator last, so the elimination of one part makes
+   no fill in the other, and the parts are split again until they have
+   fewer than ND_LEAF vertices. Each separator is the middle level of
+   a breadth-first search from a pseudo-peripheral vertex (the last
+   one reached by a search from the last one reached, ...), less the
+   vertices with no neighbour in the second part. On a k-X-k grid,
+   this gives O(n * log( n )) elements in L, instead of the O(n^1.5) of
+   a band ordering.
+*/
+#define ND_LEAF		64	// Parts with fewer vertices are not split.
+#define ND_SWEEPS	4	// Searches for a pseudo-peripheral vertex.
+
+typedef struct {
+	int *xadj, *adj;	// Neighbours of v: adj[xadj[v]], ..., adj[xadj[v + 1] - 1].
+	int *vtx;		// Vertices of the parts to split.
+	int *level;		// Level of each vertex in the last search.
+	int *tag;		// Part of each vertex.
+	int *queue;
+} Nd_graph;
+
+/* Pattern of A + transpose( A ) without its diagonal, as a CSR matrix
+   G. A must be square.
+*/
+static int nd_graph( Smat *A, Smat *G ) {
+	int p, k, nt, nmaj, flag, *I, *J;
+
+	nmaj = smat_major( A );
+	I = ( int* ) malloc( ( 2 * ( size_t ) A->nnz + 1 ) * sizeof( int ) );
+	J = ( int* ) malloc( ( 2 * ( size_t ) A->nnz + 1 ) * sizeof( int ) );
+	if( I == NULL || J == NULL ) {
+	  free( I );
+	  free( J );
+	  return( -1 );
+	}
+	nt = 0;
+	for( p = 0; p < nmaj; p++ ) {
+	  for( k = A->ptr[p]; k < A->ptr[p + 1]; k++ ) {
+	    if( A->ind[k] != p ) {
+	      I[nt] = J[nt + 1] = p;
+	      J[nt] = I[nt + 1] = A->ind[k];
+	      nt = nt + 2;
+	    }
+	  }
+	}
+	flag = trip_smat( A->n, A->n, nt, I, J, NULL, 'R', G );
+	free( I );
+	free( J );
+	return( flag );
+}
+/* Breadth-first search from root among the vertices tagged t, whose
+   levels must be -1. It returns the number of vertices reached, left
+   in queue by levels, and the last level in *depth.
+*/
+static int nd_bfs( Nd_graph *g, int root, int t, int *depth ) {
+	int head, tail, v, w, k;
+
+	g->level[root] = 0;
+	g->queue[0] = root;
+	tail = 1;
+	for( head = 0; head < tail; head++ ) {
+	  v = g->queue[head];
+	  for( k = g->xadj[v]; k < g->xadj[v + 1]; k++ ) {
+	    w = g->adj[k];
+	    if( g->tag[w] == t && g->level[w] < 0 ) {
+	      g->level[w] = g->level[v] + 1;
+	      g->queue[tail++] = w;
+	    }
+	  }
+	}
+	*depth = g->level[g->queue[tail - 1]];
+	return( tail );
+}
+/* Splits the vertices vtx[lo], ..., vtx[hi - 1] (tagged t) and sorts
+   them as the first part (*n1 vertices), the second part (*n2) and the
+   separator. A part which is not connected is split in two with no
+   separator. It returns -1 if the vertices are too close to be split.
+*/
+static int nd_split( Nd_graph *g, int lo, int hi, int t, int *n1, int *n2 ) {
+	int i, k, v, nv, cnt, depth, d, root, mid, a, b, c, *V;
+
+	V = g->vtx + lo;
+	nv = hi - lo;
+	for( i = 0; i < nv; i++ ) {
+	  g->tag[V[i]] = t;
+	}
+	root = V[0];
+	d = -1;
+	for( k = 0; k < ND_SWEEPS; k++ ) {
+	  for( i = 0; i < nv; i++ ) {
+	    g->level[V[i]] = -1;
+	  }
+	  cnt = nd_bfs( g, root, t, &depth );
+	  if( cnt < nv || depth <= d ) {
+	    break;
+	  }
+	  d = depth;
+	  root = g->queue[cnt - 1];
+	}
+	if( cnt == nv ) {
+	  if( depth < 2 ) {
+	    return( -1 );
+	  }
+	  // Separator: the level of the median vertex, moved inside.
+	  mid = g->level[g->queue[nv / 2]];
+	  mid = ( mid < 1 ) ? 1 : ( ( mid > depth - 1 ) ? depth - 1 : mid );
+	  for( i = 0; i < nv; i++ ) {
+	    v = g->queue[i];
+	    if( g->level[v] != mid ) {
+	      continue;
+	    }
+	    for( k = g->xadj[v]; k < g->xadj[v + 1]; k++ ) {
+	      if( g->tag[g->adj[k]] == t && g->level[g->adj[k]] == mid + 1 ) {
+	        break;
+	      }
+	    }
+	    if( k == g->xadj[v + 1] ) {
+	      g->level[v] = mid - 1;
+	    }
+	  }
+	}
+	else {
+	  // Unconnected: the vertices reached and the others.
+	  mid = -1;
+	  for( i = 0; i < nv; i++ ) {
+	    if( g->level[V[i]] < 0 ) {
+	      g->level[V[i]] = 0;
+	    }
+	    else {
+	      g->level[V[i]] = -2;
+	    }
+	  }
+	}
+	memcpy( g->queue, V, nv * sizeof( int ) );
+	a = 0;
+	for( i = 0; i < nv; i++ ) {
+	  if( g->level[g->queue[i]] < mid ) {
+	    V[a++] = g->queue[i];
+	  }
+	}
+	b = a;
+	for( i = 0; i < nv; i++ ) {
+	  if( g->level[g->queue[i]] > mid ) {
+	    V[b++] = g->queue[i];
+	  }
+	}
+	c = b;
+	for( i = 0; i < nv; i++ ) {
+	  if( g->level[g->queue[i]] == mid ) {
+	    V[c++] = g->queue[i];
+	  }
+	}
+	*n1 = a;
+	*n2 = b - a;
+	return( 0 );
+}
+/* Nested dissection of the graph G (see nd_graph): perm[k] is the
+   vertex eliminated in the k-th place. The parts are kept on a stack,
+   so the vertices of each part get consecutive places just before its
+   separator.
+*/
+static int nd_order( Smat *G, int *perm ) {
+	int      n, i, sp, lo, hi, last, t, n1, n2, *stk;
+	Nd_graph g;
+
+	n = G->n;
+	g.xadj = G->ptr;
+	g.adj = G->ind;
+	g.vtx = ( int* ) malloc( ( n + 1 ) * sizeof( int ) );
+	g.level = ( int* ) malloc( ( n + 1 ) * sizeof( int ) );
+	g.tag = ( int* ) malloc( ( n + 1 ) * sizeof( int ) );
+	g.queue = ( int* ) malloc( ( n + 1 ) * sizeof( int ) );
+	stk = ( int* ) malloc( ( 2 * ( size_t ) n + 2 ) * sizeof( int ) );
+	if( g.vtx == NULL || g.level == NULL || g.tag == NULL || g.queue == NULL
+	    || stk == NULL ) {
+	  free( g.vtx );
+	  free( g.level );
+	  free( g.tag );
+	  free( g.queue );
+	  free( stk );
+	  return( -1 );
+	}
+	for( i = 0; i < n; i++ ) {
+	  g.vtx[i] = i;
+	  g.tag[i] = -1;
+	}
+	last = n;
+	t = 0;
+	sp = 0;
+	if( n > 0 ) {
+	  stk[sp++] = 0;
+	  stk[sp++] = n;
+	}
+	while( sp > 0 ) {
+	  hi = stk[--sp];
+	  lo = stk[--sp];
+	  if( hi - lo < ND_LEAF || nd_split( &g, lo, hi, t++, &n1, &n2 ) != 0 ) {
+	    n1 = n2 = 0;
+	  }
+	  // The separator (or the whole leaf) takes the last free places.
+	  for( i = hi - 1; i >= lo + n1 + n2; i-- ) {
+	    perm[--last] = g.vtx[i];
+	  }
+	  if( n1 > 0 ) {
+	    stk[sp++] = lo;
+	    stk[sp++] = lo + n1;
+	  }
+	  if( n2 > 0 ) {
+	    stk[sp++] = lo + n1;
+	    stk[sp++] = lo + n1 + n2;
+	  }
+	}
+	free( g.vtx );
+	free( g.level );
+	free( g.tag );
+	free( g.queue );
+	free( stk );
+	return( 0 );
+}
+/* This function finds a fill-reducing ordering of the square sparse
+   matrix A by nested dissection: perm[k] is the row (and column) of A
+   put in the k-th place. It returns -1 if A is not square or if memory
+   is not available.
+*/
+int nd_smat( Smat *A, int *perm ) {
+	int  flag;
+	Smat G;
+
+	if( A->n != A->m ) {
+	  return( -1 );
+	}
+	if( nd_graph( A, &G ) != 0 ) {
+	  return( -1 );
+	}
+	flag = nd_order( &G, perm );
+	free_smat( &G );
+	return( flag );
+}
+//=====================================================
+//	3.2. SYMBOLIC ANALYSIS
+//=====================================================
+/* The elimination tree has the parent of column j in the first row
+   below the diagonal of column j of L; the pattern of row i of L is
+   the subtree from the columns of row i of A up to i, so the column
+   counts are found by walking these subtrees. After a postorder of the
+   tree, a fundamental supernode is a chain of columns j, j + 1, ...,
+   each one the only child of the next, with one element less in each
+   column. The rows of a supernode are its columns, the rows of A below
+   them and the rows of its children's update matrices.
+
+   Supernode s keeps its nr rows (indices of P * A * transpose( P ))
+   and its nc columns as a dense nr-X-nc block of L, by rows, whose
+   first nc rows hold the lower triangle of its diagonal block. The
+   place of each element of A in its front is also found here, so the
+   numeric phase only adds values.
+*/
+typedef struct {
+	int       n;		// Order of A.
+	int       nnz;		// Number of elements of the pattern of A.
+	int       *perm;	// Row k of P * A * transpose( P ) is row perm[k] of A.
+	int       *iperm;	// Inverse of perm.
+	int       ns;		// Number of supernodes.
+	int       *sup;		// First column of each supernode, and n.
+	int       *sparent;	// Parent of each supernode (-1 for a root).
+	int       *rptr, *rind;	// Rows of s: rind[rptr[s]], ..., increasing.
+	long long *lptr;	// Block of s: L + lptr[s], and nnz( L ).
+	double    *L;
+	int       *aptr, *aind;	// Elements of A assembled by s: A->val[aind[aptr[s]]], ...
+	long long *apos;	// Their places in the front.
+	int       maxf;		// Order of the largest front.
+	long long stk;		// Size of the stack of update matrices.
+	double    *F, *U;	// Front and stack.
+	double    **R;		// Rows of the front.
+	int       *map;		// Place of each row in the front.
+	int       *sid;		// Supernodes on the stack...
+	long long *soff;	// ...and their update matrices.
+} Schol;
+
+// Comparison of two indices, for qsort.
+static int schol_cmp( const void *a, const void *b ) {
+	return( ( *( const int* ) a > *( const int* ) b )
+	        - ( *( const int* ) a < *( const int* ) b ) );
+}
+/* Elimination tree of P * A * transpose( P ), whose graph is G, by
+   Liu's algorithm: anc keeps the root found so far from each column,
+   with path compression.
+*/
+static void schol_etree( Smat *G, int *perm, int *iperm, int *parent, int *anc ) {
+	int i, k, p, next;
+
+	for( k = 0; k < G->n; k++ ) {
+	  parent[k] = anc[k] = -1;
+	  for( p = G->ptr[perm[k]]; p < G->ptr[perm[k] + 1]; p++ ) {
+	    for( i = iperm[G->ind[p]]; i != -1 && i < k; i = next ) {
+	      next = anc[i];
+	      anc[i] = k;
+	      if( next == -1 ) {
+	        parent[i] = k;
+	      }
+	    }
+	  }
+	}
+	return;
+}
+/* Postorder of the tree given by parent: post[j] is the j-th node
+   visited. The children of each node are visited in increasing order.
+*/
+static void schol_post( int n, int *parent, int *post, int *head, int *next, int *stk ) {
+	int j, k, v, sp;
+
+	for( j = 0; j < n; j++ ) {
+	  head[j] = -1;
+	}
+	for( j = n - 1; j >= 0; j-- ) {
+	  if( parent[j] != -1 ) {
+	    next[j] = head[parent[j]];
+	    head[parent[j]] = j;
+	  }
+	}
+	k = 0;
+	for( j = 0; j < n; j++ ) {
+	  if( parent[j] != -1 ) {
+	    continue;
+	  }
+	  sp = 0;
+	  stk[sp++] = j;
+	  while( sp > 0 ) {
+	    v = stk[sp - 1];
+	    if( head[v] == -1 ) {
+	      sp--;
+	      post[k++] = v;
+	    }
+	    else {
+	      stk[sp++] = head[v];
+	      head[v] = next[head[v]];
+	    }
+	  }
+	}
+	return;
+}
+/* This function sets free the factorization F of a sparse matrix.
+*/
+int free_schol( Schol *F ) {
+	free( F->perm );
+	free( F->iperm );
+	free( F->sup );
+	free( F->sparent );
+	free( F->rptr );
+	free( F->rind );
+	free( F->lptr );
+	free( F->L );
+	free( F->aptr );
+	free( F->aind );
+	free( F->apos );
+	free( F->F );
+	free( F->U );
+	free( F->R );
+	free( F->map );
+	free( F->sid );
+	free( F->soff );
+	memset( F, 0, sizeof( Schol ) );
+
+	return( 0 );
+}
+/* Permutation P (a postorder of the elimination tree composed into
+   F->perm), supernodes of L and their parents, and number of rows of
+   each supernode in F->rptr. w has room for 5 * n integers, of which
+   the supernode of each column is left in the first n.
+*/
+static int schol_tree( Smat *G, Schol *F, int *w ) {
+	int n, i, j, k, s, *parent, *cc, *w1, *w2, *w3;
+
+	n = F->n;
+	parent = w + n;
+	cc = w + 2 * n;
+	w1 = w + 3 * n;
+	w2 = w + 4 * n;
+	w3 = w;
+	for( i = 0; i < n; i++ ) {
+	  w1[i] = -1;
+	}
+	for( k = 0; k < n; k++ ) {
+	  if( F->perm[k] < 0 || F->perm[k] >= n || w1[F->perm[k]] != -1 ) {
+	    return( -1 );	// F->perm is not a permutation.
+	  }
+	  w1[F->perm[k]] = k;
+	}
+	memcpy( F->iperm, w1, n * sizeof( int ) );
+
+	// Elimination tree, and its postorder composed into P.
+	schol_etree( G, F->perm, F->iperm, parent, w1 );
+	schol_post( n, parent, cc, w1, w2, w3 );
+	for( k = 0; k < n; k++ ) {
+	  w1[k] = F->perm[cc[k]];
+	  w2[cc[k]] = k;
+	}
+	for( k = 0; k < n; k++ ) {
+	  w3[k] = ( parent[cc[k]] == -1 ) ? -1 : w2[parent[cc[k]]];
+	}
+	memcpy( F->perm, w1, n * sizeof( int ) );
+	memcpy( parent, w3, n * sizeof( int ) );
+	for( k = 0; k < n; k++ ) {
+	  F->iperm[F->perm[k]] = k;
+	}
+
+	// Column counts, by the row subtrees, and numbers of children.
+	for( k = 0; k < n; k++ ) {
+	  cc[k] = 1;
+	  w1[k] = -1;
+	  w2[k] = 0;
+	}
+	for( i = 0; i < n; i++ ) {
+	  w1[i] = i;
+	  for( k = G->ptr[F->perm[i]]; k < G->ptr[F->perm[i] + 1]; k++ ) {
+	    for( j = F->iperm[G->ind[k]]; j < i && w1[j] != i; j = parent[j] ) {
+	      cc[j]++;
+	      w1[j] = i;
+	    }
+	  }
+	  if( parent[i] != -1 ) {
+	    w2[parent[i]]++;
+	  }
+	}
+
+	// Fundamental supernodes.
+	F->ns = 0;
+	for( j = 0; j < n; j++ ) {
+	  if( j == 0 || parent[j - 1] != j || cc[j - 1] != cc[j] + 1 || w2[j] != 1 ) {
+	    w1[F->ns++] = j;
+	  }
+	}
+	F->sup = ( int* ) malloc( ( F->ns + 1 ) * sizeof( int ) );
+	F->sparent = ( int* ) malloc( ( F->ns + 1 ) * sizeof( int ) );
+	F->rptr = ( int* ) malloc( ( F->ns + 1 ) * sizeof( int ) );
+	if( F->sup == NULL || F->sparent == NULL || F->rptr == NULL ) {
+	  return( -1 );
+	}
+	memcpy( F->sup, w1, F->ns * sizeof( int ) );
+	F->sup[F->ns] = n;
+	F->rptr[0] = 0;
+	F->maxf = 0;
+	for( s = 0; s < F->ns; s++ ) {
+	  for( j = F->sup[s]; j < F->sup[s + 1]; j++ ) {
+	    w3[j] = s;
+	  }
+	  if( cc[F->sup[s]] > INT32_MAX - F->rptr[s] ) {
+	    return( -1 );
+	  }
+	  F->rptr[s + 1] = F->rptr[s] + cc[F->sup[s]];
+	  F->maxf = ( cc[F->sup[s]] > F->maxf ) ? cc[F->sup[s]] : F->maxf;
+	}
+	for( s = 0; s < F->ns; s++ ) {
+	  j = parent[F->sup[s + 1] - 1];
+	  F->sparent[s] = ( j == -1 ) ? -1 : w3[j];
+	}
+	return( 0 );
+}
+/* Rows of each supernode, places of the elements of A in the fronts
+   and size of the stack of update matrices, once schol_tree has found
+   the supernodes. snode is the supernode of each column, and mark,
+   head and next have room for n integers.
+*/
+static int schol_rows( Smat *A, Smat *G, Schol *F, int *snode, int *mark,
+                       int *head, int *next ) {
+	int       s, c, i, j, k, p, q, r, nr, nc, d, lo, hi, nmaj, *rows;
+	long long cur;
+
+	F->rind = ( int* ) malloc( ( F->rptr[F->ns] + 1 ) * sizeof( int ) );
+	F->lptr = ( long long* ) malloc( ( F->ns + 1 ) * sizeof( long long ) );
+	F->aptr = ( int* ) calloc( F->ns + 1, sizeof( int ) );
+	F->aind = ( int* ) malloc( ( F->nnz + 1 ) * sizeof( int ) );
+	F->apos = ( long long* ) malloc( ( F->nnz + 1 ) * sizeof( long long ) );
+	if( F->rind == NULL || F->lptr == NULL || F->aptr == NULL
+	    || F->aind == NULL || F->apos == NULL ) {
+	  return( -1 );
+	}
+
+	// Rows: the columns of s, then A below them, then the children.
+	for( i = 0; i < F->n; i++ ) {
+	  mark[i] = head[i] = -1;
+	}
+	for( s = 0; s < F->ns; s++ ) {
+	  rows = F->rind + F->rptr[s];
+	  nr = 0;
+	  for( j = F->sup[s]; j < F->sup[s + 1]; j++ ) {
+	    mark[j] = s;
+	    rows[nr++] = j;
+	  }
+	  for( j = F->sup[s]; j < F->sup[s + 1]; j++ ) {
+	    for( p = G->ptr[F->perm[j]]; p < G->ptr[F->perm[j] + 1]; p++ ) {
+	      i = F->iperm[G->ind[p]];
+	      if( i > j && mark[i] != s ) {
+	        mark[i] = s;
+	        rows[nr++] = i;
+	      }
+	    }
+	  }
+	  for( c = head[s]; c != -1; c = next[c] ) {
+	    nc = F->sup[c + 1] - F->sup[c];
+	    for( k = F->rptr[c] + nc; k < F->rptr[c + 1]; k++ ) {
+	      if( mark[F->rind[k]] != s ) {
+	        mark[F->rind[k]] = s;
+	        rows[nr++] = F->rind[k];
+	      }
+	    }
+	  }
+	  if( nr != F->rptr[s + 1] - F->rptr[s] ) {
+	    return( -1 );
+	  }
+	  qsort( rows, nr, sizeof( int ), schol_cmp );
+	  if( F->sparent[s] != -1 ) {
+	    next[s] = head[F->sparent[s]];
+	    head[F->sparent[s]] = s;
+	  }
+	}
+
+	// Blocks of L.
+	F->lptr[0] = 0;
+	for( s = 0; s < F->ns; s++ ) {
+	  F->lptr[s + 1] = F->lptr[s] + ( long long ) ( F->rptr[s + 1] - F->rptr[s] )
+	                   * ( F->sup[s + 1] - F->sup[s] );
+	}
+
+	// Elements of the lower triangle of A, by supernodes (counting sort).
+	nmaj = smat_major( A );
+	for( k = 0; k < 2; k++ ) {
+	  for( p = 0; p < nmaj; p++ ) {
+	    for( q = A->ptr[p]; q < A->ptr[p + 1]; q++ ) {
+	      r = ( A->format == 'R' ) ? p : A->ind[q];
+	      c = ( A->format == 'R' ) ? A->ind[q] : p;
+	      if( r < c ) {
+	        continue;
+	      }
+	      i = F->iperm[r];
+	      j = F->iperm[c];
+	      if( i < j ) {
+	        d = i;
+	        i = j;
+	        j = d;
+	      }
+	      s = snode[j];
+	      if( k == 0 ) {
+	        F->aptr[s + 1]++;
+	        continue;
+	      }
+	      // Place of row i in the rows of s.
+	      lo = F->rptr[s];
+	      hi = F->rptr[s + 1];
+	      while( hi - lo > 1 ) {
+	        d = ( lo + hi ) / 2;
+	        if( F->rind[d] <= i ) {
+	          lo = d;
+	        }
+	        else {
+	          hi = d;
+	        }
+	      }
+	      nr = F->rptr[s + 1] - F->rptr[s];
+	      F->aind[mark[s]] = q;
+	      F->apos[mark[s]++] = ( long long ) ( lo - F->rptr[s] ) * nr + j - F->sup[s];
+	    }
+	  }
+	  for( s = 0; k == 0 && s < F->ns; s++ ) {
+	    F->aptr[s + 1] = F->aptr[s + 1] + F->aptr[s];
+	    mark[s] = F->aptr[s];
+	  }
+	}
+
+	// Largest stack of update matrices, in the order of fact_schol.
+	d = 0;
+	cur = F->stk = 0;
+	for( s = 0; s < F->ns; s++ ) {
+	  while( d > 0 && F->sparent[mark[d - 1]] == s ) {
+	    d--;
+	    nc = F->sup[mark[d] + 1] - F->sup[mark[d]];
+	    nr = F->rptr[mark[d] + 1] - F->rptr[mark[d]];
+	    cur = cur - ( long long ) ( nr - nc ) * ( nr - nc );
+	  }
+	  if( F->sparent[s] != -1 ) {
+	    nc = F->sup[s + 1] - F->sup[s];
+	    nr = F->rptr[s + 1] - F->rptr[s];
+	    mark[d++] = s;
+	    cur = cur + ( long long ) ( nr - nc ) * ( nr - nc );
+	    F->stk = ( cur > F->stk ) ? cur : F->stk;
+	  }
+	}
+	return( 0 );
+}
+/* This function makes the symbolic factorization F of the n-X-n sparse
+   symmetric matrix A (see the beginning of this section): the ordering
+   P, given by perm[k] = row of A put in the k-th place, or found by
+   nested dissection (see nd_smat) if perm is NULL, the elimination
+   tree (whose postorder is composed into P) and the supernodes of L,
+   with all the memory of fact_schol. Only the pattern of A is read,
+   and F serves any matrix with the same pattern (the same ptr and
+   ind). F must be set free by free_schol. It returns -1 if A is not
+   square, if perm is not a permutation or if memory is not available.
+*/
+int symb_schol( Smat *A, int *perm, Schol *F ) {
+	int  n, flag, *w;
+	Smat G;
+
+	memset( F, 0, sizeof( Schol ) );
+	if( A->n != A->m || ( A->format != 'R' && A->format != 'C' ) ) {
+	  return( -1 );
+	}
+	n = F->n = A->n;
+	F->nnz = A->ptr[smat_major( A )];
+	if( nd_graph( A, &G ) != 0 ) {
+	  return( -1 );
+	}
+	F->perm = ( int* ) malloc( ( n + 1 ) * sizeof( int ) );
+	F->iperm = ( int* ) malloc( ( n + 1 ) * sizeof( int ) );
+	w = ( int* ) malloc( ( 5 * ( size_t ) n + 1 ) * sizeof( int ) );
+	flag = ( F->perm == NULL || F->iperm == NULL || w == NULL ) ? -1 : 0;
+	if( flag == 0 && perm != NULL ) {
+	  memcpy( F->perm, perm, n * sizeof( int ) );
+	}
+	else if( flag == 0 ) {
+	  flag = nd_order( &G, F->perm );
+	}
+	if( flag == 0 ) {
+	  flag = schol_tree( &G, F, w );
+	}
+	if( flag == 0 ) {
+	  flag = schol_rows( A, &G, F, w, w + n, w + 2 * n, w + 3 * n );
+	}
+	free_smat( &G );
+	free( w );
+
+	// Memory of the numeric phase.
+	if( flag == 0 ) {
+	  F->L = ( double* ) malloc( ( F->lptr[F->ns] + 1 ) * sizeof( double ) );
+	  F->F = ( double* ) malloc( ( ( size_t ) F->maxf * F->maxf + 1 ) * sizeof( double ) );
+	  F->U = ( double* ) malloc( ( F->stk + 1 ) * sizeof( double ) );
+	  F->R = ( double** ) malloc( ( F->maxf + 1 ) * sizeof( double* ) );
+	  F->map = ( int* ) malloc( ( n + 1 ) * sizeof( int ) );
+	  F->sid = ( int* ) malloc( ( F->ns + 1 ) * sizeof( int ) );
+	  F->soff = ( long long* ) malloc( ( F->ns + 1 ) * sizeof( long long ) );
+	  flag = ( F->L == NULL || F->F == NULL || F->U == NULL || F->R == NULL
+	           || F->map == NULL || F->sid == NULL || F->soff == NULL ) ? -1 : 0;
+	}
+	if( flag != 0 ) {
+	  free_schol( F );
+	  return( -1 );
+	}
+	return( 0 );
+}
+//=====================================================
+//	3.3. NUMERIC FACTORIZATION AND SOLUTION
+//=====================================================
+/* This function makes the numeric factorization of the sparse
+   symmetric positive definite matrix A into F, which must hold the
+   symbolic factorization of a matrix with the pattern of A (see
+   symb_schol). Only the lower triangle of A is read, so A may keep
+   both triangles or the lower one alone. It may be called again for
+   new values of A, with no allocation. It returns -1 if A is not
+   positive definite or if its pattern does not match F.
+*/
+int fact_schol( Smat *A, Schol *F ) {
+	int       s, c, i, j, k, nr, nc, nu, cr, cn, d, *rows, *crow;
+	long long top;
+	double    *U, **R;
+
+	if( A->n != F->n || A->ptr[smat_major( A )] != F->nnz ) {
+	  return( -1 );
+	}
+	R = F->R;
+	d = 0;
+	top = 0;
+	for( s = 0; s < F->ns; s++ ) {
+	  nc = F->sup[s + 1] - F->sup[s];
+	  nr = F->rptr[s + 1] - F->rptr[s];
+	  nu = nr - nc;
+	  rows = F->rind + F->rptr[s];
+
+	  // Front: the elements of A and the update matrices of the children.
+	  memset( F->F, 0, ( size_t ) nr * nr * sizeof( double ) );
+	  for( i = 0; i < nr; i++ ) {
+	    R[i] = F->F + ( size_t ) i * nr;
+	    F->map[rows[i]] = i;
+	  }
+	  for( k = F->aptr[s]; k < F->aptr[s + 1]; k++ ) {
+	    F->F[F->apos[k]] = F->F[F->apos[k]] + A->val[F->aind[k]];
+	  }
+	  while( d > 0 && F->sparent[F->sid[d - 1]] == s ) {
+	    d--;
+	    c = F->sid[d];
+	    cn = F->rptr[c + 1] - F->rptr[c] - ( F->sup[c + 1] - F->sup[c] );
+	    crow = F->rind + F->rptr[c + 1] - cn;
+	    U = F->U + F->soff[d];
+	    for( i = 0; i < cn; i++ ) {
+	      cr = F->map[crow[i]];
+	      for( j = 0; j <= i; j++ ) {
+	        R[cr][F->map[crow[j]]] = R[cr][F->map[crow[j]]] + U[( size_t ) i * cn + j];
+	      }
+	    }
+	    top = F->soff[d];
+	  }
+
+	  // Partial factorization: L11, L21 and the Schur complement.
+	  if( chol_rmat( nc, R ) != 0 ) {
+	    return( -1 );
+	  }
+	  if( nu > 0 ) {
+	    if( trsm_rmat( 'R', 'L', 'T', 'N', nu, nc, R, R + nc ) != 0 ) {
+	      return( -1 );
+	    }
+	    chol_update( nc, nr, nc, nr, 0, nc, R );
+	  }
+	  for( i = 0; i < nr; i++ ) {
+	    memcpy( F->L + F->lptr[s] + ( size_t ) i * nc, R[i], nc * sizeof( double ) );
+	  }
+	  if( nu > 0 && F->sparent[s] != -1 ) {
+	    U = F->U + top;
+	    for( i = 0; i < nu; i++ ) {
+	      memcpy( U + ( size_t ) i * nu, R[nc + i] + nc, ( i + 1 ) * sizeof( double ) );
+	    }
+	    F->sid[d] = s;
+	    F->soff[d++] = top;
+	    top = top + ( long long ) nu * nu;
+	  }
+	}
+	return( 0 );
+}
+/* Solution of L * transpose( L ) * Y = X, where row i of the n-X-k
+   matrix X is X[i] (a row of B in the order of P).
+*/
+static void schol_solve( Schol *F, int k, double **X ) {
+	int    s, i, j, l, q, nr, nc, c0, *rows;
+	double a, *x, *y, *Ls;
+
+	for( s = 0; s < F->ns; s++ ) {
+	  c0 = F->sup[s];
+	  nc = F->sup[s + 1] - c0;
+	  nr = F->rptr[s + 1] - F->rptr[s];
+	  rows = F->rind + F->rptr[s];
+	  Ls = F->L + F->lptr[s];
+	  for( j = 0; j < nc; j++ ) {
+	    y = X[c0 + j];
+	    for( l = 0; l < j; l++ ) {
+	      a = Ls[( size_t ) j * nc + l];
+	      x = X[c0 + l];
+	      for( q = 0; q < k; q++ ) {
+	        y[q] = y[q] - a * x[q];
+	      }
+	    }
+	    a = 1 / Ls[( size_t ) j * nc + j];
+	    for( q = 0; q < k; q++ ) {
+	      y[q] = a * y[q];
+	    }
+	  }
+	  for( i = nc; i < nr; i++ ) {
+	    y = X[rows[i]];
+	    for( l = 0; l < nc; l++ ) {
+	      a = Ls[( size_t ) i * nc + l];
+	      x = X[c0 + l];
+	      for( q = 0; q < k; q++ ) {
+	        y[q] = y[q] - a * x[q];
+	      }
+	    }
+	  }
+	}
+	for( s = F->ns - 1; s >= 0; s-- ) {
+	  c0 = F->sup[s];
+	  nc = F->sup[s + 1] - c0;
+	  nr = F->rptr[s + 1] - F->rptr[s];
+	  rows = F->rind + F->rptr[s];
+	  Ls = F->L + F->lptr[s];
+	  for( j = nc - 1; j >= 0; j-- ) {
+	    y = X[c0 + j];
+	    for( i = j + 1; i < nr; i++ ) {
+	      a = Ls[( size_t ) i * nc + j];
+	      x = X[rows[i]];
+	      for( q = 0; q < k; q++ ) {
+	        y[q] = y[q] - a * x[q];
+	      }
+	    }
+	    a = 1 / Ls[( size_t ) j * nc + j];
+	    for( q = 0; q < k; q++ ) {
+	      y[q] = a * y[q];
+	    }
+	  }
+	}
+	return;
+}
+/* This function solves A * X = B for a n-X-k matrix B, which is
+   overwritten by X, using the factorization of A made by fact_schol.
+   The permutation is applied to the row pointers of B, not to its
+   elements. It returns -1 if memory is not available.
+*/
+int solve_schol( Schol *F, int k, double **B ) {
+	int    i;
+	double **X;
+
+	X = ( double** ) malloc( ( F->n + 1 ) * sizeof( double* ) );
+	if( X == NULL ) {
+	  return( -1 );
+	}
+	for( i = 0; i < F->n; i++ ) {
+	  X[i] = B[F->perm[i]];
+	}
+	schol_solve( F, k, X );
+	free( X );
+	return( 0 );
+}
+/* This function solves A * x = b for a single n-dimensional vector b,
+   which is overwritten by x, using the factorization of A made by
+   fact_schol. It returns -1 if memory is not available.
+*/
+int vsolve_schol( Schol *F, double *b ) {
+	int    i;
+	double **X;
+
+	X = ( double** ) malloc( ( F->n + 1 ) * sizeof( double* ) );
+	if( X == NULL ) {
+	  return( -1 );
+	}
+	for( i = 0; i < F->n; i++ ) {
+	  X[i] = b + F->perm[i];
+	}
+	schol_solve( F, 1, X );
+	free( X );
+	return( 0 );
+}
+
+/*
+// Writes an n-X-m array file (symmetric if sym is 'S') and reads it
+// back, for sizes whose text spans several TXT_CHUNK chunks.
+static int mtx_check( int n, int m, char sym ) {
+	int  i, j, flag;
+	Rmat A, B;
+
+	if( new_rmat( n, m, &A ) != 0 ) {
+	  return( -1 );
+	}
+	for( i = 0; i < n; i++ ) {
+	  for( j = 0; j < m; j++ ) {
+	    A.row[i][j] = ( sym == 'S' ) ? ( i + j ) + 0.5 * abs( i - j ) : i - 0.5 * j;
+	  }
+	}
+	flag = mtx_out_rmat( n, m, A.row, NULL, sym, "check.mtx" );
+	flag = ( flag == 0 ) ? mtx_get_rmat( "check.mtx", &B, NULL ) : -1;
+	if( flag == 0 ) {
+	  flag = ( B.n != n || B.m != m ) ? -1 : 0;
+	  for( i = 0; flag == 0 && i < n; i++ ) {
+	    flag = memcmp( A.row[i], B.row[i], m * sizeof( double ) ) ? -1 : 0;
+	  }
+	  del_rmat( &B );
+	}
+	del_rmat( &A );
+	return( flag );
+}
+
+int main() {
+	tpool_init( 0 );
+	// Wide, tall and symmetric array files, several chunks each.
+	if( mtx_check( 2, 600000, 'G' ) != 0 || mtx_check( 600000, 2, 'G' ) != 0
+	    || mtx_check( 1500, 1500, 'S' ) != 0 ) {
+	  return( 1 );
+	}
+	return( 0 );
+}
+*/